@@ -0,0 +1,208 @@
+// Copyright 2026 Global Phasing Ltd.
+
+// End-to-end throughput of reading and writing files, on synthetic data.
+// Run with --benchmark_format=json (or --benchmark_out=FILE) to get results
+// that can be compared between commits (e.g. with compare.py from the
+// Google Benchmark repository).
+
+#include <cstdio>   // for remove
+#include <vector>
+#include "gemmi/binfile.hpp"  // for write_binary_structure, read_binary_structure
+#include "gemmi/ccp4.hpp"
+#include "gemmi/cif.hpp"      // for read_memory
+#include "gemmi/fileutil.hpp" // for read_file_into_buffer
+#include "gemmi/input.hpp"    // for MemoryStream
+#include "gemmi/json.hpp"     // for read_mmjson_insitu
+#include "gemmi/mmcif.hpp"    // for make_structure_from_block, make_structure_from_mmjson_insitu
+#include "gemmi/pdb.hpp"      // for read_pdb_string
+#include "gemmi/to_json.hpp"  // for write_mmjson_to_stream, write_structure_as_mmjson
+#include "gemmi/to_pdb.hpp"   // for make_pdb_string
+#include "synthetic.h"
+#include <benchmark/benchmark.h>
+
+namespace cif = gemmi::cif;
+
+static gemmi::Structure structure;
+static std::string mmcif_text;
+static std::string mmjson_text;
+static std::string pdb_text;
+static cif::Document mmcif_doc;
+static gemmi::Mtz mtz;
+static std::string mtz_bytes;
+static gemmi::Ccp4<float> ccp4;
+static std::string ccp4_bytes;
+static const char* ccp4_path = "gemmi-bm-tmp.ccp4";
+static const char* bin_path = "gemmi-bm-tmp.bin";
+static size_t bin_size;
+
+static void set_bytes(benchmark::State& state, size_t bytes) {
+  state.SetBytesProcessed(int64_t(state.iterations() * bytes));
+}
+
+static void cif_parse(benchmark::State& state) {
+  for (auto _ : state) {
+    cif::Document doc = cif::read_memory(mmcif_text.data(), mmcif_text.size(), "synth");
+    benchmark::DoNotOptimize(doc);
+  }
+  set_bytes(state, mmcif_text.size());
+}
+
+// includes copying the text, because the parser modifies the buffer
+static void mmjson_parse(benchmark::State& state) {
+  std::vector<char> buf(mmjson_text.size());
+  for (auto _ : state) {
+    std::copy(mmjson_text.begin(), mmjson_text.end(), buf.begin());
+    cif::Document doc = cif::read_mmjson_insitu(buf.data(), buf.size(), "synth");
+    benchmark::DoNotOptimize(doc);
+  }
+  set_bytes(state, mmjson_text.size());
+}
+
+// read_mmjson_insitu() + make_structure() vs direct reading of _atom_site
+static void mmjson_to_structure(benchmark::State& state) {
+  bool direct = state.range(0) != 0;
+  std::vector<char> buf(mmjson_text.size());
+  for (auto _ : state) {
+    std::copy(mmjson_text.begin(), mmjson_text.end(), buf.begin());
+    gemmi::Structure st = direct
+      ? gemmi::make_structure_from_mmjson_insitu(buf.data(), buf.size(), "synth")
+      : gemmi::make_structure(cif::read_mmjson_insitu(buf.data(), buf.size(), "synth"));
+    benchmark::DoNotOptimize(st);
+  }
+  set_bytes(state, mmjson_text.size());
+}
+
+// reading Structure from gemmi binary file (memory-mapped)
+static void binary_read(benchmark::State& state) {
+  for (auto _ : state) {
+    gemmi::Structure st = gemmi::read_binary_structure(bin_path);
+    benchmark::DoNotOptimize(st);
+  }
+  set_bytes(state, bin_size);
+}
+
+static void pdb_parse(benchmark::State& state) {
+  for (auto _ : state) {
+    gemmi::Structure st = gemmi::read_pdb_string(pdb_text, "synth");
+    benchmark::DoNotOptimize(st);
+  }
+  set_bytes(state, pdb_text.size());
+}
+
+static void make_structure_from_block(benchmark::State& state) {
+  for (auto _ : state) {
+    gemmi::Structure st = gemmi::make_structure_from_block(mmcif_doc.blocks.at(0));
+    benchmark::DoNotOptimize(st);
+  }
+  state.SetItemsProcessed(state.iterations() * gemmi::count_atom_sites(structure));
+}
+
+static void write_mmcif(benchmark::State& state) {
+  for (auto _ : state) {
+    std::string text = make_mmcif_string(structure);
+    benchmark::DoNotOptimize(text);
+  }
+  set_bytes(state, mmcif_text.size());
+}
+
+// make_mmcif_document() + write_mmjson_to_stream() vs write_structure_as_mmjson()
+static void write_mmjson(benchmark::State& state) {
+  bool direct = state.range(0) != 0;
+  for (auto _ : state) {
+    std::ostringstream os;
+    if (direct)
+      gemmi::write_structure_as_mmjson(os, structure);
+    else
+      cif::write_mmjson_to_stream(os, gemmi::make_mmcif_document(structure));
+    benchmark::DoNotOptimize(os);
+  }
+  set_bytes(state, mmjson_text.size());
+}
+
+static void write_pdb(benchmark::State& state) {
+  for (auto _ : state) {
+    std::string text = gemmi::make_pdb_string(structure);
+    benchmark::DoNotOptimize(text);
+  }
+  set_bytes(state, pdb_text.size());
+}
+
+static void mtz_read(benchmark::State& state) {
+  for (auto _ : state) {
+    gemmi::Mtz m;
+    gemmi::MemoryStream stream(mtz_bytes.data(), mtz_bytes.size());
+    m.read_stream(stream, true);
+    benchmark::DoNotOptimize(m);
+  }
+  set_bytes(state, mtz_bytes.size());
+}
+
+static void mtz_write(benchmark::State& state) {
+  for (auto _ : state) {
+    std::string str;
+    mtz.write_to_string(str);
+    benchmark::DoNotOptimize(str);
+  }
+  set_bytes(state, mtz_bytes.size());
+}
+
+static void ccp4_read(benchmark::State& state) {
+  for (auto _ : state) {
+    gemmi::Ccp4<float> map;
+    map.read_ccp4_from_memory(ccp4_bytes.data(), ccp4_bytes.size(), "synth");
+    benchmark::DoNotOptimize(map);
+  }
+  set_bytes(state, ccp4_bytes.size());
+}
+
+// writes to a file in the current directory
+static void ccp4_write(benchmark::State& state) {
+  for (auto _ : state)
+    ccp4.write_ccp4_map(ccp4_path);
+  set_bytes(state, ccp4_bytes.size());
+}
+
+int main(int argc, char** argv) {
+  structure = make_synthetic_structure(8, 500);
+  mmcif_text = make_mmcif_string(structure);
+  mmcif_doc = cif::read_memory(mmcif_text.data(), mmcif_text.size(), "synth");
+  std::ostringstream os;
+  gemmi::cif::write_mmjson_to_stream(os, mmcif_doc);
+  mmjson_text = os.str();
+  pdb_text = gemmi::make_pdb_string(structure);
+  gemmi::write_binary_structure(structure, bin_path);
+  bin_size = gemmi::read_file_into_buffer(bin_path).size();
+
+  auto fcalc = calculate_synthetic_fcalc(structure, 1.5);
+  mtz = make_synthetic_mtz(fcalc, make_synthetic_fobs(fcalc));
+  mtz.write_to_string(mtz_bytes);
+
+  gemmi::DensityCalculator<gemmi::IT92<float>, float> dencalc;
+  dencalc.d_min = 1.5;
+  dencalc.grid.setup_from(structure);
+  dencalc.put_model_density_on_grid(structure.models[0]);
+  ccp4.grid = dencalc.grid;
+  ccp4.update_ccp4_header(2);
+  ccp4.write_ccp4_map(ccp4_path);
+  gemmi::CharArray ccp4_buf = gemmi::read_file_into_buffer(ccp4_path);
+  ccp4_bytes.assign(ccp4_buf.data(), ccp4_buf.size());
+
+  benchmark::RegisterBenchmark("cif_parse", cif_parse);
+  benchmark::RegisterBenchmark("mmjson_parse", mmjson_parse);
+  benchmark::RegisterBenchmark("mmjson_to_structure", mmjson_to_structure)->Arg(0)->Arg(1);
+  benchmark::RegisterBenchmark("binary_read", binary_read);
+  benchmark::RegisterBenchmark("pdb_parse", pdb_parse);
+  benchmark::RegisterBenchmark("make_structure_from_block", make_structure_from_block);
+  benchmark::RegisterBenchmark("write_mmcif", write_mmcif);
+  benchmark::RegisterBenchmark("write_mmjson", write_mmjson)->Arg(0)->Arg(1);
+  benchmark::RegisterBenchmark("write_pdb", write_pdb);
+  benchmark::RegisterBenchmark("mtz_read", mtz_read);
+  benchmark::RegisterBenchmark("mtz_write", mtz_write);
+  benchmark::RegisterBenchmark("ccp4_read", ccp4_read);
+  benchmark::RegisterBenchmark("ccp4_write", ccp4_write);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  std::remove(ccp4_path);
+  std::remove(bin_path);
+}
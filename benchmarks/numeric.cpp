@@ -0,0 +1,149 @@
+// Copyright 2026 Global Phasing Ltd.
+
+// End-to-end throughput of the main numerical routines, on synthetic data:
+// density calculation, FFT, solvent mask, neighbor search, scaling, merging.
+// Run with --benchmark_format=json (or --benchmark_out=FILE) to get results
+// that can be compared between commits.
+
+#include "gemmi/neighbor.hpp"  // for NeighborSearch
+#include "gemmi/scaling.hpp"   // for Scaling
+#include "gemmi/solmask.hpp"   // for SolventMasker
+#include "synthetic.h"
+#include <benchmark/benchmark.h>
+
+using DensityCalculator = gemmi::DensityCalculator<gemmi::IT92<float>, float>;
+
+static const double d_min = 1.5;
+static gemmi::Structure structure;
+static size_t atom_count;
+static DensityCalculator dencalc;  // with the density already calculated
+static gemmi::FPhiGrid<float> fphi_grid;
+static gemmi::AsuData<std::complex<float>> fcalc;
+static gemmi::AsuData<gemmi::ValueSigma<float>> fobs;
+static gemmi::Intensities unmerged;
+
+static void put_model_density_on_grid(benchmark::State& state) {
+  DensityCalculator dc;
+  dc.d_min = d_min;
+  dc.grid.setup_from(structure);
+  dc.set_refmac_compatible_blur(structure.models[0]);
+  for (auto _ : state) {
+    dc.put_model_density_on_grid(structure.models[0]);
+    benchmark::DoNotOptimize(dc.grid.data.data());
+  }
+  state.SetItemsProcessed(state.iterations() * atom_count);
+}
+
+static void fft_map_to_f_phi(benchmark::State& state) {
+  for (auto _ : state) {
+    gemmi::FPhiGrid<float> sf = gemmi::transform_map_to_f_phi(dencalc.grid, true);
+    benchmark::DoNotOptimize(sf);
+  }
+  state.SetItemsProcessed(state.iterations() * dencalc.grid.point_count());
+}
+
+static void fft_f_phi_to_map(benchmark::State& state) {
+  gemmi::Grid<float> map;
+  for (auto _ : state) {
+    gemmi::FPhiGrid<float> hkl = fphi_grid;
+    gemmi::transform_f_phi_grid_to_map_(std::move(hkl), map);
+    benchmark::DoNotOptimize(map.data.data());
+  }
+  state.SetItemsProcessed(state.iterations() * dencalc.grid.point_count());
+}
+
+static void put_mask_on_grid(benchmark::State& state) {
+  gemmi::SolventMasker masker(gemmi::AtomicRadiiSet::Refmac);
+  masker.n_threads = (int) state.range(0);
+  gemmi::Grid<float> grid;
+  grid.copy_metadata_from(dencalc.grid);
+  grid.data.resize(dencalc.grid.data.size());
+  for (auto _ : state) {
+    masker.put_mask_on_grid(grid, structure.models[0]);
+    benchmark::DoNotOptimize(grid.data.data());
+  }
+  state.SetItemsProcessed(state.iterations() * grid.point_count());
+}
+
+static void neighbor_search_populate(benchmark::State& state) {
+  gemmi::Model& model = structure.models[0];
+  for (auto _ : state) {
+    gemmi::NeighborSearch ns(model, structure.cell, 5.0);
+    ns.populate();
+    benchmark::DoNotOptimize(ns);
+  }
+  state.SetItemsProcessed(state.iterations() * atom_count);
+}
+
+// all pairs of atoms closer than 4A
+static void neighbor_search_contacts(benchmark::State& state) {
+  gemmi::Model& model = structure.models[0];
+  gemmi::NeighborSearch ns(model, structure.cell, 5.0);
+  ns.populate();
+  for (auto _ : state) {
+    size_t count = 0;
+    for (const gemmi::Chain& chain : model.chains)
+      for (const gemmi::Residue& res : chain.residues)
+        for (const gemmi::Atom& atom : res.atoms)
+          ns.for_each(atom.pos, atom.altloc, 4.0,
+                      [&](gemmi::NeighborSearch::Mark&, double) { ++count; });
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() * atom_count);
+}
+
+static void scaling_fit(benchmark::State& state) {
+  gemmi::Scaling<float> scaling(structure.cell, structure.find_spacegroup());
+  scaling.prepare_points(fcalc, fobs, nullptr);
+  for (auto _ : state) {
+    gemmi::Scaling<float> sc = scaling;
+    sc.fit_isotropic_b_approximately();
+    sc.fit_parameters();
+    benchmark::DoNotOptimize(sc.k_overall);
+  }
+  state.SetItemsProcessed(state.iterations() * scaling.points.size());
+}
+
+static void merge_intensities(benchmark::State& state) {
+  for (auto _ : state) {
+    gemmi::Intensities merged = unmerged.merged(gemmi::DataType::Anomalous);
+    benchmark::DoNotOptimize(merged);
+  }
+  state.SetItemsProcessed(state.iterations() * unmerged.data.size());
+}
+
+static void merging_stats(benchmark::State& state) {
+  gemmi::Intensities prepared = unmerged;
+  prepared.prepare_for_merging(gemmi::DataType::Mean);
+  for (auto _ : state) {
+    auto stats = prepared.calculate_merging_stats(nullptr);
+    benchmark::DoNotOptimize(stats);
+  }
+  state.SetItemsProcessed(state.iterations() * unmerged.data.size());
+}
+
+int main(int argc, char** argv) {
+  structure = make_synthetic_structure(8, 500);
+  atom_count = gemmi::count_atom_sites(structure.models[0]);
+  dencalc.d_min = d_min;
+  dencalc.grid.setup_from(structure);
+  dencalc.set_refmac_compatible_blur(structure.models[0]);
+  dencalc.put_model_density_on_grid(structure.models[0]);
+  fphi_grid = gemmi::transform_map_to_f_phi(dencalc.grid, true);
+  fcalc = fphi_grid.prepare_asu_data(dencalc.d_min, dencalc.blur);
+  fobs = make_synthetic_fobs(fcalc);
+  unmerged = make_synthetic_unmerged(fcalc, 4);
+
+  benchmark::RegisterBenchmark("put_model_density_on_grid", put_model_density_on_grid);
+  benchmark::RegisterBenchmark("fft_map_to_f_phi", fft_map_to_f_phi);
+  benchmark::RegisterBenchmark("fft_f_phi_to_map", fft_f_phi_to_map);
+  benchmark::RegisterBenchmark("put_mask_on_grid", put_mask_on_grid)->Arg(1)->Arg(4);
+  benchmark::RegisterBenchmark("neighbor_search_populate", neighbor_search_populate);
+  benchmark::RegisterBenchmark("neighbor_search_contacts", neighbor_search_contacts);
+  benchmark::RegisterBenchmark("scaling_fit", scaling_fit);
+  benchmark::RegisterBenchmark("merge_intensities", merge_intensities);
+  benchmark::RegisterBenchmark("merging_stats", merging_stats);
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
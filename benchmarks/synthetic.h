@@ -0,0 +1,177 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Synthetic inputs for the end-to-end benchmarks (io.cpp, numeric.cpp).
+// Everything is generated from a fixed seed, so the same data is used
+// in all runs and the results can be compared across commits.
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>  // for shuffle
+#include <complex>
+#include <random>
+#include <sstream>
+#include <string>
+#include "gemmi/model.hpp"
+#include "gemmi/polyheur.hpp"  // for setup_entities
+#include "gemmi/dencalc.hpp"   // for DensityCalculator
+#include "gemmi/fourier.hpp"   // for transform_map_to_f_phi
+#include "gemmi/it92.hpp"      // for IT92
+#include "gemmi/intensit.hpp"  // for Intensities
+#include "gemmi/mtz.hpp"       // for Mtz
+#include "gemmi/to_cif.hpp"    // for write_cif_to_stream
+#include "gemmi/to_mmcif.hpp"  // for make_mmcif_document
+
+// Poly-alanine chains as random walks (3.8A between CA atoms) and waters,
+// in a P 21 21 21 cell. About 5 * n_chains * n_residues atoms.
+inline gemmi::Structure make_synthetic_structure(int n_chains, int n_residues,
+                                                 unsigned seed=1) {
+  using namespace gemmi;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  std::normal_distribution<double> normal(0., 1.);
+  auto random_direction = [&]() {
+    Vec3 v(normal(rng), normal(rng), normal(rng));
+    return Position(v.normalized());
+  };
+  Structure st;
+  st.name = "SYNTH";
+  st.cell.set(70., 80., 90., 90., 90., 90.);
+  st.spacegroup_hm = "P 21 21 21";
+  st.setup_cell_images();
+  Model model(1);
+  const char* names[] = {"N", "CA", "C", "O", "CB"};
+  const El elements[] = {El::N, El::C, El::C, El::O, El::C};
+  int serial = 0;
+  for (int i = 0; i < n_chains; ++i) {
+    model.chains.emplace_back(std::string(1, char('A' + i % 26)));
+    Chain& chain = model.chains.back();
+    Position ca(uniform(rng) * st.cell.a, uniform(rng) * st.cell.b,
+                uniform(rng) * st.cell.c);
+    for (int j = 0; j < n_residues; ++j) {
+      Residue res;
+      res.name = "ALA";
+      res.seqid = SeqId(j + 1, ' ');
+      res.entity_type = EntityType::Polymer;
+      for (int k = 0; k < 5; ++k) {
+        Atom atom;
+        atom.name = names[k];
+        atom.element = elements[k];
+        atom.pos = k == 1 ? ca : ca + random_direction() * 1.5;
+        atom.occ = 1.f;
+        atom.b_iso = float(10. + 30. * uniform(rng));
+        atom.serial = ++serial;
+        res.atoms.push_back(atom);
+      }
+      chain.residues.push_back(res);
+      ca += random_direction() * 3.8;
+    }
+  }
+  model.chains.emplace_back("W");
+  for (int j = 0; j < n_chains * n_residues / 4; ++j) {
+    Residue res;
+    res.name = "HOH";
+    res.seqid = SeqId(j + 1, ' ');
+    res.het_flag = 'H';
+    res.entity_type = EntityType::Water;
+    Atom atom;
+    atom.name = "O";
+    atom.element = El::O;
+    atom.pos = Position(uniform(rng) * st.cell.a, uniform(rng) * st.cell.b,
+                        uniform(rng) * st.cell.c);
+    atom.occ = 1.f;
+    atom.b_iso = float(20. + 40. * uniform(rng));
+    atom.serial = ++serial;
+    res.atoms.push_back(atom);
+    model.chains.back().residues.push_back(res);
+  }
+  st.models.push_back(std::move(model));
+  setup_entities(st);
+  return st;
+}
+
+inline std::string make_mmcif_string(const gemmi::Structure& st) {
+  std::ostringstream os;
+  gemmi::cif::write_cif_to_stream(os, gemmi::make_mmcif_document(st));
+  return os.str();
+}
+
+// Structure factors of the model, as in gemmi sfcalc.
+inline gemmi::AsuData<std::complex<float>>
+calculate_synthetic_fcalc(const gemmi::Structure& st, double d_min) {
+  gemmi::DensityCalculator<gemmi::IT92<float>, float> dencalc;
+  dencalc.d_min = d_min;
+  dencalc.grid.setup_from(st);
+  dencalc.set_refmac_compatible_blur(st.models[0]);
+  dencalc.put_model_density_on_grid(st.models[0]);
+  gemmi::FPhiGrid<float> sf = gemmi::transform_map_to_f_phi(dencalc.grid, /*half_l=*/true);
+  return sf.prepare_asu_data(dencalc.d_min, dencalc.blur);
+}
+
+// "Observed" amplitudes: |Fcalc| scaled with k=2 and B=15, plus 5% noise.
+inline gemmi::AsuData<gemmi::ValueSigma<float>>
+make_synthetic_fobs(const gemmi::AsuData<std::complex<float>>& fcalc, unsigned seed=2) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0., 0.05);
+  gemmi::AsuData<gemmi::ValueSigma<float>> fobs;
+  fobs.unit_cell_ = fcalc.unit_cell_;
+  fobs.spacegroup_ = fcalc.spacegroup_;
+  fobs.v.reserve(fcalc.size());
+  for (const gemmi::HklValue<std::complex<float>>& hv : fcalc.v) {
+    double stol2 = fcalc.unit_cell_.calculate_stol_sq(hv.hkl);
+    double f = 2. * std::exp(-15. * stol2) * std::abs(hv.value) * (1. + noise(rng));
+    fobs.v.push_back({hv.hkl, {float(std::fabs(f)), float(0.05 * f + 1.)}});
+  }
+  return fobs;
+}
+
+// Merged MTZ file with columns H K L FP SIGFP FC PHIC.
+inline gemmi::Mtz make_synthetic_mtz(const gemmi::AsuData<std::complex<float>>& fcalc,
+                                     const gemmi::AsuData<gemmi::ValueSigma<float>>& fobs) {
+  gemmi::Mtz mtz;
+  mtz.cell = fcalc.unit_cell_;
+  mtz.set_spacegroup(fcalc.spacegroup_);
+  mtz.add_base();
+  mtz.add_dataset("synthetic");
+  mtz.add_column("FP", 'F', 1, -1, false);
+  mtz.add_column("SIGFP", 'Q', 1, -1, false);
+  mtz.add_column("FC", 'F', 1, -1, false);
+  mtz.add_column("PHIC", 'P', 1, -1, false);
+  mtz.data.reserve(fcalc.size() * mtz.columns.size());
+  for (size_t i = 0; i < fcalc.size(); ++i) {
+    const gemmi::Miller& hkl = fcalc.v[i].hkl;
+    for (int j = 0; j < 3; ++j)
+      mtz.data.push_back((float) hkl[j]);
+    mtz.data.push_back(fobs.v[i].value.value);
+    mtz.data.push_back(fobs.v[i].value.sigma);
+    mtz.data.push_back(std::abs(fcalc.v[i].value));
+    mtz.data.push_back((float) gemmi::phase_in_angles(fcalc.v[i].value));
+  }
+  mtz.nreflections = (int) fcalc.size();
+  return mtz;
+}
+
+// Unmerged intensities: n_obs observations of each reflection (in random
+// order and with random ISYM), as if read from an unmerged MTZ file.
+inline gemmi::Intensities
+make_synthetic_unmerged(const gemmi::AsuData<std::complex<float>>& fcalc,
+                        int n_obs, unsigned seed=3) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0., 0.1);
+  gemmi::Intensities intensities;
+  intensities.spacegroup = fcalc.spacegroup_;
+  intensities.unit_cell = fcalc.unit_cell_;
+  intensities.wavelength = 1.0;
+  intensities.type = gemmi::DataType::Unmerged;
+  int n_isym = 2 * (int) fcalc.spacegroup_->operations().sym_ops.size();
+  std::uniform_int_distribution<int> isym_dist(1, n_isym);
+  intensities.data.reserve(fcalc.size() * n_obs);
+  for (const gemmi::HklValue<std::complex<float>>& hv : fcalc.v)
+    for (int i = 0; i < n_obs; ++i) {
+      double intensity = std::norm(hv.value) * (1. + noise(rng));
+      intensities.add_if_valid(hv.hkl, 0, (int8_t) isym_dist(rng),
+                               intensity, 0.1 * std::fabs(intensity) + 1.);
+    }
+  std::shuffle(intensities.data.begin(), intensities.data.end(), rng);
+  return intensities;
+}
@@ -8,7 +8,8 @@ import networkx
 from networkx.algorithms import isomorphism
 import gemmi
 
-CCD_PATH = 'components.cif.gz'
+# uncompressed, so that only the needed blocks are read (see IndexedCcd)
+CCD_PATH = 'components.cif'
 
 def graph_from_chemcomp(cc):
     G = networkx.Graph()
@@ -52,18 +53,16 @@ def compare(cc1, cc2):
             print('\textra:  ', ' '.join(s1 - s2))
 
 def main():
-    ccd = gemmi.cif.read(CCD_PATH)
+    ccd = gemmi.IndexedCcd(CCD_PATH)
     absent = 0
     for f in sys.argv[1:]:
         block = gemmi.cif.read(f)[-1]
         cc1 = gemmi.make_chemcomp_from_block(block)
-        try:
-            block2 = ccd[cc1.name]
-        except KeyError:
+        cc2 = ccd.find(cc1.name)
+        if cc2 is None:
             absent += 1
             #print(cc1.name, 'not in CCD')
             continue
-        cc2 = gemmi.make_chemcomp_from_block(block2)
         cc1.remove_hydrogens()
         cc2.remove_hydrogens()
         compare(cc1, cc2)
@@ -87,6 +87,102 @@ inline void ensure_unique_chain_name(const Model& model, Chain& chain) {
   chain.name = namegen.make_short_name(chain.name);
 }
 
+struct NeighborSearch;
+
+/// Biological assembly stored as a reference to the original model
+/// and a list of chain copies, each with a transformation.
+/// Coordinates of the copies are calculated when needed, so the assembly
+/// of a large virus capsid takes little more memory than the original model.
+/// The model must not be modified or moved while InstancedAssembly is used.
+struct GEMMI_DLL InstancedAssembly {
+  struct Instance {
+    std::string oper_name;  // Assembly::Operator::name
+    Transform transform;
+  };
+  struct ChainCopy {
+    int instance_idx;           // index in instances
+    int chain_idx;              // index in model->chains
+    std::string name;           // name of the copied chain
+    std::vector<int> residues;  // indices of residues in the original chain;
+                                // empty = all residues
+  };
+  /// Read-only view of a copied atom.
+  struct AtomRef {
+    const ChainCopy* chain_copy;
+    const Residue* residue;  // original residue
+    const Atom* atom;        // original atom
+    Position pos;            // transformed position
+  };
+
+  const Model* model = nullptr;
+  HowToNameCopiedChain how = HowToNameCopiedChain::AddNumber;
+  std::vector<Instance> instances;
+  std::vector<ChainCopy> chains;
+
+  const Chain& orig_chain(const ChainCopy& cc) const { return model->chains[cc.chain_idx]; }
+  const Transform& transform(const ChainCopy& cc) const {
+    return instances[cc.instance_idx].transform;
+  }
+  size_t residue_count(const ChainCopy& cc) const {
+    return cc.residues.empty() ? orig_chain(cc).residues.size() : cc.residues.size();
+  }
+  const Residue& residue(const ChainCopy& cc, size_t n) const {
+    const Chain& chain = orig_chain(cc);
+    return chain.residues[cc.residues.empty() ? n : cc.residues[n]];
+  }
+  AtomRef get_atom(int chain_copy_idx, int residue_idx, int atom_idx) const {
+    const ChainCopy& cc = chains.at(chain_copy_idx);
+    const Residue& res = residue(cc, residue_idx);
+    const Atom& atom = res.atoms.at(atom_idx);
+    return {&cc, &res, &atom, Position(transform(cc).apply(atom.pos))};
+  }
+
+  size_t atom_count() const {
+    size_t n = 0;
+    for (const ChainCopy& cc : chains)
+      for (size_t i = 0; i != residue_count(cc); ++i)
+        n += residue(cc, i).atoms.size();
+    return n;
+  }
+
+  /// Calls func(const AtomRef&) for all atoms, in the same order
+  /// as in the Model returned by to_model().
+  template<typename Func>
+  void for_each_atom(Func&& func) const {
+    for (const ChainCopy& cc : chains) {
+      const Transform& tr = transform(cc);
+      for (size_t i = 0; i != residue_count(cc); ++i) {
+        const Residue& res = residue(cc, i);
+        for (const Atom& atom : res.atoms)
+          func(AtomRef{&cc, &res, &atom, Position(tr.apply(atom.pos))});
+      }
+    }
+  }
+
+  /// Positions of all atoms (in the order of for_each_atom()),
+  /// calculated in n_threads threads.
+  std::vector<Position> get_positions(int n_threads=1) const;
+
+  /// Returns a copy of chain copy cc, with transformed coordinates,
+  /// renamed subchains and, for HowToNameCopiedChain::Dup, segments.
+  Chain make_chain(const ChainCopy& cc) const;
+
+  /// Creates the full model (as make_assembly() does).
+  /// Chains are copied in n_threads threads.
+  Model to_model(int n_threads=1) const;
+};
+
+GEMMI_DLL InstancedAssembly make_instanced_assembly(const Assembly& assembly,
+                                                    const Model& model,
+                                                    HowToNameCopiedChain how,
+                                                    const Logger& logging);
+
+/// Non-periodic NeighborSearch over all atoms of the assembly.
+/// Mark::chain_idx is an index in InstancedAssembly::chains, Mark::residue_idx
+/// is an index of the residue in the chain copy; use get_atom() to get the atom.
+GEMMI_DLL NeighborSearch make_neighbor_search(const InstancedAssembly& assembly,
+                                              double radius, bool include_h=true);
+
 GEMMI_DLL Model make_assembly(const Assembly& assembly, const Model& model,
                               HowToNameCopiedChain how, const Logger& logging);
 
@@ -114,8 +210,10 @@ GEMMI_DLL Model expand_ncs_model(const Model& model, const std::vector<NcsOp>& n
 
 /// Searches and merges overlapping equivalent atoms from different chains.
 /// To be used after expand_ncs() and make_assembly().
+/// The search runs in n_threads threads; the result doesn't depend on it.
 GEMMI_DLL void merge_atoms_in_expanded_model(Model& model, const UnitCell& cell,
-                                             double max_dist=0.2, bool compare_serial=true);
+                                             double max_dist=0.2, bool compare_serial=true,
+                                             int n_threads=1);
 
 
 GEMMI_DLL void shorten_chain_names(Structure& st);
@@ -0,0 +1,74 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Copying atom properties (positions, B, occupancy, element) between
+// the Model hierarchy and contiguous arrays (one array per property).
+
+#ifndef GEMMI_ATOMARR_HPP_
+#define GEMMI_ATOMARR_HPP_
+
+#include <cstdint>   // for uint8_t
+#include "model.hpp" // for Model
+
+namespace gemmi {
+
+/// Pointers to arrays with one item per atom, in the order of atoms
+/// in the model (chains, residues, atoms). Null pointers are skipped.
+/// pos has 3 values (x, y, z) per atom, element is the atomic number.
+struct AtomArrays {
+  double* pos = nullptr;
+  float* b_iso = nullptr;
+  float* occ = nullptr;
+  uint8_t* element = nullptr;
+};
+
+/// Fills arrays in a single pass over the model; returns the number of atoms.
+/// Each non-null array must have space for count_atom_sites(model) atoms.
+inline size_t copy_atoms_to_arrays(const Model& model, const AtomArrays& out) {
+  size_t n = 0;
+  for (const Chain& chain : model.chains)
+    for (const Residue& res : chain.residues)
+      for (const Atom& atom : res.atoms) {
+        if (out.pos) {
+          out.pos[3*n+0] = atom.pos.x;
+          out.pos[3*n+1] = atom.pos.y;
+          out.pos[3*n+2] = atom.pos.z;
+        }
+        if (out.b_iso)
+          out.b_iso[n] = atom.b_iso;
+        if (out.occ)
+          out.occ[n] = atom.occ;
+        if (out.element)
+          out.element[n] = (uint8_t) atom.element.elem;
+        ++n;
+      }
+  return n;
+}
+
+/// The reverse of copy_atoms_to_arrays(). Arrays have n atoms;
+/// n must be equal to the number of atoms in the model.
+inline void copy_arrays_to_atoms(const AtomArrays& in, size_t n, Model& model) {
+  size_t count = 0;
+  for (const Chain& chain : model.chains)
+    for (const Residue& res : chain.residues)
+      count += res.atoms.size();
+  if (count != n)
+    fail("copy_arrays_to_atoms: got ", std::to_string(n), " values for ",
+         std::to_string(count), " atoms");
+  size_t i = 0;
+  for (Chain& chain : model.chains)
+    for (Residue& res : chain.residues)
+      for (Atom& atom : res.atoms) {
+        if (in.pos)
+          atom.pos = Position(in.pos[3*i+0], in.pos[3*i+1], in.pos[3*i+2]);
+        if (in.b_iso)
+          atom.b_iso = in.b_iso[i];
+        if (in.occ)
+          atom.occ = in.occ[i];
+        if (in.element)
+          atom.element = in.element[i] <= (int) El::D ? (El) in.element[i] : El::X;
+        ++i;
+      }
+}
+
+} // namespace gemmi
+#endif
@@ -0,0 +1,45 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Binary files with Structure or cif::Document, for fast re-loading
+// of preprocessed data (gemmi convert --to=bin).
+//
+// File layout (integers in native byte order, i.e. little-endian
+// on all common platforms):
+//   8 bytes   signature "gemmibin"
+//   uint32    format version, increased when the serialized layout changes
+//   uint32    content: 1 = Structure, 2 = cif::Document
+//   ...       gemmi version that wrote the file (uint32 length + chars),
+//             followed by the object serialized as in serialize.hpp.
+// Files with a different format version are rejected.
+
+#ifndef GEMMI_BINFILE_HPP_
+#define GEMMI_BINFILE_HPP_
+
+#include <cstring>    // for memcmp
+#include "model.hpp"  // for Structure
+
+namespace gemmi {
+
+namespace cif { struct Document; }
+
+/// Checks the signature at the start of the file.
+inline bool is_gemmi_binary(const char* data, size_t size) {
+  return size >= 16 && std::memcmp(data, "gemmibin", 8) == 0;
+}
+
+GEMMI_DLL void write_binary_structure(const Structure& st, const std::string& path);
+GEMMI_DLL void write_binary_document(const cif::Document& doc, const std::string& path);
+
+/// name is used only in error messages
+GEMMI_DLL Structure read_binary_structure_from_memory(const char* data, size_t size,
+                                                      const std::string& name);
+GEMMI_DLL cif::Document read_binary_document_from_memory(const char* data, size_t size,
+                                                         const std::string& name);
+
+/// The file is memory-mapped and objects are deserialized directly from
+/// the mapped pages, without reading the file into a buffer first.
+GEMMI_DLL Structure read_binary_structure(const std::string& path);
+GEMMI_DLL cif::Document read_binary_document(const std::string& path);
+
+} // namespace gemmi
+#endif
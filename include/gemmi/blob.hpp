@@ -3,15 +3,18 @@
 // Finding maxima or "blobs" in a Grid (map).
 // Similar to CCP4 PEAKMAX and COOT's "Unmodelled blobs".
 //
-// Implementation of the flood fill algorithm in find_blobs_by_flood_fill()
-// differs from from FloodFill in floodfill.hpp.
-// FloodFill uses more efficient scanline fill, but doesn't use symmetry.
+// Despite its name, find_blobs_by_flood_fill() uses connected-component
+// labeling (GridComponents from floodfill.hpp) and takes into account
+// symmetry.
 
 #ifndef GEMMI_BLOB_HPP_
 #define GEMMI_BLOB_HPP_
 
-#include "grid.hpp"     // for Grid
-#include "asumask.hpp"  // for get_asu_mask
+#include <cstdint>       // for SIZE_MAX
+#include "grid.hpp"      // for Grid
+#include "asumask.hpp"   // for get_asu_mask
+#include "floodfill.hpp" // for GridComponents
+#include "parallel.hpp"  // for parallel_for
 
 namespace gemmi {
 
@@ -33,104 +36,174 @@ struct BlobCriteria {
 
 namespace impl {
 
-struct GridConstPoint {
-  int u, v, w;
-  float value;
+// statistics of a run or of a blob, in unwrapped grid coordinates
+struct BlobSums {
+  size_t point_count = 0;
+  double score = 0.;
+  double sum[3] = {0., 0., 0.};  // sum of value * (u, v, w)
+  float peak_value = -INFINITY;
+  std::array<int,3> peak = {{0, 0, 0}};
+  size_t first_asu = SIZE_MAX;   // index of the first point in the ASU (runs only)
+
+  void add(const BlobSums& o, const std::array<int,3>& shift, const GridMeta& grid) {
+    const int n[3] = {grid.nu, grid.nv, grid.nw};
+    point_count += o.point_count;
+    score += o.score;
+    for (int k = 0; k < 3; ++k)
+      sum[k] += o.sum[k] + double(shift[k]) * n[k] * o.score;
+    if (o.peak_value > peak_value) {
+      peak_value = o.peak_value;
+      for (int k = 0; k < 3; ++k)
+        peak[k] = o.peak[k] + shift[k] * n[k];
+    }
+  }
 };
 
-inline Blob make_blob_of_points(const std::vector<GridConstPoint>& points,
-                                const GridMeta& grid,
-                                const BlobCriteria& criteria) {
+inline Blob make_blob_of_sums(const BlobSums& sums, const GridMeta& grid,
+                              const BlobCriteria& criteria) {
   Blob blob;
-  if (points.size() < 3)
+  if (sums.point_count < 3)
     return blob;
   double volume_per_point = grid.unit_cell.volume / grid.point_count();
-  double volume = points.size() * volume_per_point;
+  double volume = sums.point_count * volume_per_point;
   if (volume < criteria.min_volume)
     return blob;
-  double sum[3] = {0., 0., 0.};
-  const GridConstPoint* peak_point = &points[0];
-  blob.peak_value = points[0].value;
-  double score = 0.;
-  for (const GridConstPoint& point : points) {
-    score += point.value;
-    if (point.value > blob.peak_value) {
-      blob.peak_value = point.value;
-      peak_point = &point;
-    }
-    sum[0] += double(point.u) * point.value;
-    sum[1] += double(point.v) * point.value;
-    sum[2] += double(point.w) * point.value;
-  }
+  blob.peak_value = sums.peak_value;
   if (blob.peak_value < criteria.min_peak)
     return blob;
-  blob.score = score * volume_per_point;
+  blob.score = sums.score * volume_per_point;
   if (blob.score < criteria.min_score)
     return blob;
-  gemmi::Fractional fract(sum[0] / (score * grid.nu),
-                          sum[1] / (score * grid.nv),
-                          sum[2] / (score * grid.nw));
+  gemmi::Fractional fract(sums.sum[0] / (sums.score * grid.nu),
+                          sums.sum[1] / (sums.score * grid.nv),
+                          sums.sum[2] / (sums.score * grid.nw));
   blob.centroid = grid.unit_cell.orthogonalize(fract);
-  blob.peak_pos = grid.get_position(peak_point->u, peak_point->v, peak_point->w);
+  blob.peak_pos = grid.get_position(sums.peak[0], sums.peak[1], sums.peak[2]);
   blob.volume = volume;
   return blob;
 }
 
 } // namespace impl
 
-// with negate=true grid negatives of grid values are used
+/// Blobs are connected (6-way) regions of points with values above
+/// criteria.cutoff (points equal to the cutoff are not included, not even
+/// as seeds, unlike in gemmi <= 0.7.3). Symmetry-related blobs are
+/// reported once, with centroid near the first point of the blob in the ASU
+/// (seed). A component connected to its own periodic image has no
+/// well-defined unwrapped coordinates; its points are unwrapped along
+/// the paths from the union-find labeling.
+/// With negate=true grid negatives of grid values are used.
+/// The points are labeled with GridComponents, using n_threads threads.
 inline std::vector<Blob> find_blobs_by_flood_fill(const gemmi::Grid<float>& grid,
                                                   const BlobCriteria& criteria,
-                                                  bool negate=false) {
-  std::vector<Blob> blobs;
-  std::array<std::array<int, 3>, 6> moves = {{{{-1, 0, 0}}, {{1, 0, 0}},
-                                              {{0 ,-1, 0}}, {{0, 1, 0}},
-                                              {{0, 0, -1}}, {{0, 0, 1}}}};
-  // the mask will be used as follows:
-  // -1=in blob,  0=in asu, not in blob (so far),  1=in neither
-  std::vector<std::int8_t> mask = gemmi::get_asu_mask(grid);
+                                                  bool negate=false,
+                                                  int n_threads=1) {
+  const float sign = negate ? -1.f : 1.f;
+  const float cutoff = (float) criteria.cutoff;
+  GridComponents components;
+  components.label(grid, [&](float x) { return sign * x > cutoff; }, n_threads);
+  const size_t n_runs = components.runs.size();
   std::vector<gemmi::GridOp> ops = grid.get_scaled_ops_except_id();
-  size_t idx = 0;
-  for (int w = 0; w != grid.nw; ++w)
-    for (int v = 0; v != grid.nv; ++v)
-      for (int u = 0; u != grid.nu; ++u, ++idx) {
-        assert(idx == grid.index_q(u, v, w));
-        if (mask[idx] != 0)
-          continue;
-        float value = grid.data[idx];
-        if (negate)
-          value = -value;
-        if (value < criteria.cutoff)
-          continue;
-        std::vector<impl::GridConstPoint> points;
-        points.push_back({u, v, w, value});
-        mask[idx] = -1;
-        for (size_t j = 0; j < points.size()/*increasing!*/; ++j)
-          for (const std::array<int, 3>& mv : moves) {
-            int nabe_u = points[j].u + mv[0];
-            int nabe_v = points[j].v + mv[1];
-            int nabe_w = points[j].w + mv[2];
-            size_t nabe_idx = grid.index_s(nabe_u, nabe_v, nabe_w);
-            if (mask[nabe_idx] == -1)
-              continue;
-            float nabe_value = grid.data[nabe_idx];
-            if (negate)
-              nabe_value = -nabe_value;
-            if (nabe_value > criteria.cutoff) {
-              if (mask[nabe_idx] != 0)
-                for (const gemmi::GridOp& op : ops) {
-                  auto t = op.apply(nabe_u, nabe_v, nabe_w);
-                  size_t mate_idx = grid.index_s(t[0], t[1], t[2]);
-                  if (mask[mate_idx] == 0)
-                    mask[mate_idx] = 1;
-                }
-              mask[nabe_idx] = -1;
-              points.push_back({nabe_u, nabe_v, nabe_w, nabe_value});
-            }
-          }
-        if (Blob blob = impl::make_blob_of_points(points, grid, criteria))
-          blobs.push_back(blob);
+  // 0=in asu, 1=not in asu, 2=in asu, image of an earlier blob;
+  // without symmetry all points are in the ASU
+  std::vector<std::int8_t> asu_mask;
+  if (!ops.empty())
+    asu_mask = gemmi::get_asu_mask(grid);
+
+  // statistics of individual runs
+  std::vector<impl::BlobSums> run_sums(n_runs);
+  parallel_for(n_runs, n_threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i != end; ++i) {
+      const GridComponents::Run& run = components.runs[i];
+      impl::BlobSums& rs = run_sums[i];
+      size_t idx = grid.index_q(run.u, run.v, run.w);
+      double sum_u = 0.;
+      for (int u = run.u; u < run.u + run.len; ++u, ++idx) {
+        float value = sign * grid.data[idx];
+        rs.score += value;
+        sum_u += double(u) * value;
+        if (value > rs.peak_value) {
+          rs.peak_value = value;
+          rs.peak = {{u, run.v, run.w}};
+        }
+        if (rs.first_asu == SIZE_MAX && (ops.empty() || asu_mask[idx] == 0))
+          rs.first_asu = idx;
       }
+      rs.point_count = run.len;
+      rs.sum[0] = sum_u;
+      rs.sum[1] = double(run.v) * rs.score;
+      rs.sum[2] = double(run.w) * rs.score;
+    }
+  });
+
+  // Select components to be reported, in the same way as the original
+  // (sequential) flood fill: the ASU points are scanned in order and each
+  // not-yet-visited and not-claimed point starts a blob. The images of
+  // the blob's points from outside of the ASU are claimed (mask value 2).
+  // Note that 6-way connectivity is not invariant under all symmetry
+  // operations (e.g. 3-fold axes), so images of a blob don't need to be
+  // identical components.
+  std::vector<int> blob_index(n_runs, -1);
+  std::vector<int> seed_runs;
+  // runs grouped by components
+  std::vector<int> comp_start, comp_runs;
+  if (!ops.empty()) {
+    comp_start.assign(n_runs + 1, 0);
+    for (int root : components.parent)
+      ++comp_start[root + 1];
+    for (size_t i = 0; i != n_runs; ++i)
+      comp_start[i + 1] += comp_start[i];
+    comp_runs.resize(n_runs);
+    std::vector<int> pos(comp_start.begin(), comp_start.end() - 1);
+    for (size_t i = 0; i != n_runs; ++i)
+      comp_runs[pos[components.parent[i]]++] = (int) i;
+  }
+  for (size_t i = 0; i != n_runs; ++i) {
+    int root = components.parent[i];
+    if (blob_index[root] >= 0 || run_sums[i].first_asu == SIZE_MAX)
+      continue;
+    const GridComponents::Run& run = components.runs[i];
+    size_t idx = run_sums[i].first_asu;
+    size_t end_idx = grid.index_q(run.u, run.v, run.w) + run.len;
+    if (!ops.empty())
+      while (idx != end_idx && asu_mask[idx] != 0)
+        ++idx;
+    if (idx == end_idx)
+      continue;
+    blob_index[root] = (int) seed_runs.size();
+    seed_runs.push_back((int) i);
+    if (ops.empty())
+      continue;
+    for (int k = comp_start[root]; k != comp_start[root + 1]; ++k) {
+      const GridComponents::Run& r = components.runs[comp_runs[k]];
+      size_t ridx = grid.index_q(r.u, r.v, r.w);
+      for (int u = r.u; u < r.u + r.len; ++u, ++ridx)
+        if (asu_mask[ridx] == 1)
+          for (const gemmi::GridOp& op : ops) {
+            std::array<int,3> t = op.apply(u, r.v, r.w);
+            std::int8_t& m = asu_mask[grid.index_s(t[0], t[1], t[2])];
+            if (m == 0)
+              m = 2;
+          }
+    }
+  }
+
+  std::vector<impl::BlobSums> sums(seed_runs.size());
+  for (size_t i = 0; i != n_runs; ++i) {
+    int root = components.parent[i];
+    int bi = blob_index[root];
+    if (bi < 0)
+      continue;
+    std::array<int,3> shift;
+    const std::array<int,3>& seed_shift = components.shift[seed_runs[bi]];
+    for (int k = 0; k < 3; ++k)
+      shift[k] = components.shift[i][k] - seed_shift[k];
+    sums[bi].add(run_sums[i], shift, grid);
+  }
+  std::vector<Blob> blobs;
+  for (const impl::BlobSums& bs : sums)
+    if (Blob blob = impl::make_blob_of_sums(bs, grid, criteria))
+      blobs.push_back(blob);
   std::sort(blobs.begin(), blobs.end(),
             [](const Blob& a, const Blob& b) { return a.score > b.score; });
   return blobs;
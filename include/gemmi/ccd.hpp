@@ -0,0 +1,88 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Indexed access to the Chemical Component Dictionary (components.cif).
+// Only requested blocks are read and parsed; parsed ChemComps are kept
+// in an LRU cache.
+
+#ifndef GEMMI_CCD_HPP_
+#define GEMMI_CCD_HPP_
+
+#include <cstdint>
+#include <list>
+#include <memory>         // for shared_ptr
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cifdoc.hpp"     // for cif::Block
+#include "chemcomp.hpp"   // for ChemComp
+#include "fileutil.hpp"   // for FileStamp
+#include "logger.hpp"     // for Logger
+
+namespace gemmi {
+
+/// Byte offsets of data blocks in an (uncompressed) CIF file.
+struct GEMMI_DLL CifBlockIndex {
+  struct Entry {
+    uint64_t offset;
+    uint64_t length;
+  };
+  FileStamp stamp;  // of the indexed file
+  std::unordered_map<std::string, Entry> blocks;
+  std::vector<std::string> names;  // in the order of the file
+
+  /// Scans the file. Multi-line text fields are skipped,
+  /// so data_ at the beginning of a line in a text field is ignored.
+  void build(const std::string& path);
+  /// Returns false if the index file doesn't exist, has a wrong format,
+  /// or was made for a different version of the indexed file.
+  bool load(const std::string& index_path, const FileStamp& expected);
+  void save(const std::string& index_path) const;
+};
+
+/// Chemical Component Dictionary (or another CIF file with many blocks),
+/// with data blocks read from the file when needed.
+/// On the first use, the file is scanned to find the positions of blocks.
+/// This index is saved next to the file (or in index_path) and reused
+/// as long as the file doesn't change. Not thread-safe.
+class GEMMI_DLL IndexedCcd {
+public:
+  IndexedCcd() = default;
+  explicit IndexedCcd(const std::string& path, const std::string& index_path="",
+                      const Logger& logger={}) {
+    open(path, index_path, logger);
+  }
+
+  /// If index_path is empty, path + ".idx" is used. If the index can't be
+  /// saved (e.g. the directory is read-only), it's only kept in memory.
+  void open(const std::string& path, const std::string& index_path="",
+            const Logger& logger={});
+
+  const std::string& path() const { return path_; }
+  size_t size() const { return index_.names.size(); }
+  const std::vector<std::string>& names() const { return index_.names; }
+  bool has(const std::string& name) const { return index_.blocks.count(name) != 0; }
+
+  /// Reads and parses one block. Throws if the block is not in the file.
+  cif::Block read_block(const std::string& name) const;
+
+  /// Returns nullptr if the component is absent.
+  /// Parsed components are cached (up to cache_capacity).
+  std::shared_ptr<const ChemComp> find(const std::string& name);
+
+  /// Like find(), but throws if the component is absent.
+  std::shared_ptr<const ChemComp> get(const std::string& name);
+
+  size_t cache_capacity = 256;
+  size_t cache_size() const { return lru_.size(); }
+  void clear_cache() { lru_.clear(); cache_.clear(); }
+
+private:
+  using LruList = std::list<std::pair<std::string, std::shared_ptr<const ChemComp>>>;
+  std::string path_;
+  CifBlockIndex index_;
+  LruList lru_;  // most recently used first
+  std::unordered_map<std::string, LruList::iterator> cache_;
+};
+
+} // namespace gemmi
+#endif
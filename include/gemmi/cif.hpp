@@ -16,6 +16,9 @@
 
 #include "cifdoc.hpp" // for Document, etc
 #include "fileutil.hpp" // for CharArray, file_open
+#ifdef GEMMI_PROFILE
+# include "profile.hpp"  // for GEMMI_PROFILE_SCOPE
+#endif
 
 #if defined(_MSC_VER)
 #pragma warning(push)
@@ -269,6 +272,9 @@ template<typename Input> void parse_input(Document& d, Input&& in) {
 }
 
 template<typename Input> Document read_input(Input&& in, int check_level=1) {
+#ifdef GEMMI_PROFILE
+  GEMMI_PROFILE_SCOPE("cif.parse");
+#endif
   Document doc;
   doc.source = in.source();
   parse_input(doc, in);
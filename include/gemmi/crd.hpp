@@ -9,9 +9,13 @@
 
 namespace gemmi {
 
+struct NeighborSearchCache;
+
 GEMMI_DLL void setup_for_crd(Structure& st);
 
-GEMMI_DLL void add_automatic_links(Model& model, Structure& st, const MonLib& monlib);
+/// If ns_cache is given, the neighbor search is taken from (or stored in) it.
+GEMMI_DLL void add_automatic_links(Model& model, Structure& st, const MonLib& monlib,
+                                   NeighborSearchCache* ns_cache=nullptr);
 
 GEMMI_DLL void add_dictionary_blocks(cif::Document& doc, const std::vector<std::string>& resnames,
                                      const Topo& topo, const MonLib& monlib);
@@ -5,6 +5,7 @@
 #ifndef GEMMI_DDL_HPP_
 #define GEMMI_DDL_HPP_
 
+#include <bitset>
 #include <map>
 #include <memory>  // for unique_ptr
 #include <regex>
@@ -28,6 +29,8 @@ struct GEMMI_DLL Ddl {
   // instead of _item_type.code, _pdbx_item_enumeration.value, and _item_range
   // use _pdbx-prefixed equivalents (_pdbx_item_type.code, etc).
   bool use_deposition_checks = false;
+  // loop columns are validated in parallel
+  int n_threads = 1;
 
   // variables set when reading DLL; normally, no need to change them
   int major_version = 0;  // currently 1 and 2 are supported
@@ -50,6 +53,23 @@ struct GEMMI_DLL Ddl {
 
   const std::map<std::string, std::regex>& regexes() const { return regexes_; }
 
+  /// Regex of DDL2 type (_item_type_list.construct), compiled in read_ddl().
+  /// Most of the types (code, line, text, ...) have regex in the form
+  /// [...]* or [...]+; these are checked with a lookup table, not std::regex.
+  struct TypeMatcher {
+    const std::regex* re = nullptr;
+    bool simple = false;  // the regex is a single-character pattern + * or +
+    bool allow_empty = true;
+    std::bitset<256> chars;  // characters matched by the single-character pattern
+
+    /// takes raw value (quoted or not)
+    bool match(const std::string& value) const;
+  };
+  const TypeMatcher* find_type_matcher(const std::string& code) const {
+    auto it = type_matchers_.find(code);
+    return it != type_matchers_.end() ? &it->second : nullptr;
+  }
+
 private:
   // items from DDL2 _pdbx_item_linked_group[_list]
   struct ParentLink {
@@ -61,6 +81,7 @@ private:
   std::vector<std::unique_ptr<cif::Document>> ddl_docs_;
   std::map<std::string, cif::Block*> name_index_;
   std::map<std::string, std::regex> regexes_;
+  std::map<std::string, TypeMatcher> type_matchers_;
   std::vector<ParentLink> parents_;
   // storage for DDL2 _item_linked.child_name -> _item_linked.parent_name
   std::map<std::string, std::string> item_parents_;
@@ -73,6 +94,8 @@ private:
   void check_unique_keys_in_loop(const cif::Loop& loop, const cif::Block& block) const;
   void check_parents(const cif::Block& b) const;
   void check_parent_link(const ParentLink& link, const cif::Block& b) const;
+  bool validate_loop(const cif::Item& item, const cif::Block& b,
+                     const std::string& source) const;
   void read_ddl1_block(cif::Block& block);
   void read_ddl2_block(cif::Block& block);
 
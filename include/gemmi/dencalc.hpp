@@ -10,6 +10,9 @@
 #include "grid.hpp"     // for Grid
 #include "model.hpp"    // for Structure, ...
 #include "calculate.hpp" // for calculate_b_aniso_range
+#ifdef GEMMI_PROFILE
+# include "profile.hpp"  // for GEMMI_PROFILE_SCOPE
+#endif
 
 namespace gemmi {
 
@@ -183,6 +186,10 @@ struct DensityCalculator {
   }
 
   void put_model_density_on_grid(const Model& model) {
+#ifdef GEMMI_PROFILE
+    GEMMI_PROFILE_SCOPE("dencalc.put_model_density_on_grid");
+    GEMMI_PROFILE_COUNT("dencalc.atoms", count_atom_sites(model));
+#endif
     initialize_grid();
     add_model_density_to_grid(model);
     grid.symmetrize_sum();
@@ -7,32 +7,31 @@
 
 #include <cassert>
 #include "binner.hpp"
+#include "reciproc.hpp"  // for ReflnProperties
 
 namespace gemmi {
 
+/// props must be calculated for the same data, with bins assigned
+/// from the binner (ReflnProperties::assign_bins()).
 template<typename DataProxy>
 std::vector<double> calculate_amplitude_normalizers(const DataProxy& data, int fcol_idx,
-                                                    const Binner& binner) {
+                                                    const Binner& binner,
+                                                    const ReflnProperties& props) {
   struct CountAndSum {
     int n = 0;
     double sum = 0.;
   };
   int nreflections = data.size() / data.stride();
+  if (props.size() != (size_t) nreflections || props.bin.size() != props.size())
+    fail("calculate_amplitude_normalizers: ReflnProperties not set up for the data");
   std::vector<double> multipliers(nreflections, NAN);
-  if (data.spacegroup() == nullptr)
-    gemmi::fail("unknown space group in the data file");
-  GroupOps gops = data.spacegroup()->operations();
-  std::vector<double> inv_d2(multipliers.size());
-  for (size_t i = 0, n = 0; n < data.size(); n += data.stride(), ++i)
-    inv_d2[i] = data.unit_cell().calculate_1_d2(data.get_hkl(n));
-  std::vector<int> bin_index = binner.get_bins_from_1_d2(inv_d2);
+  const std::vector<double>& inv_d2 = props.inv_d2;
+  const std::vector<int>& bin_index = props.bin;
   std::vector<CountAndSum> stats(binner.size());
   for (size_t i = 0, n = 0; n < data.size(); n += data.stride(), i++) {
-    Miller hkl = data.get_hkl(n);
     double f = data.get_num(n + fcol_idx);
     if (!std::isnan(f)) {
-      int epsilon = gops.epsilon_factor(hkl);
-      double inv_epsilon = 1.0 / epsilon;
+      double inv_epsilon = 1.0 / props.epsilon[i];
       double f2 = f * f * inv_epsilon;
       multipliers[i] = std::sqrt(inv_epsilon);
       CountAndSum& cs = stats[bin_index[i]];
@@ -93,5 +92,14 @@ std::vector<double> calculate_amplitude_normalizers(const DataProxy& data, int f
   return multipliers;
 }
 
+template<typename DataProxy>
+std::vector<double> calculate_amplitude_normalizers(const DataProxy& data, int fcol_idx,
+                                                    const Binner& binner) {
+  ReflnProperties props;
+  props.calculate_for(data);
+  props.assign_bins(binner);
+  return calculate_amplitude_normalizers(data, fcol_idx, binner, props);
+}
+
 } // namespace gemmi
 #endif
@@ -0,0 +1,241 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Euclidean distance transform (EDT) of a grid with periodic boundaries.
+
+#ifndef GEMMI_EDT_HPP_
+#define GEMMI_EDT_HPP_
+
+#include <cmath>      // for INFINITY, isinf, sqrt, ceil
+#include <algorithm>  // for min, fill
+#include <array>
+#include <vector>
+#include "grid.hpp"      // for Grid
+#include "parallel.hpp"  // for parallel_for
+
+namespace gemmi {
+
+namespace impl {
+
+/// Distance transform of sampled function (Felzenszwalb & Huttenlocher,
+/// Theory of Computing 8, 415, 2012) in 1D with periodic boundaries:
+/// out[i] = min_j (w2 * (i-j)^2 + f[j]); f[j] = INFINITY for non-sites.
+/// Only j in [-m, n+m) are considered; m <= n.
+/// v and z are work arrays of size n+2*m and n+2*m+1.
+inline void periodic_distance_transform_1d(const double* f, double* out, int n,
+                                           int m, double w2, int* v, double* z) {
+  auto f_at = [&](int q) { return f[q < 0 ? q + n : q >= n ? q - n : q]; };
+  if (m <= 6) {
+    // for a narrow window, brute force is faster than the lower envelope
+    double* ext = z;  // f extended by m on both sides
+    for (int q = -m; q < n + m; ++q)
+      ext[q + m] = f_at(q);
+    for (int i = 0; i < n; ++i)
+      out[i] = ext[i + m];
+    for (int d = 1; d <= m; ++d) {
+      double wd = w2 * (d * d);
+      for (int i = 0; i < n; ++i)
+        out[i] = std::min(out[i], std::min(ext[i + m - d], ext[i + m + d]) + wd);
+    }
+    return;
+  }
+  int k = -1;
+  for (int q = -m; q < n + m; ++q) {
+    double fq = f_at(q);
+    if (std::isinf(fq))
+      continue;
+    double s = -INFINITY;
+    while (k >= 0) {
+      int p = v[k];
+      s = ((fq + w2 * sq(double(q))) - (f_at(p) + w2 * sq(double(p)))) / (2 * w2 * (q - p));
+      if (s > z[k])
+        break;
+      --k;
+    }
+    ++k;
+    v[k] = q;
+    z[k] = k == 0 ? -INFINITY : s;
+    z[k+1] = INFINITY;
+  }
+  if (k < 0) {
+    std::fill(out, out + n, INFINITY);
+    return;
+  }
+  for (int i = 0, j = 0; i < n; ++i) {
+    while (z[j+1] < i)
+      ++j;
+    out[i] = w2 * sq(double(i - v[j])) + f_at(v[j]);
+  }
+}
+
+/// Separable exact algorithm, three passes of the 1D transform.
+template<typename T, typename Pred>
+void separable_distance_transform(const Grid<T>& grid, Pred& is_site,
+                                  Grid<float>& out, double max_dist,
+                                  int n_threads) {
+  const int nu = grid.nu, nv = grid.nv, nw = grid.nw;
+  const double spacing[3] = {grid.orth_n.a11, grid.orth_n.a22, grid.orth_n.a33};
+  const double max_dist_sq = sq(max_dist);
+  // Lines along the axis are processed in blocks of up to B lines
+  // that are adjacent in memory (except for the first axis).
+  const int B = 16;
+  for (int axis = 0; axis < 3; ++axis) {
+    int n = axis == 0 ? nu : axis == 1 ? nv : nw;
+    int m = n;
+    if (max_dist < m * spacing[axis])
+      m = (int) std::ceil(max_dist / spacing[axis]);
+    size_t stride = axis == 0 ? 1 : axis == 1 ? nu : (size_t) nu * nv;
+    // number of blocks and lines in a block
+    size_t n_blocks = axis == 0 ? (size_t) nv * nw
+                                : (axis == 1 ? nw : nv) * size_t((nu + B - 1) / B);
+    int block_width = axis == 0 ? 1 : B;
+    parallel_for(n_blocks, n_threads, [&](size_t begin, size_t end) {
+      std::vector<double> f(block_width * n), g(n), z(n + 2 * m + 1);
+      std::vector<int> v(n + 2 * m);
+      for (size_t block = begin; block != end; ++block) {
+        size_t start;
+        int width = 1;
+        if (axis == 0) {
+          start = block * nu;
+        } else {
+          size_t n_ublocks = (nu + B - 1) / B;
+          int u0 = int(block % n_ublocks) * B;
+          width = std::min(B, nu - u0);
+          size_t outer = block / n_ublocks;  // w for axis 1, v for axis 2
+          start = u0 + outer * (axis == 1 ? (size_t) nu * nv : (size_t) nu);
+        }
+        for (int i = 0; i < n; ++i) {
+          size_t idx = start + i * stride;
+          for (int k = 0; k < width; ++k) {
+            double x = axis == 0 ? (is_site(grid.data[idx + k]) ? 0. : INFINITY)
+                                 : out.data[idx + k];
+            f[k * n + i] = x > max_dist_sq ? INFINITY : x;
+          }
+        }
+        for (int k = 0; k < width; ++k) {
+          double* fk = &f[k * n];
+          periodic_distance_transform_1d(fk, g.data(), n, m, sq(spacing[axis]),
+                                         v.data(), z.data());
+          for (int i = 0; i < n; ++i)
+            fk[i] = g[i] > max_dist_sq ? INFINITY : g[i];
+        }
+        for (int i = 0; i < n; ++i) {
+          size_t idx = start + i * stride;
+          for (int k = 0; k < width; ++k)
+            out.data[idx + k] = (float) f[k * n + i];
+        }
+      }
+    });
+  }
+}
+
+/// For non-orthogonal axes: distances are propagated from the boundary
+/// sites (sites with a non-site among 26 neighbors) using a stencil.
+/// The nearest site of a non-site point is always a boundary site,
+/// unless the grid cell is extremely skewed.
+template<typename T, typename Pred>
+void stencil_distance_transform(const Grid<T>& grid, Pred& is_site,
+                                Grid<float>& out, double max_dist,
+                                int n_threads) {
+  const int nu = grid.nu, nv = grid.nv, nw = grid.nw;
+  std::vector<std::array<int,3>> boundary;
+  size_t idx = 0;
+  for (int w = 0; w < nw; ++w)
+    for (int v = 0; v < nv; ++v)
+      for (int u = 0; u < nu; ++u, ++idx) {
+        if (!is_site(grid.data[idx])) {
+          out.data[idx] = INFINITY;
+          continue;
+        }
+        out.data[idx] = 0.f;
+        bool inner = true;
+        for (int dw = -1; dw <= 1 && inner; ++dw)
+          for (int dv = -1; dv <= 1 && inner; ++dv)
+            for (int du = -1; du <= 1; ++du)
+              if (!is_site(grid.data[grid.index_n(u + du, v + dv, w + dw)])) {
+                inner = false;
+                break;
+              }
+        if (!inner)
+          boundary.push_back({{u, v, w}});
+      }
+
+  // stencil entries grouped by the w offset
+  struct Entry { int du, dv; float d2; };
+  const double max_dist_sq = sq(max_dist);
+  int du = (int) std::ceil(max_dist / grid.spacing[0]);
+  int dv = (int) std::ceil(max_dist / grid.spacing[1]);
+  int dw = (int) std::ceil(max_dist / grid.spacing[2]);
+  std::vector<std::vector<Entry>> stencil(2 * dw + 1);
+  for (int w = -dw; w <= dw; ++w)
+    for (int v = -dv; v <= dv; ++v)
+      for (int u = -du; u <= du; ++u) {
+        Fractional fdelta = grid.get_fractional(u, v, w);
+        double d2 = grid.unit_cell.orthogonalize_difference(fdelta).length_sq();
+        if (d2 <= max_dist_sq && d2 != 0.)
+          stencil[w + dw].push_back({u, v, (float) d2});
+      }
+
+  // each thread updates only points in its range of sections w
+  parallel_for(nw, n_threads, [&](size_t begin, size_t end) {
+    for (const std::array<int,3>& site : boundary)
+      for (int w = -dw; w <= dw; ++w) {
+        int tw = modulo(site[2] + w, nw);
+        if (tw < (int) begin || tw >= (int) end)
+          continue;
+        for (const Entry& e : stencil[w + dw]) {
+          size_t target = grid.index_q(modulo(site[0] + e.du, nu),
+                                       modulo(site[1] + e.dv, nv), tw);
+          if (e.d2 < out.data[target])
+            out.data[target] = e.d2;
+        }
+      }
+  });
+}
+
+} // namespace impl
+
+inline bool has_orthogonal_axes(const UpperTriangularMat33& m) {
+  const double eps = 1e-9;
+  return std::fabs(m.a12) < eps * m.a22 && std::fabs(m.a13) < eps * m.a33 &&
+         std::fabs(m.a23) < eps * m.a33;
+}
+
+/// Squared distance (in A^2) from each grid point to the nearest point
+/// (or its periodic image) for which is_site(value) is true.
+/// Distances above max_dist are not calculated (set to INFINITY).
+/// For grids with orthogonal axes it uses the exact, linear-time,
+/// separable algorithm. For other unit cells, the distances are propagated
+/// from the surface of the sites: the cost is O(boundary points * r^3),
+/// where r = max_dist / spacing, and each thread iterates over all boundary
+/// points. The default max_dist (capped at half of a+b+c) can make it very
+/// slow; use a finite max_dist when only short distances are needed.
+template<typename T, typename Pred>
+void squared_distance_transform(const Grid<T>& grid, Pred is_site,
+                                Grid<float>& out, double max_dist=INFINITY,
+                                int n_threads=1) {
+  if (grid.data.empty())
+    fail("distance transform: empty grid");
+  // no point in a unit cell is further than this from the nearest site
+  const UnitCell& uc = grid.unit_cell;
+  max_dist = std::min(max_dist, 0.5 * (uc.a + uc.b + uc.c));
+  out.copy_metadata_from(grid);
+  out.data.resize(grid.data.size());
+  if (has_orthogonal_axes(grid.orth_n))
+    impl::separable_distance_transform(grid, is_site, out, max_dist, n_threads);
+  else
+    impl::stencil_distance_transform(grid, is_site, out, max_dist, n_threads);
+}
+
+/// Like squared_distance_transform(), but returns distances (in A).
+template<typename T, typename Pred>
+Grid<float> distance_transform(const Grid<T>& grid, Pred is_site,
+                               double max_dist=INFINITY, int n_threads=1) {
+  Grid<float> out;
+  squared_distance_transform(grid, is_site, out, max_dist, n_threads);
+  for (float& x : out.data)
+    x = std::sqrt(x);
+  return out;
+}
+
+} // namespace gemmi
+#endif
@@ -12,6 +12,7 @@
 #include <cstring>   // for strlen
 #include <initializer_list>
 #include <memory>    // for unique_ptr
+#include <sys/stat.h>  // for stat
 #include "fail.hpp"  // for sys_fail
 
 #if defined(_WIN32) && !defined(GEMMI_USE_FOPEN)
@@ -81,6 +82,33 @@ inline std::size_t file_size(std::FILE* f, const std::string& path) {
 }
 
 // helper function for working with binary files
+/// Size and modification time of a file, used to detect changed files.
+struct FileStamp {
+  int64_t mtime = 0;
+  uint64_t size = 0;
+  bool operator==(const FileStamp& o) const { return mtime == o.mtime && size == o.size; }
+  bool operator!=(const FileStamp& o) const { return !operator==(o); }
+};
+
+/// Returns false if the file can't be accessed.
+inline bool get_file_stamp(const std::string& path, FileStamp& stamp) {
+#if defined(_WIN32)
+  struct _stat64 st;
+# ifndef GEMMI_USE_FOPEN
+  if (::_wstat64(UTF8_to_wchar(path.c_str()).c_str(), &st) != 0)
+# else
+  if (::_stat64(path.c_str(), &st) != 0)
+# endif
+#else
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0)
+#endif
+    return false;
+  stamp.mtime = (int64_t) st.st_mtime;
+  stamp.size = (uint64_t) st.st_size;
+  return true;
+}
+
 inline bool is_little_endian() {
   std::uint32_t x = 1;
   return *reinterpret_cast<char *>(&x) == 1;
@@ -146,6 +174,25 @@ inline CharArray read_file_into_buffer(const std::string& path) {
   return buffer;
 }
 
+/// Read-only memory-mapped file. On Windows, the file is read into memory.
+class GEMMI_DLL MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() { close(); }
+  void open(const std::string& path);
+  void close();
+  const unsigned char* data() const { return data_; }
+  size_t size() const { return size_; }
+private:
+  const unsigned char* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(_WIN32)
+  CharArray buffer_;
+#endif
+};
+
 inline CharArray read_stdin_into_buffer() {
   size_t n = 0;
   CharArray buffer(16 * 1024);
@@ -1,13 +1,18 @@
 // Copyright 2020 Global Phasing Ltd.
 //
-// The flood fill (scanline fill) algorithm for Grid.
+// The flood fill (scanline fill) algorithm for Grid and connected-component
+// labeling with union-find (GridComponents).
 // Assumes periodic boundary conditions in the grid and 6-way connectivity.
 
 #ifndef GEMMI_FLOODFILL_HPP_
 #define GEMMI_FLOODFILL_HPP_
 
 #include <cstdint>     // for int8_t
+#include <algorithm>   // for upper_bound
+#include <array>
+#include <vector>
 #include "grid.hpp"    // for Grid
+#include "parallel.hpp"  // for parallel_for_each_index
 
 namespace gemmi {
 
@@ -131,6 +136,199 @@ private:
   }
 };
 
+/// Connected components (6-way connectivity, periodic boundaries) of grid
+/// points for which is_land(value) is true. Points are grouped into runs
+/// (continuous segments along u) and the runs are joined with union-find.
+/// Sections w are split into slabs that are labeled in parallel;
+/// then the slabs are joined. The components are not stored as lists
+/// of points, so the memory usage depends on the number of runs only.
+///
+/// The union-find tracks how the component is continued across the unit
+/// cell boundaries: a run unwrapped in the frame of its component's root
+/// starts at (u + shift[0]*nu, v + shift[1]*nv, w + shift[2]*nw).
+/// A component that is connected to its own periodic image is percolating.
+struct GridComponents {
+  struct Run {
+    int u, len, v, w;
+  };
+  int nu = 0, nv = 0, nw = 0;
+  std::vector<Run> runs;          // ordered as in the grid
+  std::vector<size_t> row_start;  // runs in row (v,w) start at [v + w*nv]
+  // after label(): parent[i] is the root (component id) of runs[i]
+  std::vector<int> parent;
+  std::vector<std::array<int,3>> shift;  // shift of runs[i] vs its root
+  std::vector<char> percolating;  // meaningful for roots
+
+  template<typename T, typename Pred>
+  void label(const Grid<T>& grid, Pred is_land, int n_threads=1) {
+    nu = grid.nu;
+    nv = grid.nv;
+    nw = grid.nw;
+    size_t n_rows = (size_t) nv * nw;
+    int n_slabs = std::min(normalize_thread_count(n_threads), nw);
+    auto slab_start = [&](size_t n) { return int(n * nw / n_slabs); };
+    auto find_runs = [&](int v, int w, Run* out) {
+      const T* row = &grid.data[grid.index_q(0, v, w)];
+      size_t n = 0;
+      for (int u = 0; u < nu; ++u)
+        if (is_land(row[u])) {
+          int start = u;
+          while (u + 1 < nu && is_land(row[u + 1]))
+            ++u;
+          if (out)
+            out[n] = {start, u + 1 - start, v, w};
+          ++n;
+        }
+      return n;
+    };
+    // count runs in each row, then store them
+    row_start.assign(n_rows + 1, 0);
+    parallel_for(n_rows, n_threads, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i != end; ++i)
+        row_start[i + 1] = find_runs(int(i % nv), int(i / nv), nullptr);
+    });
+    for (size_t i = 0; i != n_rows; ++i)
+      row_start[i + 1] += row_start[i];
+    runs.resize(row_start.back());
+    parallel_for(n_rows, n_threads, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i != end; ++i)
+        find_runs(int(i % nv), int(i / nv), &runs[row_start[i]]);
+    });
+    parent.resize(runs.size());
+    for (size_t i = 0; i != parent.size(); ++i)
+      parent[i] = (int) i;
+    shift.assign(runs.size(), {{0, 0, 0}});
+    percolating.assign(runs.size(), 0);
+    size_.assign(runs.size(), 1);
+
+    // join runs within slabs; only runs from the slab are modified
+    parallel_for_each_index(n_slabs, n_slabs, [&](size_t n) {
+      for (int w = slab_start(n); w < slab_start(n + 1); ++w)
+        for (int v = 0; v < nv; ++v) {
+          join_rows_u(v, w);
+          if (v != 0)
+            join_rows(v, w, v - 1, w, {{0, 0, 0}});
+          else
+            join_rows(0, w, nv - 1, w, {{0, -1, 0}});
+          if (w != slab_start(n))
+            join_rows(v, w, v, w - 1, {{0, 0, 0}});
+        }
+    });
+    // join slabs
+    for (int n = 0; n < n_slabs; ++n) {
+      int w = slab_start(n);
+      for (int v = 0; v < nv; ++v) {
+        if (w != 0)
+          join_rows(v, w, v, w - 1, {{0, 0, 0}});
+        else
+          join_rows(v, 0, v, nw - 1, {{0, 0, -1}});
+      }
+    }
+    // flatten
+    for (size_t i = 0; i != parent.size(); ++i) {
+      std::array<int,3> total;
+      parent[i] = find_root((int)i, total);
+      shift[i] = total;
+    }
+    for (size_t i = 0; i != parent.size(); ++i)
+      if (percolating[i])
+        percolating[parent[i]] = 1;
+    size_.clear();
+    size_.shrink_to_fit();
+  }
+
+  /// Returns index of the run that contains point (u,v,w) or -1.
+  int run_at(int u, int v, int w) const {
+    size_t row = (size_t) modulo(v, nv) + (size_t) modulo(w, nw) * nv;
+    u = modulo(u, nu);
+    auto begin = runs.begin() + row_start[row];
+    auto end = runs.begin() + row_start[row + 1];
+    auto it = std::upper_bound(begin, end, u,
+                               [](int x, const Run& r) { return x < r.u; });
+    if (it == begin || u >= (it - 1)->u + (it - 1)->len)
+      return -1;
+    return int(it - 1 - runs.begin());
+  }
+
+private:
+  std::vector<int> size_;  // used during labeling, for union by size
+
+  int find_root(int i, std::array<int,3>& total) {
+    total = {{0, 0, 0}};
+    int root = i;
+    while (parent[root] != root) {
+      for (int k = 0; k < 3; ++k)
+        total[k] += shift[root][k];
+      root = parent[root];
+    }
+    // path compression
+    std::array<int,3> rest = total;
+    while (parent[i] != i) {
+      int next = parent[i];
+      std::array<int,3> s = shift[i];
+      parent[i] = root;
+      shift[i] = rest;
+      for (int k = 0; k < 3; ++k)
+        rest[k] -= s[k];
+      i = next;
+    }
+    return root;
+  }
+
+  // b is adjacent to a when b is shifted by s (in unit cells)
+  void join(int a, int b, const std::array<int,3>& s) {
+    std::array<int,3> oa, ob, d;
+    int ra = find_root(a, oa);
+    int rb = find_root(b, ob);
+    for (int k = 0; k < 3; ++k)
+      d[k] = oa[k] + s[k] - ob[k];  // shift of rb in the frame of ra
+    if (ra == rb) {
+      if (d[0] != 0 || d[1] != 0 || d[2] != 0)
+        percolating[ra] = 1;
+      return;
+    }
+    if (size_[ra] < size_[rb]) {
+      std::swap(ra, rb);
+      for (int k = 0; k < 3; ++k)
+        d[k] = -d[k];
+    }
+    parent[rb] = ra;
+    shift[rb] = d;
+    size_[ra] += size_[rb];
+    percolating[ra] |= percolating[rb];
+  }
+
+  // the first and the last run in a row can be joined across u=0
+  void join_rows_u(int v, int w) {
+    size_t row = (size_t) v + (size_t) w * nv;
+    size_t begin = row_start[row], end = row_start[row + 1];
+    if (begin == end)
+      return;
+    const Run& first = runs[begin];
+    const Run& last = runs[end - 1];
+    if (first.u == 0 && last.u + last.len == nu)
+      join((int)(end - 1), (int)begin, {{1, 0, 0}});
+  }
+
+  // join overlapping runs from rows (v1,w1) and (v2,w2)
+  void join_rows(int v1, int w1, int v2, int w2, const std::array<int,3>& s) {
+    size_t row1 = (size_t) v1 + (size_t) w1 * nv;
+    size_t row2 = (size_t) v2 + (size_t) w2 * nv;
+    size_t i = row_start[row1], i_end = row_start[row1 + 1];
+    size_t j = row_start[row2], j_end = row_start[row2 + 1];
+    while (i < i_end && j < j_end) {
+      const Run& a = runs[i];
+      const Run& b = runs[j];
+      if (a.u < b.u + b.len && b.u < a.u + a.len)
+        join((int)i, (int)j, s);
+      if (a.u + a.len < b.u + b.len)
+        ++i;
+      else
+        ++j;
+    }
+  }
+};
+
 inline void mask_nodes_above_threshold(Grid<std::int8_t>& mask, const Grid<float>& grid,
                                        double threshold, bool negate=false) {
   mask.copy_metadata_from(grid);
@@ -147,14 +345,22 @@ inline Grid<std::int8_t> flood_fill_above(const Grid<float>& grid,
   grid.check_not_empty();
   Grid<std::int8_t> mask;
   mask_nodes_above_threshold(mask, grid, threshold, negate);
-  FloodFill<std::int8_t, 1> flood_fill{mask};
+  GridComponents components;
+  components.label(mask, [](std::int8_t x) { return x == 1; });
+  std::vector<char> selected(components.runs.size(), 0);
   for (const Position& pos : seeds) {
     auto point = mask.get_nearest_point(pos);
-    if (*point.value == 1)
-      flood_fill.find_all_connected_points(point.u, point.v, point.w);
+    int run = components.run_at(point.u, point.v, point.w);
+    if (run >= 0)
+      selected[components.parent[run]] = 1;
   }
-  for (std::int8_t& d : mask.data)
-    d = std::int8_t(d == flood_fill.this_island());
+  mask.fill(0);
+  for (size_t i = 0; i != components.runs.size(); ++i)
+    if (selected[components.parent[i]]) {
+      const GridComponents::Run& run = components.runs[i];
+      std::int8_t* ptr = &mask.data[mask.index_q(run.u, run.v, run.w)];
+      std::fill(ptr, ptr + run.len, (std::int8_t)1);
+    }
   return mask;
 }
 
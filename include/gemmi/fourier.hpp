@@ -11,6 +11,9 @@
 #include "math.hpp"      // for rad
 #include "symmetry.hpp"  // for GroupOps, Op
 #include "fail.hpp"      // for fail
+#ifdef GEMMI_PROFILE
+# include "profile.hpp"  // for GEMMI_PROFILE_SCOPE
+#endif
 
 #ifdef __MINGW32__  // MinGW may have problem with std::mutex etc
 # define POCKETFFT_CACHE_SIZE 0
@@ -234,6 +237,9 @@ ReciprocalGrid<T> get_value_on_grid(const DataProxy& data, size_t column,
 
 template<typename T>
 void transform_f_phi_grid_to_map_(FPhiGrid<T>&& hkl, Grid<T>& map) {
+#ifdef GEMMI_PROFILE
+  GEMMI_PROFILE_SCOPE("fft.f_phi_to_map");
+#endif
   // NaNs are not good for FFT, so we change them to 0.
   // x -> conj(x) is equivalent to changing axis direction before FFT.
   for (std::complex<T>& x : hkl.data)
@@ -314,6 +320,9 @@ Grid<T> transform_f_phi_to_map2(const FPhi& fphi,
 
 template<typename T>
 FPhiGrid<T> transform_map_to_f_phi(const Grid<T>& map, bool half_l, bool use_scale=true) {
+#ifdef GEMMI_PROFILE
+  GEMMI_PROFILE_SCOPE("fft.map_to_f_phi");
+#endif
   if (half_l && map.axis_order == AxisOrder::ZYX)
     fail("transform_map_to_f_phi(): half_l + ZYX order are not supported yet");
   FPhiGrid<T> hkl;
@@ -16,6 +16,7 @@
 #include "symmetry.hpp"
 #include "stats.hpp"  // for DataStats
 #include "fail.hpp"   // for fail
+#include "parallel.hpp"  // for parallel_for
 
 namespace gemmi {
 
@@ -553,6 +554,119 @@ struct Grid : GridBase<T> {
     return interpolate_value(unit_cell.fractionalize(ctr), order);
   }
 
+  /// Batch version of interpolate_value(). Interpolates values at n points
+  /// xyz[0..n) and stores them in out[0..n). Points are converted to
+  /// fractional coordinates with to_frac (by default with unit_cell.frac,
+  /// i.e. xyz are Cartesian positions). The conversion to grid coordinates
+  /// is combined into one transformation for the whole batch.
+  /// If grad is not null, it gets gradients d(value)/d(xyz) for order 1 and 3.
+  void interpolate_position_array(const Vec3* xyz, size_t n, T* out, int order=1,
+                                  const Transform* to_frac=nullptr,
+                                  Vec3* grad=nullptr) const {
+    this->check_not_empty();
+    const Transform& frac = to_frac ? *to_frac : unit_cell.frac;
+    Transform to_grid = frac;
+    for (int i = 0; i < 3; ++i) {
+      double ni = i == 0 ? nu : i == 1 ? nv : nw;
+      for (int j = 0; j < 3; ++j)
+        to_grid.mat[i][j] *= ni;
+      to_grid.vec.at(i) *= ni;
+    }
+    switch (order) {
+      case 0:
+        if (this->axis_order != AxisOrder::XYZ)
+          fail("grid is not fully setup");
+        if (grad)
+          fail("interpolate_position_array(): no gradient for order 0");
+        for (size_t i = 0; i < n; ++i) {
+          Vec3 g = to_grid.apply(xyz[i]);
+          out[i] = data[this->index_q(modulo(iround(g.x), nu),
+                                      modulo(iround(g.y), nv),
+                                      modulo(iround(g.z), nw))];
+        }
+        return;
+      case 1:
+        if (grad)
+          interpolate_array_<2, true>(xyz, n, to_grid, out, grad);
+        else
+          interpolate_array_<2, false>(xyz, n, to_grid, out, nullptr);
+        return;
+      case 3:
+        if (grad)
+          interpolate_array_<4, true>(xyz, n, to_grid, out, grad);
+        else
+          interpolate_array_<4, false>(xyz, n, to_grid, out, nullptr);
+        return;
+    }
+    throw std::invalid_argument("interpolation \"order\" must 0, 1 or 3");
+  }
+
+  /// @private  weights of 2 points in linear interpolation
+  static void interpolation_weights(double r, double (&w)[2], double (&d)[2]) {
+    w[0] = 1 - r;
+    w[1] = r;
+    d[0] = -1;
+    d[1] = 1;
+  }
+  /// @private  the same as cubic_interpolation() and cubic_interpolation_der(),
+  /// but as weights of 4 points
+  static void interpolation_weights(double r, double (&w)[4], double (&d)[4]) {
+    double r2 = r * r;
+    w[0] = -0.5 * r * ((r - 2) * r + 1);
+    w[1] = 0.5 * ((3 * r - 5) * r2 + 2);
+    w[2] = -0.5 * r * ((3 * r - 4) * r - 1);
+    w[3] = 0.5 * (r - 1) * r2;
+    d[0] = -1.5 * r2 + 2 * r - 0.5;
+    d[1] = 4.5 * r2 - 5 * r;
+    d[2] = -4.5 * r2 + 4 * r + 0.5;
+    d[3] = 1.5 * r2 - r;
+  }
+
+  /// @private  K=2 - trilinear, K=4 - tricubic interpolation
+  template<int K, bool Der>
+  void interpolate_array_(const Vec3* xyz, size_t n, const Transform& to_grid,
+                          T* out, Vec3* grad) const {
+    const int dims[3] = {nu, nv, nw};
+    for (size_t p = 0; p < n; ++p) {
+      Vec3 g = to_grid.apply(xyz[p]);
+      int idx[3][K];
+      double wt[3][K];
+      double der[3][K];
+      for (int a = 0; a < 3; ++a) {
+        double f = std::floor(g.at(a));
+        int t = modulo((int)f - (K == 4 ? 1 : 0), dims[a]);
+        for (int k = 0; k < K; ++k) {
+          idx[a][k] = t;
+          if (++t == dims[a])
+            t = 0;
+        }
+        interpolation_weights(g.at(a) - f, wt[a], der[a]);
+      }
+      double sum = 0, du = 0, dv = 0, dw = 0;
+      for (int kw = 0; kw < K; ++kw)
+        for (int kv = 0; kv < K; ++kv) {
+          const T* row = &data[this->index_q(0, idx[1][kv], idx[2][kw])];
+          double s = 0, ds = 0;
+          for (int ku = 0; ku < K; ++ku) {
+            double x = row[idx[0][ku]];
+            s += wt[0][ku] * x;
+            if (Der)
+              ds += der[0][ku] * x;
+          }
+          double wvw = wt[1][kv] * wt[2][kw];
+          sum += wvw * s;
+          if (Der) {
+            du += wvw * ds;
+            dv += der[1][kv] * wt[2][kw] * s;
+            dw += wt[1][kv] * der[2][kw] * s;
+          }
+        }
+      out[p] = (T) sum;
+      if (Der)
+        grad[p] = to_grid.mat.left_multiply(Vec3(du, dv, dw));
+    }
+  }
+
   void get_subarray(T* dest, std::array<int,3> start, std::array<int,3> shape) const {
     this->check_not_empty();
     if (this->axis_order != AxisOrder::XYZ)
@@ -717,14 +831,72 @@ struct Grid : GridBase<T> {
   /// grid point, then assign the result to all the points.
   /// \par func takes two values and returns a value.
   template<typename Func>
-  void symmetrize(Func func) {
-    symmetrize_using_ops(this->get_scaled_ops_except_id(), func);
+  void symmetrize(Func func, int n_threads=1) {
+    symmetrize_using_ops(this->get_scaled_ops_except_id(), func, n_threads);
   }
 
+  /// With n_threads != 1, each orbit of symmetry-equivalent points is
+  /// processed by the thread that handles its first point (the point with
+  /// the lowest index), which gives the same result as the serial version.
   template<typename Func>
-  void symmetrize_using_ops(const std::vector<GridOp>& ops, Func func) {
+  void symmetrize_using_ops(const std::vector<GridOp>& ops, Func func,
+                            int n_threads=1) {
     if (ops.empty())
       return;
+    if (n_threads != 1) {
+      // Without the visited array, an incompatible grid is detected
+      // by checking that the operations are closed under composition.
+      auto same = [&](const Op& x, const Op& y) {
+        return x.rot == y.rot && modulo(x.tran[0] - y.tran[0], nu) == 0 &&
+                                 modulo(x.tran[1] - y.tran[1], nv) == 0 &&
+                                 modulo(x.tran[2] - y.tran[2], nw) == 0;
+      };
+      Op id{{{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}}, {{0, 0, 0}}, ' '};
+      for (const GridOp& a : ops)
+        for (const GridOp& b : ops) {
+          const Op& x = a.scaled_op;
+          const Op& y = b.scaled_op;
+          Op xy = id;
+          for (int i = 0; i != 3; ++i) {
+            xy.tran[i] = x.tran[i];
+            for (int j = 0; j != 3; ++j) {
+              xy.rot[i][j] = x.rot[i][0] * y.rot[0][j] + x.rot[i][1] * y.rot[1][j]
+                           + x.rot[i][2] * y.rot[2][j];
+              xy.tran[i] += x.rot[i][j] * y.tran[j];
+            }
+          }
+          if (!same(xy, id) &&
+              std::none_of(ops.begin(), ops.end(),
+                           [&](const GridOp& c) { return same(xy, c.scaled_op); }))
+            fail("grid size is not compatible with space group");
+        }
+      parallel_for(nw, n_threads, [&](size_t w_begin, size_t w_end) {
+        std::vector<size_t> mates(ops.size(), 0);
+        for (int w = (int) w_begin; w != (int) w_end; ++w)
+          for (int v = 0; v != nv; ++v)
+            for (int u = 0; u != nu; ++u) {
+              size_t idx = this->index_q(u, v, w);
+              bool first = true;
+              for (size_t k = 0; k < ops.size(); ++k) {
+                std::array<int,3> t = ops[k].apply(u, v, w);
+                mates[k] = this->index_n(t[0], t[1], t[2]);
+                if (mates[k] < idx) {
+                  first = false;
+                  break;
+                }
+              }
+              if (!first)
+                continue;
+              T value = data[idx];
+              for (size_t k : mates)
+                value = func(value, data[k]);
+              data[idx] = value;
+              for (size_t k : mates)
+                data[k] = value;
+            }
+      });
+      return;
+    }
     std::vector<size_t> mates(ops.size(), 0);
     std::vector<signed char> visited(data.size(), 0);  // faster than vector<bool>
     size_t idx = 0;
@@ -791,17 +963,23 @@ struct Grid : GridBase<T> {
 // TODO: add argument Box<Fractional> src_extent
 // cf. interpolate_grid_around_model() in solmask.hpp
 // cf interpolate_values in python/grid.cpp
+/// Rows of dest (along u) are interpolated in batches,
+/// sections (along w) are distributed between n_threads threads.
 template<typename T>
-void interpolate_grid(Grid<T>& dest, const Grid<T>& src, const Transform& tr, int order=1) {
+void interpolate_grid(Grid<T>& dest, const Grid<T>& src, const Transform& tr,
+                      int order=1, int n_threads=1) {
+  src.check_not_empty();
   FTransform frac_tr = src.unit_cell.frac.combine(tr).combine(dest.unit_cell.orth);
-  size_t idx = 0;
-  for (int w = 0; w != dest.nw; ++w)
-    for (int v = 0; v != dest.nv; ++v)
-      for (int u = 0; u != dest.nu; ++u, ++idx) {
-        Fractional dest_fr = dest.get_fractional(u, v, w);
-        Fractional src_fr = frac_tr.apply(dest_fr);
-        dest.data[idx] = src.interpolate_value(src_fr, order);
+  parallel_for(dest.nw, n_threads, [&](size_t w_begin, size_t w_end) {
+    std::vector<Vec3> row(dest.nu);
+    for (int w = (int) w_begin; w != (int) w_end; ++w)
+      for (int v = 0; v != dest.nv; ++v) {
+        for (int u = 0; u != dest.nu; ++u)
+          row[u] = dest.get_fractional(u, v, w);
+        T* out = &dest.data[dest.index_q(0, v, w)];
+        src.interpolate_position_array(row.data(), row.size(), out, order, &frac_tr);
       }
+  });
 }
 
 template<typename T>
@@ -89,16 +89,20 @@ struct LinkHunt {
     monlib_ptr = &monlib;
   }
 
+  // If ns_cache is given, the neighbor search is taken from (or stored in) it.
   std::vector<Match> find_possible_links(Structure& st,
                                          double bond_margin,
                                          double radius_margin,
-                                         ContactSearch::Ignore ignore) {
+                                         ContactSearch::Ignore ignore,
+                                         NeighborSearchCache* ns_cache=nullptr) {
     std::vector<Match> results;
     Model& model = st.first_model();
     double search_radius = std::max(global_max_dist * bond_margin,
                                     /*max r1+r2 ~=*/3.0 * radius_margin);
-    NeighborSearch ns(model, st.cell, std::max(5.0, search_radius));
-    ns.populate();
+    NeighborSearchCache local_cache(std::max(5.0, search_radius));
+    if (!ns_cache)
+      ns_cache = &local_cache;
+    NeighborSearch& ns = ns_cache->get(model, st.cell, search_radius);
 
     ContactSearch contacts((float) search_radius);
     contacts.ignore = ignore;
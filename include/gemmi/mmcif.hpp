@@ -6,6 +6,7 @@
 #define GEMMI_MMCIF_HPP_
 
 #include <string>
+#include <vector>
 #include "cifdoc.hpp"      // for Block, etc
 #include "fail.hpp"        // for fail
 #include "model.hpp"       // for Structure
@@ -29,6 +30,25 @@ inline Structure make_structure(cif::Document&& doc, cif::Document* save_doc=nul
   return st;
 }
 
+/// Reads mmJSON directly into Structure (modifying the buffer).
+/// Gives the same result as make_structure(cif::read_mmjson_insitu(...)),
+/// but _atom_site values are not copied into cif::Document.
+GEMMI_DLL Structure make_structure_from_mmjson_insitu(char* buffer, std::size_t size,
+                                                      const std::string& name="mmJSON");
+
+namespace impl {
+// Category stored by columns, with values that are not in cif::Document:
+// NUL-terminated and unquoted strings; nullptr stands for null ('?').
+// Used when reading _atom_site from mmJSON.
+struct ColumnTable {
+  std::vector<std::string> tags;  // without category, e.g. "Cartn_x"
+  std::vector<std::vector<const char*>> columns;
+};
+// the same as make_structure_from_block(), but _atom_site is taken from atom_site
+GEMMI_DLL Structure make_structure_from_block_and_columns(const cif::Block& block,
+                                                          const ColumnTable& atom_site);
+} // namespace impl
+
 // Reading chemical component as a coordinate file.
 enum class ChemCompModel {
   Xyz      = 1, // _chem_comp_atom.x, etc
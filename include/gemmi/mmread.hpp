@@ -5,6 +5,7 @@
 #ifndef GEMMI_MMREAD_HPP_
 #define GEMMI_MMREAD_HPP_
 
+#include "binfile.hpp"   // for read_binary_structure_from_memory
 #include "cif.hpp"       // for cif::read
 #include "fail.hpp"      // for fail
 #include "input.hpp"     // for BasicInput
@@ -23,11 +24,15 @@ inline CoorFormat coor_format_from_ext(const std::string& path) {
     return CoorFormat::Mmcif;
   if (iends_with(path, ".json"))
     return CoorFormat::Mmjson;
+  if (iends_with(path, ".bin"))
+    return CoorFormat::Binary;
   return CoorFormat::Unknown;
 }
 
 // If it's neither CIF nor JSON nor almost empty - we assume PDB.
 inline CoorFormat coor_format_from_content(const char* buf, const char* end) {
+  if (is_gemmi_binary(buf, end - buf))
+    return CoorFormat::Binary;
   while (buf < end - 8) {
     if (std::isspace(*buf)) {
       ++buf;
@@ -70,8 +75,13 @@ inline Structure read_structure_from_memory(char* data, size_t size,
   if (format == CoorFormat::Mmcif)
     return make_structure_from_doc(cif::read_memory(data, size, path.c_str()),
                                    true, save_doc);
-  if (format == CoorFormat::Mmjson)
+  if (format == CoorFormat::Mmjson) {
+    if (!save_doc)
+      return make_structure_from_mmjson_insitu(data, size, path);
     return make_structure(cif::read_mmjson_insitu(data, size, path), save_doc);
+  }
+  if (format == CoorFormat::Binary)
+    return read_binary_structure_from_memory(data, size, path);
   fail("wrong format of coordinate file " + path);
 }
 
@@ -99,12 +109,23 @@ Structure read_structure(T&& input, CoorFormat format=CoorFormat::Unknown,
     case CoorFormat::Mmcif:
       return make_structure(cif::read(input), save_doc);
     case CoorFormat::Mmjson: {
+      if (!save_doc) {
+        std::string name = input.is_stdin() ? "stdin" : input.path();
+        CharArray buffer = read_into_buffer(input);
+        return make_structure_from_mmjson_insitu(buffer.data(), buffer.size(), name);
+      }
       Structure st = make_structure(cif::read_mmjson(input), save_doc);
       st.input_format = CoorFormat::Mmjson;
       return st;
     }
     case CoorFormat::ChemComp:
       return make_structure_from_chemcomp_doc(cif::read(input), save_doc);
+    case CoorFormat::Binary: {
+      // save_doc was cleared above, as in read_structure_gz()
+      std::string name = input.is_stdin() ? "stdin" : input.path();
+      CharArray buffer = read_into_buffer(input);
+      return read_binary_structure_from_memory(buffer.data(), buffer.size(), name);
+    }
     case CoorFormat::Unknown:
     case CoorFormat::Detect:
       fail("Unknown format of " +
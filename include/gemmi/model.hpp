@@ -86,7 +86,7 @@ template<typename T, typename M> std::vector<T> model_subchains(M* model) {
 /// Unknown = guess format from the extension,
 /// Detect = guess format from the content.
 enum class CoorFormat : unsigned char {
-  Unknown, Detect, Pdb, Mmcif, Mmjson, ChemComp
+  Unknown, Detect, Pdb, Mmcif, Mmjson, ChemComp, Binary
 };
 
 /// corresponds to _atom_site.calc_flag in mmCIF
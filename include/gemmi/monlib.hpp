@@ -63,7 +63,7 @@ struct GEMMI_DLL ChemMod {
     int func;
     std::string old_id;
     std::string new_id;
-    Element el;
+    Element el = El::X;
     float charge;
     std::string chem_type;
   };
@@ -82,7 +82,7 @@ struct GEMMI_DLL ChemMod {
 struct EnerLib {
   enum class RadiusType {Vdw, Vdwh, Ion};
   struct Atom {
-    Element element;
+    Element element = El::X;
     char hb_type;
     double vdw_radius;
     double vdwh_radius;
@@ -103,6 +103,15 @@ struct EnerLib {
   std::multimap<std::string, Bond> bonds; // atom_type_1->Bond
 };
 
+/// Monomers, links and modifications parsed from one cif::Document,
+/// before they are added to MonLib. Stored in the binary cache.
+struct MonLibDocContent {
+  std::vector<std::pair<std::string, ChemComp::Group>> cc_groups;
+  std::vector<ChemComp> monomers;  // ChemComp::group not updated from cc_groups
+  std::vector<ChemLink> links;
+  std::vector<ChemMod> modifications;
+};
+
 struct GEMMI_DLL MonLib {
   std::string monomer_dir;
   std::map<std::string, ChemComp> monomers;
@@ -212,7 +221,14 @@ struct GEMMI_DLL MonLib {
 
   static std::string relative_monomer_path(const std::string& code);
 
-  void read_monomer_doc(const cif::Document& doc);
+  static MonLibDocContent parse_monomer_doc(const cif::Document& doc);
+
+  /// Adds items that are not already present (as read_monomer_doc() does).
+  void add_monomer_doc_content(MonLibDocContent&& content);
+
+  void read_monomer_doc(const cif::Document& doc) {
+    add_monomer_doc_content(parse_monomer_doc(doc));
+  }
 
   void read_monomer_cif(const std::string& path_);
 
@@ -224,9 +240,14 @@ struct GEMMI_DLL MonLib {
 
   /// Read mon_lib_list.cif, ener_lib.cif and required monomers.
   /// Returns true if all requested monomers were added.
+  /// If cache_path is given, the parsed files are stored in a binary cache
+  /// file and taken from there in the next calls, as long as the size and
+  /// modification time of the source files don't change. The cache file
+  /// is created or updated automatically.
   bool read_monomer_lib(const std::string& monomer_dir_,
                         const std::vector<std::string>& resnames,
-                        const Logger& logger);
+                        const Logger& logger,
+                        const std::string& cache_path=std::string());
 
   double find_ideal_distance(const const_CRA& cra1, const const_CRA& cra2) const;
   void update_old_atom_names(Structure& st, const Logger& logger) const;
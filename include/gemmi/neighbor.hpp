@@ -7,7 +7,8 @@
 #define GEMMI_NEIGHBOR_HPP_
 
 #include <vector>
-#include <cmath>  // for INFINITY, sqrt
+#include <cmath>    // for INFINITY, sqrt
+#include <memory>   // for unique_ptr
 
 #include "fail.hpp"      // for fail
 #include "grid.hpp"
@@ -72,11 +73,22 @@ struct NeighborSearch {
     grid.unit_cell = small_st.cell;
     set_grid_size();
   }
+  /// Non-periodic search in the given box, for atoms that are not stored
+  /// in a Model (such as copies in InstancedAssembly from assembly.hpp).
+  /// populate() can't be used; marks are added with add_position().
+  NeighborSearch(const Box<Position>& box, double radius) {
+    radius_specified = radius;
+    use_pbc = false;
+    set_box(box);
+    set_grid_size();
+  }
 
   NeighborSearch& populate(bool include_h_=true);
   void add_chain(const Chain& chain, bool include_h_=true);
   void add_chain_n(const Chain& chain, int n_ch);
   void add_atom(const Atom& atom, int n_ch, int n_res, int n_atom);
+  void add_position(const Position& pos, char altloc, El el,
+                    int n_ch, int n_res, int n_atom);
   void add_site(const SmallStructure::Site& site, int n);
 
   // assumes data in [0, 1), but uses index_n to account for numerical errors
@@ -203,6 +215,14 @@ private:
                                    std::max(int(inv_radius / uc.cr), 1));
   }
 
+  void set_box(Box<Position> box) {
+    box.add_margin(0.01);
+    Position size = box.get_size();
+    grid.unit_cell.set(size.x, size.y, size.z, 90, 90, 90);
+    grid.unit_cell.frac.vec -= grid.unit_cell.fractionalize(box.minimum);
+    grid.unit_cell.orth.vec += box.minimum;
+  }
+
   void set_bounding_cell(const UnitCell& cell) {
     use_pbc = cell.is_crystal();
     if (use_pbc) {
@@ -223,11 +243,7 @@ private:
           for (const Transform& tr : ncs)
             box.extend(Position(tr.apply(cra.atom->pos)));
       }
-      box.add_margin(0.01);
-      Position size = box.get_size();
-      grid.unit_cell.set(size.x, size.y, size.z, 90, 90, 90);
-      grid.unit_cell.frac.vec -= grid.unit_cell.fractionalize(box.minimum);
-      grid.unit_cell.orth.vec += box.minimum;
+      set_box(box);
       for (const Transform& tr : ncs) {
         UnitCell& c = grid.unit_cell;
         // cf. add_ncs_images_to_cs_images()
@@ -297,6 +313,15 @@ inline void NeighborSearch::add_atom(const Atom& atom,
   }
 }
 
+inline void NeighborSearch::add_position(const Position& pos, char altloc, El el,
+                                         int n_ch, int n_res, int n_atom) {
+  Fractional frac = grid.unit_cell.fractionalize(pos);
+  if (use_pbc)
+    frac = frac.wrap_to_unit();
+  get_subcell(frac).emplace_back(use_pbc ? grid.unit_cell.orthogonalize(frac) : pos,
+                                 altloc, el, 0, n_ch, n_res, n_atom);
+}
+
 // We exclude special position images of atoms here, but not in add_atom.
 // This choice is somewhat arbitrary, but it also reflects the fact that
 // in MX files occupances of atoms on special positions are (almost always)
@@ -372,5 +397,37 @@ void NeighborSearch::for_each_cell(const Position& pos, const Func& func, int k)
   }
 }
 
+/// NeighborSearch shared by analyses that run one after another on the same
+/// model (contacts, link finding, ...), so that the cell lists are built once.
+/// get() rebuilds the search only if it's called with a different model or
+/// needs a larger radius. The cache doesn't track changes in the model:
+/// call invalidate() after adding, removing or moving atoms, or after
+/// changing the unit cell. The search includes hydrogens.
+struct NeighborSearchCache {
+  /// The search is built with this radius (or with larger min_radius passed
+  /// to get()). Larger radius can be used in queries anyway, at some cost.
+  double radius = 5.0;
+  /// How many times NeighborSearch was built.
+  int build_count = 0;
+
+  NeighborSearchCache() = default;
+  explicit NeighborSearchCache(double radius_) : radius(radius_) {}
+
+  NeighborSearch& get(Model& model, const UnitCell& cell, double min_radius=0.) {
+    if (!ns_ || ns_->model != &model || ns_->radius_specified < min_radius) {
+      ns_.reset(new NeighborSearch(model, cell, std::max(radius, min_radius)));
+      ns_->populate();
+      ++build_count;
+    }
+    return *ns_;
+  }
+
+  /// The next get() will build the search again.
+  void invalidate() { ns_.reset(); }
+
+private:
+  std::unique_ptr<NeighborSearch> ns_;
+};
+
 } // namespace gemmi
 #endif
@@ -16,9 +16,8 @@
 namespace gemmi {
 namespace cif {
 
-inline double as_number(const std::string& s, double nan=NAN) {
-  const char* start = s.data();
-  const char* end = s.data() + s.size();
+// the string must be followed by a character other than '(' (usually NUL)
+inline double as_number(const char* start, const char* end, double nan=NAN) {
   if (*start == '+')
     ++start;
   // NaN, Inf and -Inf are not allowed in CIF
@@ -40,6 +39,10 @@ inline double as_number(const std::string& s, double nan=NAN) {
   return result.ptr == end ? d : nan;
 }
 
+inline double as_number(const std::string& s, double nan=NAN) {
+  return as_number(s.data(), s.data() + s.size(), nan);
+}
+
 inline bool is_numb(const std::string& s) {
   return !std::isnan(as_number(s));
 }
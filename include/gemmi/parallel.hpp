@@ -0,0 +1,158 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Minimal helpers for running loops on multiple threads (std::thread).
+
+#ifndef GEMMI_PARALLEL_HPP_
+#define GEMMI_PARALLEL_HPP_
+
+#include <cstddef>    // for size_t
+#include <algorithm>  // for min
+#include <atomic>
+#include <exception>  // for exception_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "logger.hpp"  // for Logger
+
+namespace gemmi {
+
+/// Returns n if n > 0, otherwise the number of hardware threads (at least 1).
+inline int normalize_thread_count(int n) {
+  if (n > 0)
+    return n;
+  unsigned hw = std::thread::hardware_concurrency();
+  return hw != 0 ? (int) hw : 1;
+}
+
+/// @private
+struct ParallelErrors {
+  std::exception_ptr eptr;
+  std::mutex mutex;
+  void store() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!eptr)
+      eptr = std::current_exception();
+  }
+  void rethrow() {
+    if (eptr)
+      std::rethrow_exception(eptr);
+  }
+};
+
+/// Splits [0, size) into up to n_threads contiguous chunks and calls
+/// func(begin, end) for each chunk in a separate thread.
+/// If n_threads <= 0, the number of hardware threads is used.
+/// With a single chunk, func is called in the current thread.
+/// An exception thrown by func is re-thrown in the calling thread.
+template<typename Func>
+void parallel_for(size_t size, int n_threads, Func&& func) {
+  size_t n = std::min((size_t) normalize_thread_count(n_threads), size);
+  if (n <= 1) {
+    if (size != 0)
+      func((size_t)0, size);
+    return;
+  }
+  ParallelErrors errors;
+  std::vector<std::thread> threads;
+  threads.reserve(n - 1);
+  auto run = [&](size_t begin, size_t end) {
+    try {
+      func(begin, end);
+    } catch (...) {
+      errors.store();
+    }
+  };
+  size_t step = size / n;
+  size_t rem = size % n;
+  size_t begin = 0;
+  for (size_t i = 0; i != n; ++i) {
+    size_t end = begin + step + (i < rem ? 1 : 0);
+    if (i + 1 == n)
+      run(begin, end);
+    else
+      threads.emplace_back(run, begin, end);
+    begin = end;
+  }
+  for (std::thread& t : threads)
+    t.join();
+  errors.rethrow();
+}
+
+/// Calls func(i) for each i in [0, size). Items are handed out dynamically
+/// (from a shared atomic counter), so it suits items of uneven cost.
+/// Errors are handled as in parallel_for().
+template<typename Func>
+void parallel_for_each_index(size_t size, int n_threads, Func&& func) {
+  size_t n = std::min((size_t) normalize_thread_count(n_threads), size);
+  if (n <= 1) {
+    for (size_t i = 0; i < size; ++i)
+      func(i);
+    return;
+  }
+  ParallelErrors errors;
+  std::atomic<size_t> counter{0};
+  auto run = [&]() {
+    try {
+      for (;;) {
+        size_t i = counter.fetch_add(1, std::memory_order_relaxed);
+        if (i >= size)
+          break;
+        func(i);
+      }
+    } catch (...) {
+      errors.store();
+      counter.store(size);  // make the other threads stop early
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(n - 1);
+  for (size_t i = 0; i + 1 < n; ++i)
+    threads.emplace_back(run);
+  run();
+  for (std::thread& t : threads)
+    t.join();
+  errors.rethrow();
+}
+
+/// Calls func(n, chunk_logger) for each chunk n in [0, n_chunks), in parallel.
+/// Messages sent to chunk_logger are buffered and passed to logger in the
+/// order of chunks, as if the chunks were processed serially. Similarly,
+/// an exception from func is re-thrown after the messages from preceding
+/// chunks, and the first (in chunk order) exception wins.
+/// With a single chunk, func(0, logger) is called in the current thread.
+template<typename Func>
+void parallel_chunks_with_logger(size_t n_chunks, int n_threads,
+                                 const Logger& logger, Func&& func) {
+  if (n_chunks <= 1) {
+    if (n_chunks != 0)
+      func((size_t)0, logger);
+    return;
+  }
+  struct ChunkLog {
+    std::vector<std::string> messages;
+    std::exception_ptr eptr;
+  };
+  std::vector<ChunkLog> logs(n_chunks);
+  parallel_for_each_index(n_chunks, n_threads, [&](size_t n) {
+    Logger chunk_logger;
+    chunk_logger.threshold = logger.threshold;
+    if (logger.callback)
+      chunk_logger.callback = [&logs, n](const std::string& s) {
+        logs[n].messages.push_back(s);
+      };
+    try {
+      func(n, chunk_logger);
+    } catch (...) {
+      logs[n].eptr = std::current_exception();
+    }
+  });
+  for (ChunkLog& log : logs) {
+    for (const std::string& msg : log.messages)
+      logger.callback(msg);
+    if (log.eptr)
+      std::rethrow_exception(log.eptr);
+  }
+}
+
+} // namespace gemmi
+#endif
@@ -0,0 +1,110 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Optional instrumentation: scoped timers and counters.
+// Instrumentation points (GEMMI_PROFILE_SCOPE and GEMMI_PROFILE_COUNT)
+// are compiled in only if GEMMI_PROFILE is defined (CMake option
+// GEMMI_PROFILE), and record data only after Profiler::enable().
+// Header-only code includes this file only if GEMMI_PROFILE is defined.
+// The results can be written as JSON summary or in the Chrome trace format
+// (to be viewed in chrome://tracing or https://ui.perfetto.dev).
+
+#ifndef GEMMI_PROFILE_HPP_
+#define GEMMI_PROFILE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>   // for int64_t, uint32_t
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>    // for thread::id
+#include <vector>
+#include "fail.hpp"  // for GEMMI_DLL
+
+namespace gemmi {
+
+/// Collects timings and counters from all threads (a single global instance).
+/// Names passed to Profiler must be string literals (only pointers are stored).
+class GEMMI_DLL Profiler {
+public:
+  using Clock = std::chrono::steady_clock;
+  struct Event {
+    const char* name;
+    int64_t start_ns;     // since origin
+    int64_t duration_ns;
+    uint32_t thread;      // small integer, 0 = the first thread seen
+  };
+
+  static Profiler& instance();
+  /// Whether the library itself was compiled with GEMMI_PROFILE.
+  static bool compiled_in();
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void enable(bool on=true);
+  /// Removes recorded data and resets the time origin.
+  void clear();
+
+  void add_event(const char* name, Clock::time_point start, Clock::time_point end);
+  void add_count(const char* name, int64_t n);
+
+  std::vector<Event> events() const;
+  std::map<std::string, int64_t> counters() const;
+
+  /// {"timers": {name: {"calls": N, "total_s": T, "max_s": M}, ...},
+  ///  "counters": {name: N, ...}}
+  std::string summary_json() const;
+  /// JSON object format of the Trace Event Format: complete ("X") events
+  /// for timers and one counter ("C") event per counter.
+  std::string chrome_trace_json() const;
+  /// Writes chrome_trace_json() if chrome_trace is true, otherwise summary_json().
+  void write_file(const std::string& path, bool chrome_trace) const;
+
+private:
+  Profiler() : origin_(Clock::now()) {}
+  uint32_t thread_number();
+
+  std::atomic<bool> enabled_{false};
+  mutable std::mutex mutex_;
+  Clock::time_point origin_;
+  std::vector<Event> events_;
+  std::map<std::string, int64_t> counters_;
+  std::vector<std::thread::id> threads_;
+};
+
+/// Records the time between construction and destruction as an event,
+/// if the profiler is enabled. Normally used through GEMMI_PROFILE_SCOPE.
+class ProfileScope {
+public:
+  explicit ProfileScope(const char* name)
+    : name_(Profiler::instance().enabled() ? name : nullptr) {
+    if (name_)
+      start_ = Profiler::Clock::now();
+  }
+  ~ProfileScope() {
+    if (name_)
+      Profiler::instance().add_event(name_, start_, Profiler::Clock::now());
+  }
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+  const char* name_;
+  Profiler::Clock::time_point start_;
+};
+
+} // namespace gemmi
+
+#ifdef GEMMI_PROFILE
+# define GEMMI_PROFILE_CAT_(a, b) a##b
+# define GEMMI_PROFILE_CAT(a, b) GEMMI_PROFILE_CAT_(a, b)
+# define GEMMI_PROFILE_SCOPE(name) \
+    gemmi::ProfileScope GEMMI_PROFILE_CAT(gemmi_profile_scope_, __LINE__)(name)
+# define GEMMI_PROFILE_COUNT(name, n) do { \
+    if (gemmi::Profiler::instance().enabled()) \
+      gemmi::Profiler::instance().add_count(name, (int64_t)(n)); \
+  } while (0)
+#else
+# define GEMMI_PROFILE_SCOPE(name) (void)0
+# define GEMMI_PROFILE_COUNT(name, n) (void)0
+#endif
+
+#endif
@@ -78,6 +78,7 @@
 
 #include <cmath>         // for fabs, sqrt
 #include <cstdio>        // for fprintf (it's temporary)
+#include <vector>
 #include "math.hpp"      // for Mat33
 #include "unitcell.hpp"  // for Position
 
@@ -116,12 +117,9 @@ inline double qcp_inner_product(Mat33& mat,
   return (G1 + G2) * 0.5;
 }
 
-// helper function
-inline int fast_calc_rmsd_and_rotation(Mat33* rot, const Mat33& A, double *rmsd,
-                                       double E0, double len, double min_score) {
-  const double evecprec = 1e-6;
-  const double evalprec = 1e-11;
-
+// helper function, calculates coefficients of the characteristic polynomial
+// x^4 + C[2] x^2 + C[1] x + C[0] (the largest root is the max eigenvalue)
+inline void qcp_characteristic_polynomial(const Mat33& A, double* C) {
   double Sxx, Sxy, Sxz, Syx, Syy, Syz, Szx, Szy, Szz;
   Sxx = A[0][0]; Sxy = A[0][1]; Sxz = A[0][2];
   Syx = A[1][0]; Syy = A[1][1]; Syz = A[1][2];
@@ -142,7 +140,6 @@ inline int fast_calc_rmsd_and_rotation(Mat33* rot, const Mat33& A, double *rmsd,
   double SyzSzymSyySzz2 = 2.0 * (Syz*Szy - Syy*Szz);
   double Sxx2Syy2Szz2Syz2Szy2 = Syy2 + Szz2 - Sxx2 + Syz2 + Szy2;
 
-  double C[4];
   C[2] = -2.0 * (Sxx2 + Syy2 + Szz2 + Sxy2 + Syx2 + Sxz2 + Szx2 + Syz2 + Szy2);
   C[1] = 8.0 * (Sxx*Syz*Szy + Syy*Szx*Sxz + Szz*Sxy*Syx - Sxx*Syy*Szz - Syz*Szx*Sxy - Szy*Syx*Sxz);
 
@@ -162,6 +159,30 @@ inline int fast_calc_rmsd_and_rotation(Mat33* rot, const Mat33& A, double *rmsd,
     + (-(SxzpSzx)*(SyzpSzy)-(SxypSyx)*(SxxpSyy-Szz)) * (-(SxzmSzx)*(SyzmSzy)-(SxypSyx)*(SxxpSyy+Szz))
     + (+(SxypSyx)*(SyzpSzy)+(SxzpSzx)*(SxxmSyy+Szz)) * (-(SxymSyx)*(SyzmSzy)+(SxzpSzx)*(SxxpSyy+Szz))
     + (+(SxypSyx)*(SyzmSzy)+(SxzmSzx)*(SxxmSyy-Szz)) * (-(SxymSyx)*(SyzpSzy)+(SxzmSzx)*(SxxpSyy-Szz));
+}
+
+// helper function
+inline int fast_calc_rmsd_and_rotation(Mat33* rot, const Mat33& A, double *rmsd,
+                                       double E0, double len, double min_score) {
+  const double evecprec = 1e-6;
+  const double evalprec = 1e-11;
+
+  double Sxx, Sxy, Sxz, Syx, Syy, Syz, Szx, Szy, Szz;
+  Sxx = A[0][0]; Sxy = A[0][1]; Sxz = A[0][2];
+  Syx = A[1][0]; Syy = A[1][1]; Syz = A[1][2];
+  Szx = A[2][0]; Szy = A[2][1]; Szz = A[2][2];
+
+  double C[3];
+  qcp_characteristic_polynomial(A, C);
+
+  double SxzpSzx = Sxz + Szx;
+  double SyzpSzy = Syz + Szy;
+  double SxypSyx = Sxy + Syx;
+  double SyzmSzy = Syz - Szy;
+  double SxzmSzx = Sxz - Szx;
+  double SxymSyx = Sxy - Syx;
+  double SxxpSyy = Sxx + Syy;
+  double SxxmSyy = Sxx - Syy;
 
   /* Newton-Raphson */
   double mxEigenV = E0;
@@ -352,5 +373,39 @@ inline double calculate_rmsd_of_superposed_positions(const Position* pos1,
   return result;
 }
 
+/// Many conformations of the same list of points (e.g. an ensemble of models),
+/// for calculating RMSDs after optimal superposition of many pairs at once.
+/// Coordinates are centered, multiplied by sqrt(weight) and stored
+/// as structure-of-arrays: x[stride], y[stride], z[stride] for each
+/// conformation (stride is point_count rounded up, padded with zeros).
+struct GEMMI_DLL QcpEnsemble {
+  size_t point_count = 0;
+  size_t stride = 0;
+  std::vector<double> weights;  // empty or point_count values
+  double weight_sum = 0;
+  std::vector<double> coords;
+  std::vector<double> self_products;  // sum of w * |pos - center|^2
+
+  explicit QcpEnsemble(size_t point_count_, const double* weight=nullptr);
+  size_t size() const { return self_products.size(); }
+  /// Adds a conformation: array of point_count positions.
+  void add(const Position* pos);
+  void reserve(size_t n) {
+    coords.reserve(n * 3 * stride);
+    self_products.reserve(n);
+  }
+};
+
+/// Returns RMSDs of superposition of each conformation onto conformation ref.
+/// Gives the same values as calculate_rmsd_of_superposed_positions()
+/// (up to rounding errors), but inner products and Newton iterations
+/// are calculated for several pairs at once, on n_threads threads.
+GEMMI_DLL std::vector<double> qcp_rmsd_to_reference(const QcpEnsemble& ens, size_t ref,
+                                                    int n_threads=1);
+
+/// Returns RMSDs of all pairs (i, j), i < j, as a condensed distance matrix
+/// (the same order as in scipy.spatial.distance.pdist).
+GEMMI_DLL std::vector<double> qcp_rmsd_matrix(const QcpEnsemble& ens, int n_threads=1);
+
 } // namespace gemmi
 #endif
@@ -5,8 +5,12 @@
 #ifndef GEMMI_RECIPROC_HPP_
 #define GEMMI_RECIPROC_HPP_
 
+#include <cstdint>       // for int8_t
+#include <vector>
 #include "symmetry.hpp"  // for SpaceGroup
 #include "unitcell.hpp"  // for UnitCell
+#include "binner.hpp"    // for Binner
+#include "parallel.hpp"  // for parallel_for
 
 namespace gemmi {
 
@@ -52,6 +56,110 @@ make_miller_vector(const UnitCell& cell, const SpaceGroup* spacegroup,
   return hkls;
 }
 
+/// Properties of reflections that depend only on hkl, symmetry and unit cell,
+/// calculated once and shared by functions that loop over all reflections.
+/// GroupOps::epsilon_factor(), GroupOps::is_reflection_centric()
+/// and ReciprocalAsu::to_asu() each loop over symmetry operations;
+/// here, for each reflection, the operations are applied only once.
+struct ReflnProperties {
+  std::vector<Miller> asu_hkl;       // equivalent reflection in the ASU
+  std::vector<int> isym;             // ISYM, as returned from to_asu()
+  std::vector<int> epsilon;          // as GroupOps::epsilon_factor()
+  std::vector<std::int8_t> centric;  // as GroupOps::is_reflection_centric()
+  std::vector<double> inv_d2;        // 1/d^2
+  std::vector<int> bin;              // set in assign_bins()
+
+  size_t size() const { return inv_d2.size(); }
+
+  /// sym_ops determine the numbering of ISYM (as Intensities::isym_ops);
+  /// they must be all symmetry operations of the group, in any order.
+  /// By default, sg->operations().sym_ops are used.
+  void calculate(const Miller* hkl, size_t n, const UnitCell& cell,
+                 const SpaceGroup* sg, int n_threads=1,
+                 const std::vector<Op>* sym_ops=nullptr) {
+    ReciprocalAsu asu(sg);
+    GroupOps gops = sg->operations();
+    if (!sym_ops)
+      sym_ops = &gops.sym_ops;
+    // transposed rotation matrices, divided by DEN
+    std::vector<std::array<int,9>> rots;
+    rots.reserve(sym_ops->size());
+    for (const Op& op : *sym_ops) {
+      std::array<int,9> r;
+      for (int i = 0; i != 3; ++i)
+        for (int j = 0; j != 3; ++j)
+          r[3*i+j] = op.rot[j][i] / Op::DEN;
+      rots.push_back(r);
+    }
+    const int n_cen = (int) gops.cen_ops.size();
+    asu_hkl.resize(n);
+    isym.resize(n);
+    epsilon.resize(n);
+    centric.resize(n);
+    inv_d2.resize(n);
+    bin.clear();
+    parallel_for(n, n_threads, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i != end; ++i) {
+        const Miller& h = hkl[i];
+        const Miller minus_h = {{-h[0], -h[1], -h[2]}};
+        int eps = 0;
+        bool is_centric = false;
+        int isym_ = 0;
+        for (size_t k = 0; k != rots.size(); ++k) {
+          const std::array<int,9>& r = rots[k];
+          Miller h2 = {{r[0] * h[0] + r[1] * h[1] + r[2] * h[2],
+                        r[3] * h[0] + r[4] * h[1] + r[5] * h[2],
+                        r[6] * h[0] + r[7] * h[1] + r[8] * h[2]}};
+          if (h2 == h)
+            ++eps;
+          if (h2 == minus_h)
+            is_centric = true;
+          if (isym_ == 0) {
+            if (asu.is_in(h2)) {
+              asu_hkl[i] = h2;
+              isym_ = 2 * (int) k + 1;
+            } else {
+              Miller minus_h2 = {{-h2[0], -h2[1], -h2[2]}};
+              if (asu.is_in(minus_h2)) {
+                asu_hkl[i] = minus_h2;
+                isym_ = 2 * (int) k + 2;
+              }
+            }
+          }
+        }
+        if (isym_ == 0)
+          fail("Oops, maybe inconsistent GroupOps?");
+        isym[i] = isym_;
+        epsilon[i] = eps * n_cen;
+        centric[i] = is_centric;
+        inv_d2[i] = cell.calculate_1_d2(h);
+      }
+    });
+  }
+
+  void calculate(const std::vector<Miller>& hkl, const UnitCell& cell,
+                 const SpaceGroup* sg, int n_threads=1,
+                 const std::vector<Op>* sym_ops=nullptr) {
+    calculate(hkl.data(), hkl.size(), cell, sg, n_threads, sym_ops);
+  }
+
+  /// for all reflections in MtzDataProxy, ReflnDataProxy, etc.
+  template<typename DataProxy>
+  void calculate_for(const DataProxy& proxy, int n_threads=1) {
+    if (proxy.spacegroup() == nullptr)
+      fail("unknown space group in the data file");
+    std::vector<Miller> hkl;
+    hkl.reserve(proxy.size() / proxy.stride());
+    for (size_t offset = 0; offset < proxy.size(); offset += proxy.stride())
+      hkl.push_back(proxy.get_hkl(offset));
+    calculate(hkl, proxy.unit_cell(), proxy.spacegroup(), n_threads);
+  }
+
+  void assign_bins(const Binner& binner) {
+    bin = binner.get_bins_from_1_d2(inv_d2);
+  }
+};
+
 
 } // namespace gemmi
 #endif
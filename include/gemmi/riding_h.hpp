@@ -10,7 +10,11 @@
 
 namespace gemmi {
 
-GEMMI_DLL void place_hydrogens_on_all_atoms(Topo& topo);
+/// Residues are processed in parallel if n_threads != 1 (<= 0 means all
+/// hardware threads). Residues connected by links are processed serially,
+/// in the same chunk, so the result and the order of messages don't depend
+/// on the number of threads.
+GEMMI_DLL void place_hydrogens_on_all_atoms(Topo& topo, int n_threads=1);
 
 inline void adjust_hydrogen_distances(Topo& topo, Restraints::DistanceOf of,
                                       double default_scale=1.) {
@@ -7,6 +7,9 @@
 
 #include "asudata.hpp"
 #include "levmar.hpp"
+#ifdef GEMMI_PROFILE
+# include "profile.hpp"  // for GEMMI_PROFILE_SCOPE
+#endif
 #if WITH_NLOPT
 # include <nlopt.h>
 #endif
@@ -226,6 +229,9 @@ struct Scaling {
 
   // quick linear fit (ignoring sigma) to get initial k_overall and isotropic B
   void fit_isotropic_b_approximately() {
+#ifdef GEMMI_PROFILE
+    GEMMI_PROFILE_SCOPE("scaling.fit_isotropic_b");
+#endif
     double sx = 0, sy = 0, sxx = 0, sxy = 0;
     int n = 0;
     for (const Point& p : points) {
@@ -298,6 +304,10 @@ struct Scaling {
   }
 
   double fit_parameters() {
+#ifdef GEMMI_PROFILE
+    GEMMI_PROFILE_SCOPE("scaling.fit_parameters");
+    GEMMI_PROFILE_COUNT("scaling.points", points.size());
+#endif
     LevMar levmar;
     return levmar.fit(*this);
   }
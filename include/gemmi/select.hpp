@@ -6,6 +6,8 @@
 #define GEMMI_SELECT_HPP_
 
 #include <climits>   // for INT_MIN, INT_MAX
+#include <cstdint>   // for uint64_t
+#include <bitset>    // for bitset::count
 #include "model.hpp" // for Model
 
 namespace gemmi {
@@ -209,8 +211,7 @@ struct GEMMI_DLL Selection {
                      [&](typename T::child_type& c) { return c.children().empty(); });
   }
   void remove_selected(Residue& res) const {
-    if (atom_names.all && elements.empty() && altlocs.all &&
-        atom_flags.pattern.empty() && atom_inequalities.empty())
+    if (selects_whole_residues())
       res.atoms.clear();
     else
       vector_remove_if(res.atoms, [&](Atom& c) { return matches(c); });
@@ -223,6 +224,226 @@ struct GEMMI_DLL Selection {
       remove_not_selected(child);
   }
   void remove_not_selected(Atom&) const {}
+
+  // true if all atoms from a matching residue match
+  bool selects_whole_residues() const {
+    return atom_names.all && elements.empty() && altlocs.all &&
+           atom_flags.pattern.empty() && atom_inequalities.empty();
+  }
+};
+
+/// Selection evaluated once for all atoms in a Model and stored as a bitset.
+/// Atoms are numbered in the order of iteration (chains, residues, atoms),
+/// so a mask can be used only with the model from which it was made,
+/// and only until atoms are added or removed.
+/// Unlike in Selection, residues and chains have no separate status:
+/// a residue is selected if any of its atoms is selected.
+struct SelectionMask {
+  std::vector<std::uint64_t> bits;
+  size_t atom_count = 0;
+
+  SelectionMask() = default;
+  explicit SelectionMask(size_t n, bool value=false)
+    : bits((n + 63) / 64, value ? ~std::uint64_t(0) : 0), atom_count(n) {
+    clear_padding();
+  }
+
+  SelectionMask(const Selection& sel, const Model& model) {
+    atom_count = count_atoms(model);
+    bits.assign((atom_count + 63) / 64, 0);
+    if (!sel.matches(model))
+      return;
+    const bool whole_residues = sel.selects_whole_residues();
+    size_t idx = 0;
+    for (const Chain& chain : model.chains) {
+      if (!sel.matches(chain)) {
+        for (const Residue& res : chain.residues)
+          idx += res.atoms.size();
+        continue;
+      }
+      for (const Residue& res : chain.residues) {
+        if (!sel.matches(res)) {
+          idx += res.atoms.size();
+        } else if (whole_residues) {
+          set_range(idx, idx + res.atoms.size());
+          idx += res.atoms.size();
+        } else {
+          for (const Atom& atom : res.atoms) {
+            if (sel.matches(atom))
+              set(idx);
+            ++idx;
+          }
+        }
+      }
+    }
+  }
+
+  static size_t count_atoms(const Model& model) {
+    size_t n = 0;
+    for (const Chain& chain : model.chains)
+      for (const Residue& res : chain.residues)
+        n += res.atoms.size();
+    return n;
+  }
+
+  size_t size() const { return atom_count; }
+  bool test(size_t i) const { return (bits[i / 64] >> (i % 64)) & 1; }
+  void set(size_t i) { bits[i / 64] |= std::uint64_t(1) << (i % 64); }
+  void reset(size_t i) { bits[i / 64] &= ~(std::uint64_t(1) << (i % 64)); }
+
+  void set_range(size_t begin, size_t end) {
+    for (; begin != end && begin % 64 != 0; ++begin)
+      set(begin);
+    for (; begin + 64 <= end; begin += 64)
+      bits[begin / 64] = ~std::uint64_t(0);
+    for (; begin != end; ++begin)
+      set(begin);
+  }
+
+  /// number of selected atoms
+  size_t count() const {
+    size_t n = 0;
+    for (std::uint64_t word : bits)
+      n += std::bitset<64>(word).count();
+    return n;
+  }
+  bool any() const {
+    for (std::uint64_t word : bits)
+      if (word != 0)
+        return true;
+    return false;
+  }
+
+  SelectionMask& operator&=(const SelectionMask& o) {
+    check_size(o);
+    for (size_t i = 0; i != bits.size(); ++i)
+      bits[i] &= o.bits[i];
+    return *this;
+  }
+  SelectionMask& operator|=(const SelectionMask& o) {
+    check_size(o);
+    for (size_t i = 0; i != bits.size(); ++i)
+      bits[i] |= o.bits[i];
+    return *this;
+  }
+  SelectionMask& operator^=(const SelectionMask& o) {
+    check_size(o);
+    for (size_t i = 0; i != bits.size(); ++i)
+      bits[i] ^= o.bits[i];
+    return *this;
+  }
+  SelectionMask operator&(const SelectionMask& o) const { return SelectionMask(*this) &= o; }
+  SelectionMask operator|(const SelectionMask& o) const { return SelectionMask(*this) |= o; }
+  SelectionMask operator^(const SelectionMask& o) const { return SelectionMask(*this) ^= o; }
+  SelectionMask operator~() const {
+    SelectionMask r(*this);
+    for (std::uint64_t& word : r.bits)
+      word = ~word;
+    r.clear_padding();
+    return r;
+  }
+  bool operator==(const SelectionMask& o) const {
+    return atom_count == o.atom_count && bits == o.bits;
+  }
+  bool operator!=(const SelectionMask& o) const { return !operator==(o); }
+
+  /// Calls func(Chain&, Residue&, Atom&) for each selected atom.
+  template<typename M, typename Func>
+  void for_each(M& model, Func func) const {
+    check_model(model);
+    size_t idx = 0;
+    for (auto& chain : model.chains)
+      for (auto& res : chain.residues) {
+        size_t end = idx + res.atoms.size();
+        if (!any_in_range(idx, end)) {
+          idx = end;
+          continue;
+        }
+        for (auto& atom : res.atoms) {
+          if (test(idx))
+            func(chain, res, atom);
+          ++idx;
+        }
+      }
+  }
+
+  /// Returns a copy of the model with only selected atoms;
+  /// chains and residues without selected atoms are not copied.
+  Model copy_selection(const Model& model) const {
+    check_model(model);
+    Model copied = model.empty_copy();
+    size_t idx = 0;
+    for (const Chain& chain : model.chains) {
+      Chain* new_chain = nullptr;
+      for (const Residue& res : chain.residues) {
+        size_t end = idx + res.atoms.size();
+        if (any_in_range(idx, end)) {
+          if (!new_chain) {
+            copied.chains.push_back(chain.empty_copy());
+            new_chain = &copied.chains.back();
+          }
+          new_chain->residues.push_back(res.empty_copy());
+          Residue& new_res = new_chain->residues.back();
+          for (size_t i = idx; i != end; ++i)
+            if (test(i))
+              new_res.atoms.push_back(res.atoms[i - idx]);
+        }
+        idx = end;
+      }
+    }
+    return copied;
+  }
+
+  /// Removes atoms that are not selected, and then empty residues and chains.
+  void remove_not_selected(Model& model) const {
+    remove_atoms(model, false);
+  }
+  /// Removes selected atoms, and then empty residues and chains.
+  void remove_selected(Model& model) const {
+    remove_atoms(model, true);
+  }
+
+private:
+  void clear_padding() {
+    if (atom_count % 64 != 0)
+      bits.back() &= (std::uint64_t(1) << (atom_count % 64)) - 1;
+  }
+  void check_size(const SelectionMask& o) const {
+    if (o.atom_count != atom_count)
+      fail("SelectionMask: masks for different models");
+  }
+  template<typename M> void check_model(const M& model) const {
+    if (count_atoms(model) != atom_count)
+      fail("SelectionMask: the model has changed");
+  }
+  bool any_in_range(size_t begin, size_t end) const {
+    for (; begin != end && begin % 64 != 0; ++begin)
+      if (test(begin))
+        return true;
+    for (; begin + 64 <= end; begin += 64)
+      if (bits[begin / 64] != 0)
+        return true;
+    for (; begin != end; ++begin)
+      if (test(begin))
+        return true;
+    return false;
+  }
+  void remove_atoms(Model& model, bool selected) const {
+    check_model(model);
+    size_t idx = 0;
+    for (Chain& chain : model.chains) {
+      for (Residue& res : chain.residues) {
+        const Atom* first = res.atoms.data();
+        size_t n = res.atoms.size();
+        vector_remove_if(res.atoms, [&](const Atom& a) {
+            return test(idx + size_t(&a - first)) == selected;
+        });
+        idx += n;
+      }
+      vector_remove_if(chain.residues, [](const Residue& r) { return r.atoms.empty(); });
+    }
+    vector_remove_if(model.chains, [](const Chain& c) { return c.residues.empty(); });
+  }
 };
 
 } // namespace gemmi
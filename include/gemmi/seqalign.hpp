@@ -4,6 +4,7 @@
 // from https://github.com/lh3/ksw2, which is under the MIT license.
 // The original code, written by Heng Li, has more features and has more
 // efficient variants that use SSE instructions.
+// The striped variant follows M. Farrar, Bioinformatics 23:156 (2007).
 
 #ifndef GEMMI_SEQALIGN_HPP_
 #define GEMMI_SEQALIGN_HPP_
@@ -189,31 +190,58 @@ struct AlignmentResult {
   }
 };
 
-/// All values in query and target must be less then m.
-/// target_gapo, if set, has gap opening penalties at specific positions in target.
+namespace impl {
+
+constexpr std::int32_t alignment_neg_inf = -0x40000000;
+
+// score of aligning query item q to target item k
+struct AlignmentScores {
+  const AlignmentScoring& scoring;
+  std::uint32_t mat_size;
+
+  explicit AlignmentScores(const AlignmentScoring& s)
+    : scoring(s), mat_size((std::uint32_t) s.matrix_encoding.size()) {
+    if (mat_size * mat_size != scoring.score_matrix.size())
+      fail("align_sequences: internal error (wrong score_matrix)");
+  }
+  std::int32_t operator()(std::uint8_t k, std::uint8_t q) const {
+    if (k < mat_size && q < mat_size)
+      return scoring.score_matrix[k * mat_size + q];
+    return k == q ? scoring.match : scoring.mismatch;
+  }
+};
+
+// Row-by-row DP as in ksw2_gg.c. If band_width >= 0, only cells with
+// j - i (query position - target position) in the band are calculated.
+// The band is the main diagonal +/- band_width, extended by the difference
+// of sequence lengths.
 inline
-AlignmentResult align_sequences(const std::vector<std::uint8_t>& query,
-                                const std::vector<std::uint8_t>& target,
-                                const std::vector<int>& target_gapo,
-                                std::uint8_t m,
-                                const AlignmentScoring& scoring) {
+AlignmentResult align_sequences_banded(const std::vector<std::uint8_t>& query,
+                                       const std::vector<std::uint8_t>& target,
+                                       const std::vector<int>& target_gapo,
+                                       std::uint8_t m,
+                                       const AlignmentScoring& scoring,
+                                       int band_width) {
+  const std::int32_t qlen = (std::int32_t) query.size();
+  const std::int32_t tlen = (std::int32_t) target.size();
   // generate the query profile
-  std::int16_t *query_profile = new std::int16_t[query.size() * m];
+  std::vector<std::int16_t> query_profile(query.size() * m);
   {
-    std::uint32_t mat_size = (std::uint32_t) scoring.matrix_encoding.size();
-    if (mat_size * mat_size != scoring.score_matrix.size())
-      fail("align_sequences: internal error (wrong score_matrix)");
+    AlignmentScores score(scoring);
     std::int32_t i = 0;
     for (std::uint8_t k = 0; k < m; ++k)
       for (std::uint8_t q : query)
-        if (k < mat_size && q < mat_size)
-          query_profile[i++] = scoring.score_matrix[k * mat_size + q];
-        else
-          query_profile[i++] = (k == q ? scoring.match : scoring.mismatch);
+        query_profile[i++] = (std::int16_t) score(k, q);
+  }
+  std::int32_t band_lo = -tlen;
+  std::int32_t band_hi = qlen;
+  if (band_width >= 0) {
+    band_lo = std::min(0, qlen - tlen) - band_width;
+    band_hi = std::max(0, qlen - tlen) + band_width;
   }
 
   struct eh_t { std::int32_t h, e; };
-  eh_t *eh = new eh_t[query.size() + 1];
+  std::vector<eh_t> eh(query.size() + 1);
   std::int32_t gape = scoring.gape;
   std::int32_t gapoe = scoring.gapo + gape;
 
@@ -222,24 +250,26 @@ AlignmentResult align_sequences(const std::vector<std::uint8_t>& query,
     std::int32_t gap0 = !target_gapo.empty() ? target_gapo[0] + gape : gapoe;
     eh[0].h = 0;
     eh[0].e = gap0 + gapoe;
-    for (std::int32_t j = 1; j <= (std::int32_t)query.size(); ++j) {
+    for (std::int32_t j = 1; j <= qlen; ++j) {
       eh[j].h = gap0 + gape * (j - 1);
       eh[j].e = gap0 + gapoe + gape * j;
     }
   }
 
   // backtrack matrix; in each cell: f<<4|e<<2|h
-  std::uint8_t *z = new std::uint8_t[query.size() * target.size()];
+  std::vector<std::uint8_t> z(query.size() * target.size());
   // DP loop
-  for (std::int32_t i = 0; i < (std::int32_t)target.size(); ++i) {
+  for (std::int32_t i = 0; i < tlen; ++i) {
     std::uint8_t target_item = target[i];
-    std::int16_t *scores = &query_profile[target_item * query.size()];
-    std::uint8_t *zi = &z[i * query.size()];
-    std::int32_t h1 = gapoe + gape * i;
-    std::int32_t f = gapoe + gapoe + gape * i;
+    const std::int16_t *scores = &query_profile[target_item * query.size()];
+    std::uint8_t *zi = z.data() + (std::size_t) i * query.size();
+    std::int32_t j_lo = std::max(0, i + band_lo);
+    std::int32_t j_hi = std::min(qlen, i + band_hi + 1);
+    std::int32_t h1 = j_lo == 0 ? gapoe + gape * i : alignment_neg_inf;
+    std::int32_t f = j_lo == 0 ? gapoe + gapoe + gape * i : alignment_neg_inf;
     std::int32_t gapx = i+1 < (std::int32_t)target_gapo.size()
                         ? target_gapo[i+1] + gape : gapoe;
-    for (std::size_t j = 0; j < query.size(); ++j) {
+    for (std::int32_t j = j_lo; j < j_hi; ++j) {
       // At the beginning of the loop:
       //  eh[j] = { H(i-1,j-1), E(i,j) }, f = F(i,j) and h1 = H(i,j-1)
       // Cells are computed in the following order:
@@ -280,25 +310,234 @@ AlignmentResult align_sequences(const std::vector<std::uint8_t>& query,
       // z[i,j] keeps h for the current cell and e/f for the next cell
       zi[j] = direction;
     }
-    eh[query.size()].h = h1;
-    eh[query.size()].e = -0x40000000; // -infinity
+    eh[j_hi].h = h1;
+    eh[j_hi].e = alignment_neg_inf;
   }
 
   AlignmentResult result;
   result.score = eh[query.size()].h;
-  delete [] query_profile;
-  delete [] eh;
-  result.backtrack_to_cigar(z, (int)target.size(), (int)query.size());
-  delete [] z;
+  result.backtrack_to_cigar(z.data(), (int)target.size(), (int)query.size());
+  result.count_matches(query, target);
+  return result;
+}
+
+// Small vector of int32 with element-wise operations. With GCC and Clang
+// it uses vector extensions, which compile to SSE2 or NEON instructions.
+// The width is fixed at 16 bytes: the layout of this inline type must not
+// depend on per-file -m flags, and std::vector in C++14 doesn't handle
+// alignment above that of max_align_t (16 bytes on x86-64).
+struct Int32Lanes {
+  static constexpr std::size_t size = 4;
+#if defined(__GNUC__)
+  static constexpr bool vectorized = true;
+  typedef std::int32_t V __attribute__((vector_size(size * 4)));
+  V v;
+  std::int32_t get(std::size_t i) const { return v[i]; }
+  void set(std::size_t i, std::int32_t x) { v[i] = x; }
+  static Int32Lanes all(std::int32_t x) { return {V{} + x}; }
+  friend Int32Lanes operator+(Int32Lanes a, Int32Lanes b) { return {a.v + b.v}; }
+  friend Int32Lanes operator+(Int32Lanes a, std::int32_t b) { return {a.v + b}; }
+  friend Int32Lanes operator&(Int32Lanes a, std::int32_t b) { return {a.v & b}; }
+  friend Int32Lanes operator|(Int32Lanes a, Int32Lanes b) { return {a.v | b.v}; }
+  // -1 where a > b, 0 elsewhere
+  friend Int32Lanes greater(Int32Lanes a, Int32Lanes b) { return {(V)(a.v > b.v)}; }
+  // mask ? a : b
+  friend Int32Lanes select(Int32Lanes mask, Int32Lanes a, Int32Lanes b) {
+    return {(a.v & mask.v) | (b.v & ~mask.v)};
+  }
+#else
+  static constexpr bool vectorized = false;
+  std::int32_t v[size];
+  std::int32_t get(std::size_t i) const { return v[i]; }
+  void set(std::size_t i, std::int32_t x) { v[i] = x; }
+  static Int32Lanes all(std::int32_t x) {
+    Int32Lanes r;
+    for (std::size_t i = 0; i < size; ++i)
+      r.v[i] = x;
+    return r;
+  }
+  template<typename Op> static Int32Lanes apply(Int32Lanes a, Int32Lanes b, Op op) {
+    for (std::size_t i = 0; i < size; ++i)
+      a.v[i] = op(a.v[i], b.v[i]);
+    return a;
+  }
+  friend Int32Lanes operator+(Int32Lanes a, Int32Lanes b) {
+    return apply(a, b, [](std::int32_t x, std::int32_t y) { return x + y; });
+  }
+  friend Int32Lanes operator+(Int32Lanes a, std::int32_t b) { return a + all(b); }
+  friend Int32Lanes operator&(Int32Lanes a, std::int32_t b) {
+    return apply(a, all(b), [](std::int32_t x, std::int32_t y) { return x & y; });
+  }
+  friend Int32Lanes operator|(Int32Lanes a, Int32Lanes b) {
+    return apply(a, b, [](std::int32_t x, std::int32_t y) { return x | y; });
+  }
+  friend Int32Lanes greater(Int32Lanes a, Int32Lanes b) {
+    return apply(a, b, [](std::int32_t x, std::int32_t y) { return x > y ? -1 : 0; });
+  }
+  friend Int32Lanes select(Int32Lanes mask, Int32Lanes a, Int32Lanes b) {
+    for (std::size_t i = 0; i < size; ++i)
+      a.v[i] = mask.v[i] ? a.v[i] : b.v[i];
+    return a;
+  }
+#endif
+  friend Int32Lanes max(Int32Lanes a, Int32Lanes b) { return select(greater(a, b), a, b); }
+};
+
+// The same DP as in align_sequences_banded(), with query positions
+// in the striped layout (M. Farrar, Bioinformatics 23:156, 2007): position j
+// is in segment j % seg_len, lane j / seg_len.
+// Instead of Farrar's lazy-F loop, which in global alignment often needs
+// several passes, F (gap in target) is calculated with a prefix scan:
+// first within each lane, then across lanes (as in parasail's "scan").
+// This relies on F(i,j+1) = max{H'(i,j)+gapx, F(i,j)+max(gapx,gape)},
+// where H' is H calculated without F.
+// Returns the score. If z is not null, the backtrack matrix is written
+// to it. query and target must not be empty.
+inline std::int32_t align_sequences_striped(const std::vector<std::uint8_t>& query,
+                                            const std::vector<std::uint8_t>& target,
+                                            const std::vector<int>& target_gapo,
+                                            std::uint8_t m,
+                                            const AlignmentScoring& scoring,
+                                            std::uint8_t* z) {
+  using std::int32_t;
+  using Lanes = Int32Lanes;
+  constexpr std::size_t W = Lanes::size;
+  const std::size_t qlen = query.size();
+  const std::size_t seg_len = (qlen + W - 1) / W;
+
+  // striped query profile, padded with zeros
+  std::vector<Lanes> profile(m * seg_len, Lanes::all(0));
+  {
+    AlignmentScores score(scoring);
+    for (std::uint8_t k = 0; k < m; ++k)
+      for (std::size_t j = 0; j < qlen; ++j)
+        profile[k * seg_len + j % seg_len].set(j / seg_len, score(k, query[j]));
+  }
+
+  int32_t gape = scoring.gape;
+  int32_t gapoe = scoring.gapo + gape;
+  // H of the previous and current row, E of the current row,
+  // F calculated within lanes, H(i-1,j-1) + S(i,j), and backtrack values
+  std::vector<Lanes> h_prev(seg_len), h_cur(seg_len), ee(seg_len), ff(seg_len),
+                     hd(seg_len), dir_row(seg_len);
+  {
+    int32_t gap0 = !target_gapo.empty() ? target_gapo[0] + gape : gapoe;
+    for (std::size_t s = 0; s < seg_len; ++s)
+      for (std::size_t l = 0; l < W; ++l) {
+        int32_t j = int32_t(l * seg_len + s);
+        h_prev[s].set(l, gap0 + gape * j);  // H(-1,j)
+        ee[s].set(l, gap0 + gapoe + gape * j);  // E(0,j)
+      }
+  }
+
+  for (std::size_t i = 0; i < target.size(); ++i) {
+    const Lanes* prof = &profile[target[i] * seg_len];
+    int32_t gapx = i+1 < target_gapo.size() ? target_gapo[i+1] + gape : gapoe;
+    int32_t f_ext = std::max(gapx, gape);
+
+    // H without F, and F from preceding positions in the same lane
+    Lanes vf = Lanes::all(alignment_neg_inf);
+    vf.set(0, gapoe + gapoe + gape * int32_t(i));  // F(i,0)
+    Lanes diag;  // H(i-1,j-1)
+    diag.set(0, i == 0 ? 0 : gapoe + gape * int32_t(i - 1));  // H(i-1,-1)
+    for (std::size_t l = 1; l < W; ++l)
+      diag.set(l, h_prev[seg_len - 1].get(l-1));
+    for (std::size_t s = 0; s < seg_len; ++s) {
+      Lanes d = diag + prof[s];
+      Lanes h = max(d, ee[s]);
+      ff[s] = vf;
+      vf = max(h + gapx, vf + f_ext);
+      hd[s] = d;
+      h_cur[s] = h;
+      diag = h_prev[s];
+    }
+
+    // F at the beginning of each lane (lane 0 is already complete)
+    Lanes f_in = Lanes::all(alignment_neg_inf);
+    f_in.set(1, vf.get(0));
+    for (std::size_t l = 2; l < W; ++l)
+      f_in.set(l, std::max(vf.get(l-1), f_in.get(l-1) + f_ext * int32_t(seg_len)));
+
+    // final F and H, E(i+1,j) and backtrack values
+    for (std::size_t s = 0; s < seg_len; ++s) {
+      Lanes d = hd[s];
+      Lanes e = ee[s];
+      Lanes f = max(ff[s], f_in);
+      f_in = f_in + f_ext;
+      Lanes h = max(h_cur[s], f);
+      Lanes h_open = h + gapoe;
+      Lanes e_ext = e + gape;
+      ee[s] = max(h_open, e_ext);
+      h_cur[s] = h;
+      if (z) {
+        // 0 (match), 1 (deletion) or 2 (insertion) if F >= max(diagonal, E)
+        Lanes direction = select(greater(max(d, e), f), greater(e, d) & 1, Lanes::all(2));
+        direction = direction | (greater(e_ext, h_open) & 0x08);
+        direction = direction | (greater(f + gape, h + gapx) & 0x10);
+        dir_row[s] = direction;
+      }
+    }
+    if (z) {
+      std::uint8_t* zi = z + i * qlen;
+      for (std::size_t l = 0, j = 0; l < W; ++l)
+        for (std::size_t s = 0; s < seg_len && j < qlen; ++s, ++j)
+          zi[j] = (std::uint8_t) dir_row[s].get(l);
+    }
+    h_prev.swap(h_cur);
+  }
+  return h_prev[(qlen - 1) % seg_len].get((qlen - 1) / seg_len);
+}
+
+} // namespace impl
+
+/// All values in query and target must be less then m.
+/// target_gapo, if set, has gap opening penalties at specific positions in target.
+/// If band_width >= 0, the alignment is restricted to a band around
+/// the diagonal (extended by the difference of lengths), which is faster
+/// for similar sequences, but may give a worse alignment.
+inline
+AlignmentResult align_sequences(const std::vector<std::uint8_t>& query,
+                                const std::vector<std::uint8_t>& target,
+                                const std::vector<int>& target_gapo,
+                                std::uint8_t m,
+                                const AlignmentScoring& scoring,
+                                int band_width=-1) {
+  // without vector extensions, the striped variant is faster only
+  // when the backtrack matrix is not needed
+  if (band_width >= 0 || query.empty() || target.empty() ||
+      !impl::Int32Lanes::vectorized)
+    return impl::align_sequences_banded(query, target, target_gapo, m, scoring,
+                                        band_width);
+  std::vector<std::uint8_t> z(query.size() * target.size());
+  AlignmentResult result;
+  result.score = impl::align_sequences_striped(query, target, target_gapo, m,
+                                               scoring, z.data());
+  result.backtrack_to_cigar(z.data(), (int)target.size(), (int)query.size());
   result.count_matches(query, target);
   return result;
 }
 
+/// Returns the score of align_sequences(), without the backtrack matrix
+/// (using memory linear in the length of query).
+inline
+int align_sequences_score(const std::vector<std::uint8_t>& query,
+                          const std::vector<std::uint8_t>& target,
+                          const std::vector<int>& target_gapo,
+                          std::uint8_t m,
+                          const AlignmentScoring& scoring) {
+  if (query.empty() || target.empty())
+    return impl::align_sequences_banded(query, target, target_gapo, m, scoring,
+                                        -1).score;
+  return impl::align_sequences_striped(query, target, target_gapo, m, scoring,
+                                       nullptr);
+}
+
 inline
 AlignmentResult align_string_sequences(const std::vector<std::string>& query,
                                        const std::vector<std::string>& target,
                                        const std::vector<int>& target_gapo,
-                                       const AlignmentScoring* scoring) {
+                                       const AlignmentScoring* scoring,
+                                       int band_width=-1) {
   if (scoring == nullptr)
     scoring = AlignmentScoring::simple();
   std::map<std::string, std::uint8_t> encoding;
@@ -317,7 +556,8 @@ AlignmentResult align_string_sequences(const std::vector<std::string>& query,
   for (size_t i = 0; i != target.size(); ++i)
     encoded_target[i] = encoding.at(target[i]);
   return align_sequences(encoded_query, encoded_target,
-                         target_gapo, (std::uint8_t)encoding.size(), *scoring);
+                         target_gapo, (std::uint8_t)encoding.size(), *scoring,
+                         band_width);
 }
 
 } // namespace gemmi
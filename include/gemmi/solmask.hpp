@@ -6,8 +6,12 @@
 #define GEMMI_SOLMASK_HPP_
 
 #include "grid.hpp"      // for Grid
-#include "floodfill.hpp" // for FloodFill
+#include "edt.hpp"       // for squared_distance_transform
+#include "floodfill.hpp" // for GridComponents
 #include "model.hpp"     // for Model, Atom, ...
+#ifdef GEMMI_PROFILE
+# include "profile.hpp"  // for GEMMI_PROFILE_SCOPE
+#endif
 
 namespace gemmi {
 
@@ -104,12 +108,21 @@ inline float refmac_radius_for_bulk_solvent(El el) {
 
 // mask utilities
 
+/// With n_threads > 1, the grid is split into slabs (ranges of sections w),
+/// atoms are assigned to slabs they overlap and each slab is processed
+/// in a separate thread.
 template<typename T>
 void mask_points_in_radius(Grid<T>& mask, const Model& model,
                            AtomicRadiiSet atomic_radii_set,
                            double r_probe, T value,
                            bool ignore_hydrogen,
-                           bool ignore_zero_occupancy_atoms) {
+                           bool ignore_zero_occupancy_atoms,
+                           int n_threads=1) {
+  struct Sphere {
+    Fractional fpos;
+    double r;
+  };
+  std::vector<Sphere> spheres;
   for (const Chain& chain : model.chains)
     for (const Residue& res : chain.residues)
       for (const Atom& atom : res.atoms) {
@@ -124,8 +137,45 @@ void mask_points_in_radius(Grid<T>& mask, const Model& model,
           case AtomicRadiiSet::Refmac: r += refmac_radius_for_bulk_solvent(elem); break;
           case AtomicRadiiSet::Constant: /* r is included in r_probe */ break;
         }
-        mask.set_points_around(atom.pos, r, value);
+        spheres.push_back({mask.unit_cell.fractionalize(atom.pos), r});
       }
+  n_threads = normalize_thread_count(n_threads);
+  int n_slabs = std::min(4 * n_threads, mask.nw);
+  if (n_threads == 1 || n_slabs < 2) {
+    for (const Sphere& sph : spheres)
+      mask.template use_points_around<true>(sph.fpos, sph.r,
+                                            [&](T& ref, double) { ref = value; },
+                                            false);
+    return;
+  }
+  std::vector<std::vector<const Sphere*>> slabs(n_slabs);
+  auto slab_start = [&](size_t n) { return int(n * mask.nw / n_slabs); };
+  for (const Sphere& sph : spheres) {
+    // atoms can be any number of unit cells away from [0,1)
+    int w0 = modulo(iround(sph.fpos.z * mask.nw), mask.nw);
+    int dw = (int) std::ceil(sph.r / mask.spacing[2]);
+    for (size_t i = 0; i < slabs.size(); ++i) {
+      int lo = slab_start(i);
+      int hi = slab_start(i + 1);
+      for (int k = -1; k <= 1; ++k) {
+        int shift = k * mask.nw;
+        if (2 * dw + 1 >= mask.nw || (w0 - dw + shift < hi && w0 + dw + shift >= lo)) {
+          slabs[i].push_back(&sph);
+          break;
+        }
+      }
+    }
+  }
+  parallel_for_each_index(slabs.size(), n_threads, [&](size_t i) {
+    size_t section_size = (size_t) mask.nu * mask.nv;
+    const T* lo = mask.data.data() + section_size * slab_start(i);
+    const T* hi = mask.data.data() + section_size * slab_start(i + 1);
+    for (const Sphere* sph : slabs[i])
+      mask.template use_points_around<true>(sph->fpos, sph->r, [&](T& ref, double) {
+          if (&ref >= lo && &ref < hi)
+            ref = value;
+      }, false);
+  });
 }
 
 // deprecated
@@ -291,6 +341,7 @@ struct SolventMasker {
   double island_min_volume;
   double constant_r;
   double requested_spacing = 0.;
+  int n_threads = 1;
 
   SolventMasker(AtomicRadiiSet choice, double constant_r_=0.) {
     set_radii(choice, constant_r_);
@@ -332,7 +383,7 @@ struct SolventMasker {
   /// set grid points around atoms to 0
   template<typename T> void mask_points(Grid<T>& grid, const Model& model) const {
     mask_points_in_radius(grid, model, atomic_radii_set, constant_r + rprobe, (T)0,
-                          ignore_hydrogen, ignore_zero_occupancy_atoms);
+                          ignore_hydrogen, ignore_zero_occupancy_atoms, n_threads);
   }
 
   void mask_points(Grid<float>& grid, const Model& model) const {
@@ -349,18 +400,25 @@ struct SolventMasker {
   /// grid point to the minimum value.
   template<typename T> void symmetrize(Grid<T>& grid) const {
     if (std::is_same<T, std::int8_t>::value) {
-      grid.symmetrize([&](T a, T b) { return a == (T)0 || b == (T)0 ? (T)0 : (T)1; });
+      grid.symmetrize([&](T a, T b) { return a == (T)0 || b == (T)0 ? (T)0 : (T)1; }, n_threads);
     }
     else {
-      grid.symmetrize([&](T a, T b) { return a < b ? a : b; });
+      grid.symmetrize([&](T a, T b) { return a < b ? a : b; }, n_threads);
     }
   }
 
+  /// Points with value < 1 that are within rshrink from a point with
+  /// value >= 1 are set to 1. Uses the distance transform.
   template<typename T> void shrink(Grid<T>& grid) const {
-    if (rshrink > 0) {
-      set_margin_around(grid, rshrink, (T)1, (T)-1);
-      grid.change_values((T)-1, (T)1);
-    }
+    if (rshrink <= 0)
+      return;
+    Grid<float> dist_sq;
+    squared_distance_transform(grid, [](T x) { return x >= (T)1; },
+                               dist_sq, rshrink, n_threads);
+    float limit = float(rshrink * rshrink);
+    for (size_t i = 0; i < grid.data.size(); ++i)
+      if (grid.data[i] < (T)1 && dist_sq.data[i] <= limit)
+        grid.data[i] = (T)1;
   }
 
   template<typename T> void invert(Grid<T>& grid) const {
@@ -369,28 +427,36 @@ struct SolventMasker {
   }
 
 
-  // Removes small islands of Land=1 in the sea of 0. Uses flood fill.
-  // cf. find_blobs_by_flood_fill()
+  // Removes small islands of Land=1 in the sea of 0. Uses connected-component
+  // labeling (GridComponents); cf. find_blobs_by_flood_fill().
   // Currently doesn't work mask from mask_points_using_occupancy().
   template<typename T> int remove_islands(Grid<T>& grid) const {
     if (island_min_volume <= 0)
       return 0;
     size_t limit = static_cast<size_t>(island_min_volume * grid.point_count()
                                        / grid.unit_cell.volume);
+    GridComponents components;
+    components.label(grid, [](T x) { return x == (T)1; }, n_threads);
+    std::vector<size_t> point_count(components.runs.size(), 0);
+    for (size_t i = 0; i != components.runs.size(); ++i)
+      point_count[components.parent[i]] += components.runs[i].len;
     int counter = 0;
-    FloodFill<T,1> flood_fill{grid};
-    flood_fill.for_each_islands([&](typename FloodFill<T,1>::Result& r) {
-        //printf("island %d: %zu in %zu (limit: %zu)\n",
-        //       counter, r.point_count(), lines.size(), limit);
-        if (r.point_count() <= limit) {
-          ++counter;
-          flood_fill.set_volume_values(r, (T)0);
-        }
-    });
+    for (size_t i = 0; i != components.runs.size(); ++i)
+      if (components.parent[i] == (int) i && point_count[i] <= limit)
+        ++counter;
+    for (size_t i = 0; i != components.runs.size(); ++i)
+      if (point_count[components.parent[i]] <= limit) {
+        const GridComponents::Run& run = components.runs[i];
+        T* ptr = &grid.data[grid.index_q(run.u, run.v, run.w)];
+        std::fill(ptr, ptr + run.len, (T)0);
+      }
     return counter;
   }
 
   template<typename T> void put_mask_on_grid(Grid<T>& grid, const Model& model) const {
+#ifdef GEMMI_PROFILE
+    GEMMI_PROFILE_SCOPE("mask.put_mask_on_grid");
+#endif
     clear(grid);
     assert(!grid.data.empty());
     mask_points(grid, model);
@@ -510,28 +576,14 @@ void interpolate_grid_around_model(Grid<T>& dest, const Grid<T>& src,
 template<typename T>
 void add_soft_edge_to_mask(Grid<T>& grid, double width) {
   const double width2 = width * width;
-  const int du = (int) std::ceil(width / grid.spacing[0]);
-  const int dv = (int) std::ceil(width / grid.spacing[1]);
-  const int dw = (int) std::ceil(width / grid.spacing[2]);
-
-  for (int w = 0; w < grid.nw; ++w)
-    for (int v = 0; v < grid.nv; ++v)
-      for (int u = 0; u < grid.nu; ++u) {
-        size_t idx = grid.index_q(u, v, w);
-        if (grid.data[idx] >= 1e-3) continue;
-        double min_d2 = width2 + 1;
-        Fractional fctr = grid.get_fractional(u, v, w);
-        grid.template use_points_in_box<true>(
-            fctr, du, dv, dw,
-            [&](T& point, double d2, const Position&, int, int, int) {
-              if (point > 0.999) {
-                if (d2 < min_d2)
-                min_d2 = d2;
-              }
-            });
-        if (min_d2 < width2)
-          grid.data[idx] = T(0.5 + 0.5 * std::cos(pi() * std::sqrt(min_d2) / width));
-      }
+  Grid<float> dist_sq;
+  squared_distance_transform(grid, [](T x) { return x > 0.999; },
+                             dist_sq, width);
+  for (size_t idx = 0; idx < grid.data.size(); ++idx) {
+    double d2 = dist_sq.data[idx];
+    if (grid.data[idx] < 1e-3 && d2 < width2)
+      grid.data[idx] = T(0.5 + 0.5 * std::cos(pi() * std::sqrt(d2) / width));
+  }
 }
 
 } // namespace gemmi
@@ -7,6 +7,9 @@
 
 #include <ostream>
 #include "cifdoc.hpp"
+#ifdef GEMMI_PROFILE
+# include "profile.hpp"  // for GEMMI_PROFILE_SCOPE
+#endif
 
 namespace gemmi {
 namespace cif {
@@ -264,6 +267,9 @@ inline void write_cif_block_to_stream(std::ostream& os_, const Block& block,
 
 inline void write_cif_to_stream(std::ostream& os, const Document& doc,
                                 WriteOptions options=WriteOptions()) {
+#ifdef GEMMI_PROFILE
+  GEMMI_PROFILE_SCOPE("cif.write");
+#endif
   bool first = true;
   for (const Block& block : doc.blocks) {
     if (!first)
@@ -49,5 +49,20 @@ inline void write_mmjson_to_stream(std::ostream& os, const Document& doc) {
 }
 
 } // namespace cif
+
+struct Structure;
+struct MmcifOutputGroups;
+
+/// Writes Structure as mmJSON. The same as writing make_mmcif_document(),
+/// but _atom_site values are written directly from Structure.
+GEMMI_DLL void write_structure_as_mmjson(std::ostream& os, const Structure& st);
+GEMMI_DLL void write_structure_as_mmjson(std::ostream& os, const Structure& st,
+                                         const MmcifOutputGroups& groups);
+
+/// Writes doc as mmJSON, taking values for _atom_site from st.
+/// The _atom_site loop in doc has only tags, as made by
+/// impl::update_mmcif_block_without_atom_values().
+GEMMI_DLL void write_mmjson_with_atoms(std::ostream& os, const cif::Document& doc,
+                                       const Structure& st);
 } // namespace gemmi
 #endif
@@ -58,6 +58,13 @@ struct MmcifOutputGroups {
 
 GEMMI_DLL void update_mmcif_block(const Structure& st, cif::Block& block,
                                   MmcifOutputGroups groups=MmcifOutputGroups(true));
+
+namespace impl {
+// Like update_mmcif_block(), but _atom_site gets only tags. Used when
+// the atom values are written directly from Structure (to_json.hpp).
+GEMMI_DLL void update_mmcif_block_without_atom_values(const Structure& st, cif::Block& block,
+                                                      MmcifOutputGroups groups);
+} // namespace impl
 GEMMI_DLL cif::Document make_mmcif_document(const Structure& st,
                                             MmcifOutputGroups groups=MmcifOutputGroups(true));
 GEMMI_DLL cif::Block make_mmcif_block(const Structure& st,
@@ -10,6 +10,8 @@
 
 namespace gemmi {
 
+struct InstancedAssembly;
+
 struct PdbWriteOptions {
   bool minimal_file = false;    // disable many records not listed below (HEADER, TITLE, ...)
   bool atom_records = true;     // write atomic models (set to false for headers only)
@@ -53,6 +55,12 @@ GEMMI_DLL bool use_hetatm(const Residue& res);
 GEMMI_DLL void write_pdb(const Structure& st, std::ostream& os, PdbWriteOptions opt={});
 GEMMI_DLL std::string make_pdb_string(const Structure& st, PdbWriteOptions opt={});
 
+/// Writes CRYST1 (for P 1 without unit cell), atoms and END,
+/// creating one chain copy at a time (the full model is not created).
+/// Other records are not written.
+GEMMI_DLL void write_assembly_pdb(const InstancedAssembly& assembly, std::ostream& os,
+                                  PdbWriteOptions opt={});
+
 // deprecated
 inline void write_minimal_pdb(const Structure& st, std::ostream& os) {
   write_pdb(st, os, PdbWriteOptions::minimal());
@@ -264,7 +264,9 @@ struct GEMMI_DLL Topo {
   // This step stores pointers to gemmi::Atom's from model0,
   // so after this step don't add or remove atoms.
   // monlib is needed only for links.
-  void apply_all_restraints(const MonLib& monlib);
+  // Residues can be processed in parallel (n_threads); the order of
+  // restraints is the same as with a single thread.
+  void apply_all_restraints(const MonLib& monlib, int n_threads=1);
 
   // prepare bond_index, angle_index, torsion_index, plane_index
   void create_indices();
@@ -290,7 +292,7 @@ GEMMI_DLL std::unique_ptr<Topo>
 prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
                  HydrogenChange h_change, bool reorder,
                  const Logger& logger={}, bool ignore_unknown_links=false,
-                 bool use_cispeps=false);
+                 bool use_cispeps=false, int n_threads=1);
 
 
 GEMMI_DLL std::unique_ptr<ChemComp> make_chemcomp_with_restraints(const Residue& res);
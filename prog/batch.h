@@ -0,0 +1,125 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Processing a list of files (e.g. from CifWalk) on multiple threads.
+// Output printed with batch_printf() etc. is buffered per file
+// and written to stdout in the order of the list.
+
+#pragma once
+
+#include <cstdarg>    // for va_list
+#include <cstdint>    // for uint64_t
+#include <cstdio>
+#include <algorithm>  // for stable_sort
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <utility>    // for pair
+#include <vector>
+#include <gemmi/fileutil.hpp>  // for get_file_stamp
+#include <gemmi/parallel.hpp>  // for parallel_for_each_index
+#include <gemmi/sprintf.hpp>   // for GEMMI_ATTRIBUTE_FORMAT
+
+// Output buffer of the file processed in the current thread,
+// nullptr if the output goes directly to stdout.
+inline std::string*& batch_buffer() {
+  thread_local std::string* buffer = nullptr;
+  return buffer;
+}
+
+inline int batch_printf(const char* fmt, ...) GEMMI_ATTRIBUTE_FORMAT(1,2);
+inline int batch_printf(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n;
+  if (std::string* buf = batch_buffer()) {
+    va_list args2;
+    va_copy(args2, args);
+    char small[256];
+    n = std::vsnprintf(small, sizeof(small), fmt, args);
+    if (n >= (int) sizeof(small)) {
+      size_t old_size = buf->size();
+      buf->resize(old_size + n + 1);
+      std::vsnprintf(&(*buf)[old_size], n + 1, fmt, args2);
+      buf->resize(old_size + n);
+    } else if (n > 0) {
+      buf->append(small, n);
+    }
+    va_end(args2);
+  } else {
+    n = std::vprintf(fmt, args);
+  }
+  va_end(args);
+  return n;
+}
+
+inline int batch_putchar(int c) {
+  if (std::string* buf = batch_buffer()) {
+    *buf += (char) c;
+    return c;
+  }
+  return std::putchar(c);
+}
+
+inline int batch_puts(const char* s) {
+  if (std::string* buf = batch_buffer()) {
+    *buf += s;
+    *buf += '\n';
+    return 1;
+  }
+  return std::puts(s);
+}
+
+/// Calls func(i) for each paths[i] and returns the number of files for which
+/// func threw an exception (the error is printed and other files are processed).
+/// With n_threads != 1, files are processed in parallel. Each thread takes
+/// the next file from a shared queue, in which the biggest files are first,
+/// so that no thread is left with a big file at the end. The output from
+/// batch_printf() etc. is written in the order of paths, as with one thread.
+template<typename Func>
+int run_batch(const std::vector<std::string>& paths, int n_threads, Func&& func) {
+  std::atomic<int> failures{0};
+  auto call = [&](size_t i) {
+    try {
+      func(i);
+    } catch (std::exception& e) {
+      std::fflush(stdout);
+      std::fprintf(stderr, "Error when processing %s:\n\t%s\n", paths[i].c_str(), e.what());
+      ++failures;
+    }
+  };
+  if (gemmi::normalize_thread_count(n_threads) == 1 || paths.size() < 2) {
+    for (size_t i = 0; i < paths.size(); ++i)
+      call(i);
+    return failures;
+  }
+  std::vector<std::pair<uint64_t, size_t>> queue;  // (file size, index)
+  queue.reserve(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    gemmi::FileStamp stamp;
+    gemmi::get_file_stamp(paths[i], stamp);  // size stays 0 on failure
+    queue.emplace_back(stamp.size, i);
+  }
+  std::stable_sort(queue.begin(), queue.end(),
+                   [](const std::pair<uint64_t, size_t>& a,
+                      const std::pair<uint64_t, size_t>& b) { return a.first > b.first; });
+  std::vector<std::string> outputs(paths.size());
+  std::vector<char> done(paths.size(), 0);
+  size_t next_to_print = 0;
+  std::mutex mutex;
+  gemmi::parallel_for_each_index(queue.size(), n_threads, [&](size_t k) {
+    size_t i = queue[k].second;
+    batch_buffer() = &outputs[i];
+    call(i);
+    batch_buffer() = nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    done[i] = 1;
+    for (; next_to_print < paths.size() && done[next_to_print]; ++next_to_print) {
+      std::string& out = outputs[next_to_print];
+      std::fwrite(out.data(), 1, out.size(), stdout);
+      std::string().swap(out);
+    }
+  });
+  std::fflush(stdout);
+  return failures;
+}
@@ -23,7 +23,7 @@ using std::printf;
 enum OptionIndex { SigmaCutoff=AfterMapOptions, AbsCutoff,
                    MaskRadius, MaskWater,
                    MinVolume, MinScore, MinSigma, MinDensity,
-                   Dimple };
+                   Threads, Dimple };
 
 const option::Descriptor Usage[] = {
   { NoOp, 0, "", "", Arg::None,
@@ -68,6 +68,8 @@ const option::Descriptor Usage[] = {
   MapUsage[Sample],
   MapUsage[GridQuery],
   MapUsage[TimingFft],
+  { Threads, 0, "j", "threads", Arg::Int,
+    "  -j, --threads=N  \tNumber of threads for blob search (default: 1)." },
 
   { Dimple, 0, "", "dimple", Arg::None, nullptr }, // output for Dimple
   { 0, 0, 0, 0, 0, 0 }
@@ -165,7 +167,8 @@ int run(OptParser& p) {
   }
 
   // find and sort blobs
-  std::vector<gemmi::Blob> blobs = gemmi::find_blobs_by_flood_fill(grid, criteria);
+  std::vector<gemmi::Blob> blobs = gemmi::find_blobs_by_flood_fill(
+      grid, criteria, false, p.integer_or(Threads, 1));
   if (p.options[Verbose])
     printf("%zu blob%s found.\n", blobs.size(), blobs.size() == 1 ? "" : "s");
 
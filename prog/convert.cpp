@@ -1,13 +1,14 @@
 // Copyright 2017 Global Phasing Ltd.
 
 #include "gemmi/to_cif.hpp"
-#include "gemmi/to_json.hpp"   // for write_json_to_stream
+#include "gemmi/to_json.hpp"   // for write_mmjson_to_stream, ...
 #include "gemmi/polyheur.hpp"  // for setup_entities, remove_waters, ...
 #include "gemmi/modify.hpp"    // for remove_hydrogens, remove_anisou
 #include "gemmi/align.hpp"     // for assign_label_seq_id
 #include "gemmi/to_pdb.hpp"    // for write_pdb, ...
 #include "gemmi/fstream.hpp"   // for Ofstream, Ifstream
 #include "gemmi/to_mmcif.hpp"  // for update_mmcif_block
+#include "gemmi/binfile.hpp"   // for write_binary_structure
 #include "gemmi/assembly.hpp"  // for ChainNameGenerator, transform_to_assembly
 #include "gemmi/pirfasta.hpp"  // for read_pir_or_fasta
 #include "gemmi/mmread_gz.hpp" // for read_structure_gz
@@ -43,7 +44,7 @@ struct ConvArg: public Arg {
   }
 
   static option::ArgStatus CoorFormatIn(const option::Option& option, bool msg) {
-    return Choice(option, msg, {"cif", "mmcif", "pdb", "json", "mmjson",
+    return Choice(option, msg, {"cif", "mmcif", "pdb", "json", "mmjson", "bin",
                                 "chemcomp", "chemcomp:m", "chemcomp:i"});
   }
 
@@ -73,7 +74,8 @@ const option::Descriptor Usage[] = {
   { NoOp, 0, "", "", Arg::None,
     "Usage:"
     "\n " EXE_NAME " [options] INPUT_FILE OUTPUT_FILE"
-    "\n\nAllows conversion between PDB, mmCIF, and mmJSON formats."
+    "\n\nAllows conversion between PDB, mmCIF, and mmJSON formats,"
+    "\nand to gemmi binary format (for fast re-reading)."
     "\n\nGeneral options:" },
   CommonUsage[Help],
   CommonUsage[Version],
@@ -169,7 +171,8 @@ const option::Descriptor Usage[] = {
   { TrimAla, 0, "", "trim-to-ala", Arg::None,
     "  --trim-to-ala  \tTrim aminoacids to alanine." },
   { NoOp, 0, "", "", Arg::None,
-    "\nFORMAT can be specified as one of: mmcif, mmjson, pdb. chemcomp (read-only)."
+    "\nFORMAT can be specified as one of: mmcif, mmjson, pdb, bin. chemcomp (read-only)."
+    "\nbin = gemmi binary format, see docs (extension .bin)."
     "\nchemcomp = coordinates of a component from CCD or monomer library (see docs)."
     "\nWhen output file is -, write to standard output (default format: pdb)." },
   { 0, 0, 0, 0, 0, 0 }
@@ -183,6 +186,7 @@ std::string format_as_string(CoorFormat format) {
     case CoorFormat::Mmcif: return "mmcif";
     case CoorFormat::Mmjson: return "mmjson";
     case CoorFormat::ChemComp: return "chemcomp";
+    case CoorFormat::Binary: return "bin";
   }
   gemmi::unreachable();
 }
@@ -514,6 +518,11 @@ void convert(gemmi::Structure& st,
   if (options[ShortenTLC] || output_type == CoorFormat::Pdb)
     shorten_ccd_codes(st);
 
+  if (output_type == CoorFormat::Binary) {
+    gemmi::write_binary_structure(st, output);
+    return;
+  }
+
   gemmi::Ofstream os(output, &std::cout);
 
   if (output_type == CoorFormat::Mmcif || output_type == CoorFormat::Mmjson) {
@@ -521,18 +530,25 @@ void convert(gemmi::Structure& st,
       st.name = options[BlockName].arg;
     cif::Document doc;
     doc.blocks.resize(1);
+    // mmJSON atom_site values are written directly from the Structure
+    bool direct_atoms = output_type == CoorFormat::Mmjson && !options[Minimal];
     if (options[Minimal]) {
       gemmi::add_minimal_mmcif_data(st, doc.blocks[0]);
     } else {
       gemmi::MmcifOutputGroups groups(true);
       groups.auth_all = options[AllAuth];
-      gemmi::update_mmcif_block(st, doc.blocks[0], groups);
+      if (direct_atoms)
+        gemmi::impl::update_mmcif_block_without_atom_values(st, doc.blocks[0], groups);
+      else
+        gemmi::update_mmcif_block(st, doc.blocks[0], groups);
     }
     apply_cif_doc_modifications(doc, options);
 
     if (output_type == CoorFormat::Mmcif) {
       write_cif_to_stream(os.ref(), doc, cif_write_options(options[CifStyle]));
-    } else /*output_type == CoorFormat::Mmjson*/ {
+    } else if (direct_atoms) {
+      gemmi::write_mmjson_with_atoms(os.ref(), doc, st);
+    } else {
       cif::write_mmjson_to_stream(os.ref(), doc);
     }
   } else if (output_type == CoorFormat::Pdb) {
@@ -575,6 +591,10 @@ int GEMMI_MAIN(int argc, char **argv) {
     std::cerr << "The output format cannot be chemcomp.\n";
     return 1;
   }
+  if (out_type == CoorFormat::Binary && output[0] == '-' && output[1] == '\0') {
+    std::cerr << "Binary output cannot be written to stdout.\n";
+    return 1;
+  }
   if (out_type == CoorFormat::Unknown) {
     std::cerr << "The output format cannot be determined from output"
                  " filename. Use option --to.\n";
@@ -7,6 +7,7 @@
 #include "gemmi/dirwalk.hpp"
 #include "gemmi/pdb_id.hpp"    // for is_pdb_code, expand_if_pdb_code
 #include "gemmi/util.hpp"      // for replace_all
+#include <atomic>
 #include <cstdio>
 #include <cstring>
 #include <regex>
@@ -15,8 +16,8 @@
 
 #define GEMMI_PROG grep
 #include "options.h"
+#include "batch.h"
 
-using std::printf;
 using std::fprintf;
 namespace pegtl = tao::pegtl;
 namespace cif = gemmi::cif;
@@ -28,7 +29,7 @@ enum OptionIndex {
   FromFile=4, NamePattern, PdbDirSf, Recurse, MaxCount, OneBlock,
   ExtRegexp, And,
   Delim, WithFileName, NoBlockName, WithLineNumbers, WithTag,
-  OnlyTags, Summarize, MatchingFiles, NonMatchingFiles, Count, Raw
+  OnlyTags, Summarize, MatchingFiles, NonMatchingFiles, Count, Raw, Threads
 };
 
 const option::Descriptor Usage[] = {
@@ -85,6 +86,8 @@ const option::Descriptor Usage[] = {
     "  -w, --raw  \tinclude '?', '.', and string quotes" },
   { Summarize, 0, "s", "summarize", Arg::None,
     "  -s, --summarize  \tdisplay joint statistics for all files" },
+  { Threads, 0, "j", "threads", Arg::Int,
+    "  -j, --threads=N  \tsearch N files in parallel (output order is kept)" },
   { 0, 0, 0, 0, 0, 0 }
 };
 
@@ -132,15 +135,15 @@ void process_match(const Input& in, GrepParams& par, int n) {
     return;
   const char* sep = par.delim.empty() ? ":" : par.delim.c_str();
   if (par.with_filename)
-    printf("%s%s", par.path, sep);
+    batch_printf("%s%s", par.path, sep);
   if (par.with_blockname)
-    printf("%s%s", par.block_name.c_str(), sep);
+    batch_printf("%s%s", par.block_name.c_str(), sep);
   if (par.with_line_numbers)
-    printf("%zu%s", in.iterator().line, sep);
+    batch_printf("%zu%s", in.iterator().line, sep);
   if (par.with_tag) {
     const std::string& tag = n < 0 ? par.search_tag : par.multi_tags[n];
     if (par.only_tags) {
-      printf("%s\n", tag.c_str());
+      batch_printf("%s\n", tag.c_str());
       if (n == -1)
         par.match_column = -1;
       else
@@ -148,12 +151,12 @@ void process_match(const Input& in, GrepParams& par, int n) {
       return;
     }
     if (par.delim.empty())
-      printf("[%s] ", tag.c_str());
+      batch_printf("[%s] ", tag.c_str());
     else
-      printf("%s%s", tag.c_str(), sep);
+      batch_printf("%s%s", tag.c_str(), sep);
   }
   std::string value = par.raw ? in.string() : cif::as_string(in.string());
-  printf("%s\n", value.c_str());
+  batch_printf("%s\n", value.c_str());
   if (par.counters[0] == par.max_count)
     throw true;
 }
@@ -189,28 +192,28 @@ void process_multi_match(GrepParams& par) {
       continue;
     const char* sep = par.delim.empty() ? ":" : par.delim.c_str();
     if (par.with_filename)
-      printf("%s%s", par.path, sep);
+      batch_printf("%s%s", par.path, sep);
     if (par.with_blockname)
-      printf("%s%s", par.block_name.c_str(), sep);
+      batch_printf("%s%s", par.block_name.c_str(), sep);
     if (par.with_tag) {
       if (par.delim.empty())
-        printf("[%s] ", par.multi_tags[0].c_str());
+        batch_printf("[%s] ", par.multi_tags[0].c_str());
       else
-        printf("%s%s", par.multi_tags[0].c_str(), sep);
+        batch_printf("%s%s", par.multi_tags[0].c_str(), sep);
     }
     for (size_t j = 0; j != par.multi_values.size(); ++j) {
       if (j != 0)
-        std::fputs(par.delim.empty() ? ";" : par.delim.c_str(), stdout);
+        batch_printf("%s", par.delim.empty() ? ";" : par.delim.c_str());
       const auto& v = par.multi_values[j];
       if (!v.empty()) {
         const std::string& raw_str = v[i < v.size() ? i : 0];
         std::string s = par.raw ? raw_str : cif::as_string(raw_str);
         if (s.find_first_of(need_escaping) != std::string::npos)
           s = escape(s, need_escaping[2]);
-        printf("%s", s.c_str());
+        batch_printf("%s", s.c_str());
       }
     }
-    std::putc('\n', stdout);
+    batch_putchar('\n');
     if (par.counters[0] == par.max_count)
       break;
   }
@@ -221,17 +224,17 @@ void process_multi_match(GrepParams& par) {
 void print_count(const GrepParams& par) {
   const char* sep = par.delim.empty() ? ":" : par.delim.c_str();
   if (par.with_filename)
-    printf("%s%s", par.path, sep);
+    batch_printf("%s%s", par.path, sep);
   if (par.with_blockname)
-    printf("%s%s", par.block_name.c_str(), sep);
+    batch_printf("%s%s", par.block_name.c_str(), sep);
   bool first = true;
   for (int c : par.counters) {
     if (!first)
-      std::fputs(par.delim.empty() ? ";" : par.delim.c_str(), stdout);
-    printf("%d", c);
+      batch_printf("%s", par.delim.empty() ? ";" : par.delim.c_str());
+    batch_printf("%d", c);
     first = false;
   }
-  std::putc('\n', stdout);
+  batch_putchar('\n');
 }
 
 bool tag_matches(const GrepParams& p, const std::string& str) {
@@ -470,7 +473,7 @@ void grep_file(const std::string& path, GrepParams& par, int& err_count) {
     print_count(par);
   } else if (par.only_filenames) {
     if (par.inverse == (par.counters[0] == 0))
-      printf("%s\n", par.path);
+      batch_printf("%s\n", par.path);
   } else {
     process_multi_match(par);
   }
@@ -551,41 +554,36 @@ int GEMMI_MAIN(int argc, char **argv) {
     }
   }
 
-  size_t file_count = 0;
-  int err_count = 0;
+  // files are listed first, and then searched (possibly in parallel)
+  std::vector<std::string> files;
+  std::vector<char> one_block;  // PDB code implies -O
   try {
     auto paths = p.paths_from_args_or_file(FromFile, 1);
     char expand_type = p.options[PdbDirSf] ? 'S' : 'M';
+    auto add = [&](const std::string& file, bool pdb_code) {
+      files.push_back(file);
+      one_block.push_back(pdb_code || p.options[OneBlock]);
+    };
     for (const std::string& path : paths) {
       if (path == "-") {
-        grep_file(path, params, err_count);
-        file_count++;
+        add(path, false);
       } else if (p.options[FromFile] ? starts_with_pdb_code(path)
                                      : gemmi::is_pdb_code(path)) {
-        std::string real_path = gemmi::expand_if_pdb_code(path.substr(0, 4), expand_type);
-        params.last_block = true;  // PDB code implies -O
-        grep_file(real_path, params, err_count);
-        params.last_block = p.options[OneBlock];
-        file_count++;
+        add(gemmi::expand_if_pdb_code(path.substr(0, 4), expand_type), true);
       } else {
         if (p.options[NamePattern]) {
           std::string pattern = p.options[NamePattern].arg;
-          for (const std::string& file : gemmi::GlobWalk(path, pattern)) {
-            grep_file(file, params, err_count);
-            file_count++;
-          }
+          for (const std::string& file : gemmi::GlobWalk(path, pattern))
+            add(file, false);
         } else if (!p.options[Recurse] && (gemmi::giends_with(path, ".cif") ||
                                            gemmi::giends_with(path, ".mmcif"))) {
           // Avoid tinydir_file_open (used by CifWalk) when not necessary.
           // It was reported to fail on a Mac with files on network drive.
           // Probably reading the parent directory failed, no idea why.
-          grep_file(path, params, err_count);
-          file_count++;
+          add(path, false);
         } else {
-          for (const std::string& file : gemmi::CifWalk(path)) {
-            grep_file(file, params, err_count);
-            file_count++;
-          }
+          for (const std::string& file : gemmi::CifWalk(path))
+            add(file, false);
         }
       }
     }
@@ -593,10 +591,23 @@ int GEMMI_MAIN(int argc, char **argv) {
     fprintf(stderr, "Error: %s\n", e.what());
     return 2;
   }
+  size_t file_count = files.size();
+  std::atomic<int> errors{0};
+  std::atomic<size_t> total_count{0};
+  run_batch(files, p.integer_or(Threads, 1), [&](size_t i) {
+    GrepParams par = params;  // each file has own working parameters
+    par.last_block = one_block[i];
+    int file_errors = 0;
+    grep_file(files[i], par, file_errors);
+    errors += file_errors;
+    total_count += par.total_count;
+  });
+  int err_count = errors;
+  params.total_count = total_count;
   if (p.options[Summarize]) {
-    printf("Total count in %zu files: %zu\n", file_count, params.total_count);
+    batch_printf("Total count in %zu files: %zu\n", file_count, params.total_count);
     if (err_count > 0)
-      printf("Errors encountered when reading %d files.\n", err_count);
+      batch_printf("Errors encountered when reading %d files.\n", err_count);
   }
   if (err_count > 0)
     return 2;
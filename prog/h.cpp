@@ -22,7 +22,8 @@ namespace cif = gemmi::cif;
 namespace {
 
 enum OptionIndex {
-  FormatIn=AfterMonLibOptions, Sort, Update, RemoveH, KeepH, Water, Unique, NoChange
+  FormatIn=AfterMonLibOptions, Sort, Update, RemoveH, KeepH, Water, Unique, NoChange,
+  Threads
 };
 
 const option::Descriptor Usage[] = {
@@ -45,6 +46,8 @@ const option::Descriptor Usage[] = {
   { Update, 0, "", "update", Arg::None,
     "  --update  \tIf deprecated atom names (from _chem_comp_atom.alt_atom_id)"
     " are used in the model, change them." },
+  { Threads, 0, "j", "threads", Arg::Int,
+    "  -j, --threads=N  \tNumber of threads (default: 1)." },
   { NoOp, 0, "", "", Arg::None,
     "Hydrogen options, mutually exclusive. Default: add hydrogens, but not to water." },
   { Water, 0, "", "water", Arg::None,
@@ -133,7 +136,9 @@ int GEMMI_MAIN(int argc, char **argv) {
         monlib.update_old_atom_names(st, {&gemmi::Logger::to_stdout});
       for (size_t i = 0; i != st.models.size(); ++i) {
         // preparing topology modifies hydrogens in the model
-        prepare_topology(st, monlib, i, h_change, p.options[Sort], {&gemmi::Logger::to_stderr});
+        prepare_topology(st, monlib, i, h_change, p.options[Sort],
+                         {&gemmi::Logger::to_stderr}, false, false,
+                         p.integer_or(Threads, 1));
       }
     }
     if (p.options[Verbose])
@@ -4,6 +4,7 @@
 #include <cstdlib>  // for getenv, strtol
 #include <cstring>  // for strstr
 #include <vector>
+#include "batch.h"  // for batch_printf, batch_putchar
 
 #define USE_UNICODE
 #ifdef USE_UNICODE
@@ -25,8 +26,11 @@ inline int terminal_columns() {
 template<typename T>
 void print_histogram(const std::vector<T>& data, double min, double max) {
 #ifdef USE_UNICODE
-  const char* locale = std::setlocale(LC_CTYPE, "");
-  const bool use_utf = (locale && std::strstr(locale, "UTF-8") != nullptr);
+  // setlocale() is not thread-safe, call it only once
+  static const bool use_utf = [] {
+    const char* locale = std::setlocale(LC_CTYPE, "");
+    return locale && std::strstr(locale, "UTF-8") != nullptr;
+  }();
   const int rows = use_utf ? 12 : 24;
 #else
   constexpr int rows = 24;
@@ -50,14 +54,14 @@ void print_histogram(const std::vector<T>& data, double min, double max) {
         } else if (h > i - 1) {
           c = 0x2581 + static_cast<int>((h - (i - 1)) * 7);
         }
-        std::printf("%lc", c);
+        batch_printf("%lc", c);
       } else
 #endif
       {
-        std::putchar(h > i + 0.5 ? '#' : ' ');
+        batch_putchar(h > i + 0.5 ? '#' : ' ');
       }
     }
-    std::putchar('\n');
+    batch_putchar('\n');
   }
 }
 
@@ -3,6 +3,8 @@
 
 #include <stdio.h>
 #include <cstring>
+#include <exception>
+#include <gemmi/profile.hpp>
 
 void print_version(const char* program_name, bool verbose);  // in options.h
 
@@ -93,7 +95,7 @@ void print_usage() {
          "which is a joint project of CCP4 and Global Phasing Ltd.\n"
          "Licence: Mozilla Public License 2.0. Copyright Global Phasing Ltd.\n"
          "https://github.com/project-gemmi/gemmi\n\n"
-         "Usage: gemmi [--version] [--help] <command> [<args>]\n\n"
+         "Usage: gemmi [--version] [--help] [--profile[-trace]=FILE] <command> [<args>]\n\n"
          "Commands:\n");
   for (SubCmd& sub : subcommands)
     printf(" %-13s %s\n", sub.cmd, sub.desc);
@@ -135,6 +137,8 @@ int main(int argc, char** argv)
   bool verbose = false;
   bool version = false;
   bool help = false;
+  const char* profile_path = nullptr;
+  bool profile_trace = false;
   int command = 0;
   int wrong_option = 0;
   for (int i = 1; i < argc && wrong_option == 0; ++i) {
@@ -146,6 +150,12 @@ int main(int argc, char** argv)
         help = true;
       else if (eq(arg+2, "verbose"))
         verbose = true;
+      else if (std::strncmp(arg+2, "profile=", 8) == 0 && arg[10] != '\0')
+        profile_path = arg + 10;
+      else if (std::strncmp(arg+2, "profile-trace=", 14) == 0 && arg[16] != '\0') {
+        profile_path = arg + 16;
+        profile_trace = true;
+      }
       else
         wrong_option = i;
     } else if (arg[0] == '-' && arg[1] != '-') {   // short options
@@ -195,5 +205,27 @@ int main(int argc, char** argv)
     char* args[] = { argv[0], argv[command], help_str };
     return (*func)(3, args);
   }
-  return (*func)(argc - command, &argv[command]);
+  if (!profile_path)
+    return (*func)(argc - command, &argv[command]);
+
+  // --profile: time the subcommand and write a JSON summary or trace
+  gemmi::Profiler& profiler = gemmi::Profiler::instance();
+  if (!gemmi::Profiler::compiled_in())
+    fprintf(stderr, "Warning: gemmi was built without GEMMI_PROFILE,"
+                    " only the total time is recorded.\n");
+  profiler.clear();
+  profiler.enable();
+  int ret;
+  {
+    gemmi::ProfileScope scope(argv[command]);
+    ret = (*func)(argc - command, &argv[command]);
+  }
+  profiler.enable(false);
+  try {
+    profiler.write_file(profile_path, profile_trace);
+  } catch (std::exception& e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  return ret;
 }
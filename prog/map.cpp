@@ -14,7 +14,8 @@
 namespace {
 
 enum OptionIndex {
-  Dump=4, Deltas, CheckSym, Reorder, Full, Mask, Threshold, Fraction
+  Dump=4, Deltas, CheckSym, Reorder, Full, Mask, Resampled,
+  Threshold, Fraction, Spacing, Order, Threads
 };
 
 const option::Descriptor Usage[] = {
@@ -35,11 +36,21 @@ const option::Descriptor Usage[] = {
     "  --write-full=FILE  \tWrite map extended to cover whole unit cell." },
   { Mask, 0, "", "write-mask", Arg::Required,
     "  --write-mask=FILE  \tMake a mask by thresholding the map." },
+  { Resampled, 0, "", "write-resampled", Arg::Required,
+    "  --write-resampled=FILE  \tWrite map interpolated to a new grid"
+    " (requires --spacing)." },
   { NoOp, 0, "", "", Arg::None, "\nOptions for making a mask:" },
   { Threshold, 0, "", "threshold", Arg::Float,
     "  --threshold  \tExplicit threshold value for 0/1 mask." },
   { Fraction, 0, "", "fraction", Arg::Float,
     "  --fraction  \tThreshold is selected to have this fraction of 1's." },
+  { NoOp, 0, "", "", Arg::None, "\nOptions for resampling:" },
+  { Spacing, 0, "", "spacing", Arg::Float,
+    "  --spacing=D  \tMax. grid spacing in the resampled map (in A)." },
+  { Order, 0, "", "order", Arg::Int,
+    "  --order=N  \tInterpolation: 0=nearest, 1=trilinear (default), 3=tricubic." },
+  { Threads, 0, "j", "threads", Arg::Int,
+    "  -j, --threads=N  \tNumber of threads used for interpolation (default: 1)." },
   { 0, 0, 0, 0, 0, 0 }
 };
 
@@ -169,15 +180,26 @@ int GEMMI_MAIN(int argc, char **argv) {
   p.check_exclusive_pair(Threshold, Fraction);
   //bool verbose = p.options[Verbose];
 
-  if (p.nonOptionsCount() > 1 && (p.options[Reorder] || p.options[Full])) {
+  if (p.nonOptionsCount() > 1 &&
+      (p.options[Reorder] || p.options[Full] || p.options[Resampled])) {
     std::fprintf(stderr, "Option --write-... can be only used "
                          "with a single input file.\n");
     return 1;
   }
+  if (p.options[Resampled] && !p.options[Spacing]) {
+    std::fprintf(stderr, "Option --write-resampled requires --spacing.\n");
+    return 1;
+  }
+  int order = p.integer_or(Order, 1);
+  if (order != 0 && order != 1 && order != 3) {
+    std::fprintf(stderr, "Option --order must be 0, 1 or 3.\n");
+    return 1;
+  }
 
   bool dump = (p.options[Dump] ||
                !(p.options[Deltas] || p.options[CheckSym] ||
-                 p.options[Reorder] || p.options[Full] || p.options[Mask]));
+                 p.options[Reorder] || p.options[Full] || p.options[Mask] ||
+                 p.options[Resampled]));
   try {
     for (int i = 0; i < p.nonOptionsCount(); ++i) {
       const char* input = p.nonOption(i);
@@ -211,7 +233,7 @@ int GEMMI_MAIN(int argc, char **argv) {
             return std::isnan(a) ? b : a;
         });
         map.grid.calculate_spacing();
-      } else if (p.options[Full] || p.options[Mask]) {
+      } else if (p.options[Full] || p.options[Mask] || p.options[Resampled]) {
         map.setup(NAN, gemmi::MapSetup::Full);
       }
       if (p.options[Full]) {
@@ -249,6 +271,20 @@ int GEMMI_MAIN(int argc, char **argv) {
         mask.update_ccp4_header(0);
         mask.write_ccp4_map(p.options[Mask].arg);
       }
+      if (p.options[Resampled]) {
+        gemmi::Ccp4<> resampled;
+        resampled.grid.spacegroup = map.grid.spacegroup;
+        resampled.grid.unit_cell = map.grid.unit_cell;
+        double spacing = std::atof(p.options[Spacing].arg);
+        resampled.grid.set_size_from_spacing(spacing, gemmi::GridSizeRounding::Up);
+        gemmi::interpolate_grid(resampled.grid, map.grid, gemmi::Transform{}, order,
+                                p.integer_or(Threads, 1));
+        std::fprintf(stderr, "Resampled %d x %d x %d -> %d x %d x %d\n",
+                     map.grid.nu, map.grid.nv, map.grid.nw,
+                     resampled.grid.nu, resampled.grid.nv, resampled.grid.nw);
+        resampled.update_ccp4_header(2);
+        resampled.write_ccp4_map(p.options[Resampled].arg);
+      }
     }
   } catch (std::runtime_error& e) {
     std::fprintf(stderr, "ERROR: %s\n", e.what());
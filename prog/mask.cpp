@@ -16,7 +16,7 @@ namespace {
 enum OptionIndex {
   Timing=4, GridSpac, GridDims, Radius, RProbe, RShrink,
   IslandLimit, Hydrogens, AnyOccupancy, CctbxCompat, RefmacCompat, Invert,
-  SetOccupancy
+  SetOccupancy, DistanceMap, Threads
 };
 
 struct MaskArg {
@@ -59,6 +59,11 @@ const option::Descriptor Usage[] = {
     "  --refmac-compat  \tUse radii compatible with Refmac." },
   { Invert, 0, "I", "invert", Arg::None,
     "  -I, --invert  \t0 for solvent, 1 for molecule." },
+  { DistanceMap, 0, "", "distance-map", Arg::Float,
+    "  --distance-map=DMAX  \tInstead of the mask, write distance from the"
+    " molecule (in A, 0 inside), up to DMAX." },
+  { Threads, 0, "j", "threads", Arg::Int,
+    "  -j, --threads=N  \tNumber of threads (default: 1)." },
   { 0, 0, 0, 0, 0, 0 }
 };
 
@@ -76,6 +81,7 @@ int GEMMI_MAIN(int argc, char **argv) {
   p.check_exclusive_pair(Radius, RProbe);
   p.check_exclusive_pair(Radius, CctbxCompat);
   p.check_exclusive_pair(Radius, RefmacCompat);
+  p.check_exclusive_pair(Invert, DistanceMap);
 
   if (p.options[Verbose])
     std::fprintf(stderr, "Converting %s ...\n", input);
@@ -137,6 +143,7 @@ int GEMMI_MAIN(int argc, char **argv) {
       masker.ignore_zero_occupancy_atoms = false;
     if (p.options[SetOccupancy])
       masker.use_atom_occupancy = true;
+    masker.n_threads = p.integer_or(Threads, 1);
 
     timer.start();
     masker.clear(mask.grid);
@@ -193,6 +200,16 @@ int GEMMI_MAIN(int argc, char **argv) {
       masker.invert(mask.grid);
 
     int mode = masker.use_atom_occupancy ? 2 : 0;
+    if (p.options[DistanceMap]) {
+      timer.start();
+      double max_dist = std::atof(p.options[DistanceMap].arg);
+      mask.grid = gemmi::distance_transform(mask.grid, [](float x) { return x < 0.5f; },
+                                            max_dist, masker.n_threads);
+      for (float& d : mask.grid.data)
+        d = std::min(d, (float) max_dist);
+      timer.print("Distance map calculated in");
+      mode = 2;
+    }
     mask.update_ccp4_header(mode, true);
     mask.write_ccp4_map(output);
   } catch (std::runtime_error& e) {
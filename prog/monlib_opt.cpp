@@ -74,7 +74,10 @@ void read_monomer_lib_and_user_files(gemmi::MonLib& monlib,
   if (args.monomer_dir) {
     if (args.verbose)
       fprintf(stderr, "Reading monomer library...\n");
-    monlib.read_monomer_lib(args.monomer_dir, wanted, {&gemmi::Logger::to_stderr});
+    // optional binary cache of the parsed monomer library files
+    const char* cache_path = std::getenv("GEMMI_MONLIB_CACHE");
+    monlib.read_monomer_lib(args.monomer_dir, wanted, {&gemmi::Logger::to_stderr},
+                            cache_path ? cache_path : "");
   }
   auto is_found = [&](const std::string& s) { return monlib.monomers.count(s); };
   gemmi::vector_remove_if(wanted, is_found);
@@ -1,6 +1,7 @@
 // Copyright 2018 Global Phasing Ltd.
 
 #include <stdio.h>
+#include <atomic>
 #include <string>
 #include "gemmi/select.hpp"
 #include "gemmi/polyheur.hpp"  // for setup_entities
@@ -12,11 +13,12 @@
 
 #define GEMMI_PROG residues
 #include "options.h"
+#include "batch.h"             // for run_batch, batch_printf
 
 namespace {
 
 enum OptionIndex {
-  FormatIn=4, Match, Label, CheckSeqId, NoAlt, Short, Chains, Ent
+  FormatIn=4, Match, Label, CheckSeqId, NoAlt, Short, Chains, Ent, Threads
 };
 
 const option::Descriptor Usage[] = {
@@ -41,6 +43,8 @@ const option::Descriptor Usage[] = {
     "  -e, --entities  \tList (so-called, in mmCIF speak) entities." },
   { Chains, 0, "c", "chains", Arg::None,
     "  -c, --chains  \tList chain IDs." },
+  { Threads, 0, "j", "threads", Arg::Int,
+    "  -j, --threads=N  \tProcess N files in parallel (output order is kept)." },
   { NoOp, 0, "", "", Arg::None,
     "INPUT is a coordinate file (mmCIF, PDB, etc)."
     "\nThe optional selection SEL has MMDB syntax:"
@@ -75,9 +79,9 @@ bool check_sequence_id(const gemmi::Structure& st) {
       for (const gemmi::Residue& res : chain.residues) {
         if (prev_res) {
           if (prev_res->seqid == res.seqid) {
-            printf("Microheterogeneity in %s%s %s %s:  ",
-                   st.name.c_str(), model_num.c_str(), chain.name.c_str(),
-                   res.seqid.str().c_str());
+            batch_printf("Microheterogeneity in %s%s %s %s:  ",
+                         st.name.c_str(), model_num.c_str(), chain.name.c_str(),
+                         res.seqid.str().c_str());
             char alt = get_primary_altloc(res);
             bool no_alt = (alt == ' ');
             bool dup_alt = false;
@@ -87,24 +91,24 @@ bool check_sequence_id(const gemmi::Structure& st) {
                 no_alt = true;
               else if (alt2 == alt)
                 dup_alt = true;
-              printf("%s (%c) = ", r->name.c_str(), alt2);
+              batch_printf("%s (%c) = ", r->name.c_str(), alt2);
             }
-            printf("%s (%c)\n", res.name.c_str(), alt);
+            batch_printf("%s (%c)\n", res.name.c_str(), alt);
             if (no_alt || dup_alt) {
               error = true;
-              printf(" ERROR: microheterogeneity %s altloc\n",
-                     no_alt ? "without" : "with duplicated");
+              batch_printf(" ERROR: microheterogeneity %s altloc\n",
+                           no_alt ? "without" : "with duplicated");
             }
           } else if (res.seqid < prev_res->seqid) {
-            printf("Unordered sequence ID in %s%s %s: %s > %s\n",
-                   st.name.c_str(), model_num.c_str(), chain.name.c_str(),
-                   prev_res->seqid.str().c_str(), res.seqid.str().c_str());
+            batch_printf("Unordered sequence ID in %s%s %s: %s > %s\n",
+                         st.name.c_str(), model_num.c_str(), chain.name.c_str(),
+                         prev_res->seqid.str().c_str(), res.seqid.str().c_str());
             for (const gemmi::Residue* r = chain.residues.data(); r < prev_res; ++r)
               if (r->seqid == res.seqid) {
                 error = true;
-                printf("ERROR: duplicated sequence ID in %s%s %s: %s\n",
-                       st.name.c_str(), model_num.c_str(), chain.name.c_str(),
-                       res.seqid.str().c_str());
+                batch_printf("ERROR: duplicated sequence ID in %s%s %s: %s\n",
+                             st.name.c_str(), model_num.c_str(), chain.name.c_str(),
+                             res.seqid.str().c_str());
                 break;
               }
           }
@@ -114,9 +118,9 @@ bool check_sequence_id(const gemmi::Structure& st) {
         // had the same seqid and got read as one residue).
         if (!check_if_atoms_are_unique(res)) {
           error = true;
-          printf("ERROR: duplicated atoms in %s%s %s %s\n",
-                 st.name.c_str(), model_num.c_str(), chain.name.c_str(),
-                 res.seqid.str().c_str());
+          batch_printf("ERROR: duplicated atoms in %s%s %s %s\n",
+                       st.name.c_str(), model_num.c_str(), chain.name.c_str(),
+                       res.seqid.str().c_str());
         }
         prev_res = &res;
       }
@@ -133,38 +137,38 @@ void print_long_info(const gemmi::Model& model, OptParser& p) {
       if (res.atoms.empty())
         continue;
       if (p.options[Label])
-        printf("%s (%-3s %4s%c (%-4s %s ",
-               chain.name.c_str(), (res.subchain + ")").c_str(),
-               res.seqid.num.str().c_str(), res.seqid.icode,
-               (res.label_seq.str('.') + ")").c_str(),
-               res.name.c_str());
+        batch_printf("%s (%-3s %4s%c (%-4s %s ",
+                     chain.name.c_str(), (res.subchain + ")").c_str(),
+                     res.seqid.num.str().c_str(), res.seqid.icode,
+                     (res.label_seq.str('.') + ")").c_str(),
+                     res.name.c_str());
       else
-        printf("%s %4s%c %s ",
-               chain.name.c_str(),
-               res.seqid.num.str().c_str(), res.seqid.icode,
-               res.name.c_str());
+        batch_printf("%s %4s%c %s ",
+                     chain.name.c_str(),
+                     res.seqid.num.str().c_str(), res.seqid.icode,
+                     res.name.c_str());
       const std::string* prev = nullptr;
       for (const gemmi::Atom& at : res.atoms)
         if (!prev || *prev != at.name) {
-          printf(" %s", at.name.c_str());
+          batch_printf(" %s", at.name.c_str());
           if (print_alt && at.altloc)
-            printf(":%c", at.altloc);
+            batch_printf(":%c", at.altloc);
           prev = &at.name;
         } else {
           if (print_alt) {
             if GEMMI_UNLIKELY((&at-1)->altloc == '\0')
-              putchar(':');
-            putchar(',');
+              batch_putchar(':');
+            batch_putchar(',');
             if (at.altloc)
-              putchar(at.altloc);
+              batch_putchar(at.altloc);
           }
         }
-      putchar('\n');
+      batch_putchar('\n');
       line_count++;
 
     }
     if (line_count != 0)
-      putchar('\n');
+      batch_putchar('\n');
   }
 }
 
@@ -179,84 +183,84 @@ void print_short_info(const gemmi::Model& model, OptParser& p) {
     for (const gemmi::Residue& res : chain.residues) {
       if (!chain.is_first_in_group(res)) {  // microheterogeneity
         if (counter < 8 && short_level < 3)
-          col += printf("/%s", res.name.c_str());
+          col += batch_printf("/%s", res.name.c_str());
         continue;
       }
       if (res.entity_type != prev) {
         if (counter != 0) {
           if (short_level > 1 && col >= kLimit)
-            printf("...  (%d residues)", counter);
-          putchar('\n');
+            batch_printf("...  (%d residues)", counter);
+          batch_putchar('\n');
         }
         const char* etype = entity_type_to_string(res.entity_type);
         if (p.options[Label])
-          col = printf("%s (%s) %-11s", chain.name.c_str(), res.subchain.c_str(), etype);
+          col = batch_printf("%s (%s) %-11s", chain.name.c_str(), res.subchain.c_str(), etype);
         else
-          col = printf("%-4s %-11s ", chain.name.c_str(), etype);
+          col = batch_printf("%-4s %-11s ", chain.name.c_str(), etype);
         counter = 0;
         prev = res.entity_type;
       }
       if (short_level == 1) {
         if (counter == kWrap) {
-          printf("\n                 ");
+          batch_printf("\n                 ");
           counter = 0;
         }
-        printf(" %5s%c %-3s",
-               res.seqid.num.str().c_str(), res.seqid.icode, res.name.c_str());
+        batch_printf(" %5s%c %-3s",
+                     res.seqid.num.str().c_str(), res.seqid.icode, res.name.c_str());
       } else {
         if (col < kLimit) {
           if (short_level == 2) {
-            col += printf(" %-3s", res.name.c_str());
+            col += batch_printf(" %-3s", res.name.c_str());
           } else { // short_level > 2
             // cf. pdbx_one_letter_code()
             char c = gemmi::find_tabulated_residue(res.name).fasta_code();
             if (res.entity_type == gemmi::EntityType::Polymer && c != 'X')
-              col += printf("%c", c);
+              col += batch_printf("%c", c);
             else
-              col += printf("(%s)", res.name.c_str());
+              col += batch_printf("(%s)", res.name.c_str());
           }
         }
       }
       ++counter;
     }
     if (short_level > 1 && col >= kLimit)
-      printf("...  (%d residues)", counter);
-    putchar('\n');
+      batch_printf("...  (%d residues)", counter);
+    batch_putchar('\n');
   }
 }
 
 void print_chain_info(const gemmi::Model& model) {
   for (const gemmi::Chain& chain : model.chains) {
-    printf("%s  length/count:", chain.name.c_str());
+    batch_printf("%s  length/count:", chain.name.c_str());
     gemmi::EntityType prev_et = gemmi::EntityType::Unknown;
     int counter = 0;
     for (const gemmi::Residue& res :  chain.first_conformer()) {
       if (res.entity_type != prev_et) {
         if (counter != 0) {
-          printf("  %s %d", gemmi::entity_type_to_string(prev_et), counter);
+          batch_printf("  %s %d", gemmi::entity_type_to_string(prev_et), counter);
         }
         counter = 0;
         prev_et = res.entity_type;
       }
       ++counter;
     }
-    printf("  %s %d", gemmi::entity_type_to_string(prev_et), counter);
-    putchar('\n');
+    batch_printf("  %s %d", gemmi::entity_type_to_string(prev_et), counter);
+    batch_putchar('\n');
   }
 }
 
 void print_entity_info(const gemmi::Structure& st) {
   if (st.models.size() > 1)
-    printf("Checking only the first model.\n");
+    batch_printf("Checking only the first model.\n");
   const gemmi::Model& model = st.models.at(0);
-  printf("Polymers\n");
+  batch_printf("Polymers\n");
   std::map<std::string, std::string> sub_to_strand = model.subchain_to_chain();
   for (const gemmi::Entity& ent : st.entities)
     if (ent.entity_type == gemmi::EntityType::Polymer) {
-      printf("  entity %s, %s, length %zu, subchains:\n",
-             ent.name.c_str(),
-             gemmi::polymer_type_to_string(ent.polymer_type),
-             ent.full_sequence.size());
+      batch_printf("  entity %s, %s, length %zu, subchains:\n",
+                   ent.name.c_str(),
+                   gemmi::polymer_type_to_string(ent.polymer_type),
+                   ent.full_sequence.size());
       for (const std::string& sub : ent.subchains) {
         auto strand = sub_to_strand.find(sub);
         if (strand == sub_to_strand.end())
@@ -272,30 +276,30 @@ void print_entity_info(const gemmi::Structure& st) {
           prev = *res.label_seq;
           ++length;
         }
-        printf("    - %s from strand %s, %d residues",
-               sub.c_str(), strand->second.c_str(), length);
+        batch_printf("    - %s from strand %s, %d residues",
+                     sub.c_str(), strand->second.c_str(), length);
         if (!polymer.empty()) {
-          printf(": %s-%s", polymer.front().label_seq.str().c_str(),
+          batch_printf(": %s-%s", polymer.front().label_seq.str().c_str(),
                             polymer.back().label_seq.str().c_str());
           if (!gaps.empty()) {
-            printf(" except");
+            batch_printf(" except");
             for (std::pair<int, int> gap : gaps) {
-              printf(" %d", gap.first);
+              batch_printf(" %d", gap.first);
               if (gap.second != gap.first)
-                printf("-%d", gap.second);
+                batch_printf("-%d", gap.second);
             }
           }
         }
-        putchar('\n');
+        batch_putchar('\n');
         if (!ent.sifts_unp_acc.empty())
-          printf("    SIFTS mapping: %s\n", gemmi::join_str(ent.sifts_unp_acc, ' ').c_str());
+          batch_printf("    SIFTS mapping: %s\n", gemmi::join_str(ent.sifts_unp_acc, ' ').c_str());
       }
     }
-  printf("Others\n");
+  batch_printf("Others\n");
   for (const gemmi::Entity& ent : st.entities)
     if (ent.entity_type != gemmi::EntityType::Polymer) {
-      printf("  entity %s, %s",
-             ent.name.c_str(), gemmi::entity_type_to_string(ent.entity_type));
+      batch_printf("  entity %s, %s",
+                   ent.name.c_str(), gemmi::entity_type_to_string(ent.entity_type));
       if (ent.entity_type != gemmi::EntityType::Branched) {
         // one residue is expected
         std::string name;
@@ -308,9 +312,9 @@ void print_entity_info(const gemmi::Structure& st) {
               break;
             }
           }
-        printf(" (%s)", name.c_str());
+        batch_printf(" (%s)", name.c_str());
       }
-      printf(", subchains: %s\n", gemmi::join_str(ent.subchains, ' ').c_str());
+      batch_printf(", subchains: %s\n", gemmi::join_str(ent.subchains, ' ').c_str());
     }
 }
 
@@ -321,52 +325,57 @@ int GEMMI_MAIN(int argc, char **argv) {
   p.simple_parse(argc, argv, Usage);
   p.require_input_files_as_args();
   gemmi::CoorFormat format = coor_format_as_enum(p.options[FormatIn]);
-  int status = 0;
+  std::vector<std::string> inputs;
   try {
-    for (int i = 0; i < p.nonOptionsCount(); ++i) {
-      if (i != 0)
-        putchar('\n');
-      std::string input = p.coordinate_input_file(i);
-      printf("%s\n", input.c_str());
-      gemmi::Structure st = gemmi::read_structure_gz(input, format);
-      if (p.options[Match]) {
-        gemmi::Selection sel(p.options[Match].arg);
-        sel.remove_not_selected(st);
-      }
-      if (p.options[Label] || p.options[Ent]) {
-        gemmi::setup_entities(st);
-        // hidden feature: -ll generates label_seq even if SEQRES is missing
-        bool force = p.options[Label].count() > 1;
-        gemmi::assign_label_seq_id(st, force);
-      } else if (p.options[Short]) {
-        gemmi::add_entity_types(st, false);
-      }
-      if (p.options[CheckSeqId]) {
-        bool ok = check_sequence_id(st);
-        if (!ok)
-          ++status;
-        continue;
-      }
-      if (p.options[Ent]) {
-        print_entity_info(st);
-        continue;
-      }
-      if (p.options[Chains])
-        st.merge_chain_parts();
-      for (gemmi::Model& model : st.models) {
-        if (st.models.size() != 1)
-          printf("Model %d\n", model.num);
-        if (p.options[Chains])
-          print_chain_info(model);
-        else if (p.options[Short])
-          print_short_info(model, p);
-        else
-          print_long_info(model, p);
-      }
-    }
+    for (int i = 0; i < p.nonOptionsCount(); ++i)
+      inputs.push_back(p.coordinate_input_file(i));
   } catch (std::exception& e) {
     fprintf(stderr, "Error: %s\n", e.what());
     return 1;
   }
+  std::atomic<int> status{0};
+  int failures = run_batch(inputs, p.integer_or(Threads, 1), [&](size_t i) {
+    if (i != 0)
+      batch_putchar('\n');
+    const std::string& input = inputs[i];
+    batch_printf("%s\n", input.c_str());
+    gemmi::Structure st = gemmi::read_structure_gz(input, format);
+    if (p.options[Match]) {
+      gemmi::Selection sel(p.options[Match].arg);
+      sel.remove_not_selected(st);
+    }
+    if (p.options[Label] || p.options[Ent]) {
+      gemmi::setup_entities(st);
+      // hidden feature: -ll generates label_seq even if SEQRES is missing
+      bool force = p.options[Label].count() > 1;
+      gemmi::assign_label_seq_id(st, force);
+    } else if (p.options[Short]) {
+      gemmi::add_entity_types(st, false);
+    }
+    if (p.options[CheckSeqId]) {
+      bool ok = check_sequence_id(st);
+      if (!ok)
+        ++status;
+      return;
+    }
+    if (p.options[Ent]) {
+      print_entity_info(st);
+      return;
+    }
+    if (p.options[Chains])
+      st.merge_chain_parts();
+    for (gemmi::Model& model : st.models) {
+      if (st.models.size() != 1)
+        batch_printf("Model %d\n", model.num);
+      if (p.options[Chains])
+        print_chain_info(model);
+      else if (p.options[Short])
+        print_short_info(model, p);
+      else
+        print_long_info(model, p);
+    }
+  });
+  if (failures != 0)
+    return 1;
   return status;
 }
@@ -7,6 +7,7 @@
 #include "gemmi/read_cif.hpp"  // for read_cif_gz, check_cif_syntax_gz
 #include "validate_mon.h"  // for check_monomer_doc
 #include <stdio.h>
+#include <atomic>
 #include <stdexcept>  // for std::runtime_error
 
 #ifdef GEMMI_ANALYZE_RULES
@@ -16,6 +17,7 @@
 
 #define GEMMI_PROG validate
 #include "options.h"
+#include "batch.h"
 
 namespace cif = gemmi::cif;
 
@@ -23,7 +25,7 @@ namespace {
 
 enum OptionIndex {
   Quiet=4, Fast, Stat, Context, Ddl, NoRegex, NoMandatory, NoUniqueKeys,
-  Parents, Depo, Recurse, Monomer, Zscore, Ccd, AuditDate
+  Parents, Depo, Recurse, Monomer, Zscore, Ccd, AuditDate, Threads
 };
 const option::Descriptor Usage[] = {
   { NoOp, 0, "", "", Arg::None, "Usage: " EXE_NAME " [options] FILE [...]"
@@ -37,6 +39,9 @@ const option::Descriptor Usage[] = {
   { Recurse, 0, "r", "recursive", Arg::None,
     "  -r, --recursive  \tRecurse directories and process all CIF files." },
   { Ddl, 0, "d", "ddl", Arg::Required, "  -d, --ddl=PATH  \tDDL for validation." },
+  { Threads, 0, "j", "threads", Arg::Int,
+    "  -j, --threads=N  \tNumber of threads: files are checked in parallel,"
+    " or loop columns if there is only one file (default: 1)." },
 
   { NoOp, 0, "", "", Arg::None, "\nOptional checks (when using DDL2):" },
   { Context, 0, "c", "context", Arg::None,
@@ -171,7 +176,7 @@ bool process_file(const char* path, const cif::Ddl& dict,
   bool ok = true;
   std::string msg;
   if (options[Verbose])
-    printf("Reading %s...\n", path);
+    batch_printf("Reading %s...\n", path);
   try {
     if (options[Fast]) {
       ok = gemmi::check_cif_syntax_gz(path, &msg);
@@ -198,7 +203,7 @@ bool process_file(const char* path, const cif::Ddl& dict,
             if (options[Ccd]) {
               auto it = ccd_map.find(cc_name);
               if (it == ccd_map.end()) {
-                printf("%s [ccd] monomer not found in CCD file(s)\n", cc_name.c_str());
+                batch_printf("%s [ccd] monomer not found in CCD file(s)\n", cc_name.c_str());
                 continue;
               }
               const cif::Block& ccd_block = it->second;
@@ -207,7 +212,7 @@ bool process_file(const char* path, const cif::Ddl& dict,
                                    .find_values("_pdbx_chem_comp_audit.date");
                 if (!column_contains(col, options[AuditDate].arg)) {
                   if (options[Verbose])
-                    printf("%s [ccd] ignored - audit date does not match\n", cc_name.c_str());
+                    batch_printf("%s [ccd] ignored - audit date does not match\n", cc_name.c_str());
                   continue;
                 }
               }
@@ -225,10 +230,10 @@ bool process_file(const char* path, const cif::Ddl& dict,
     msg = e.what();
   }
   if (!msg.empty())
-    printf("%s\n", msg.c_str());
+    batch_printf("%s\n", msg.c_str());
 
   if (options[Verbose])
-    puts(ok ? "OK" : "FAILED");
+    batch_puts(ok ? "OK" : "FAILED");
   return ok;
 }
 
@@ -243,9 +248,9 @@ int GEMMI_MAIN(int argc, char **argv) {
   p.simple_parse(argc, argv, Usage);
   p.require_input_files_as_args();
 
-  bool total_ok = true;
   cif::Ddl dict;
-  dict.logger = {&gemmi::Logger::to_stdout, 5 + p.options[Verbose].count()};
+  dict.logger = {[](const std::string& s) { batch_printf("%s\n", s.c_str()); },
+                 5 + p.options[Verbose].count()};
   dict.print_unknown_tags = !p.options[Quiet];
   dict.use_regex = !p.options[NoRegex];
   dict.use_context = p.options[Context];
@@ -277,14 +282,24 @@ int GEMMI_MAIN(int argc, char **argv) {
       return EXIT_FAILURE;
     }
   }
+  std::vector<std::string> paths;
   for (int i = 0; i < p.nonOptionsCount(); ++i) {
     const char* path = p.nonOption(i);
     if (p.options[Recurse]) {
       for (const std::string& file : gemmi::CifWalk(path))
-        total_ok = process_file(file.c_str(), dict, ccd_map, p.options) && total_ok;
+        paths.push_back(file);
     } else {
-      total_ok = process_file(path, dict, ccd_map, p.options) && total_ok;
+      paths.emplace_back(path);
     }
   }
-  return total_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  int n_threads = p.integer_or(Threads, 1);
+  // with multiple files, use threads for files, not for loop columns
+  if (paths.size() == 1)
+    dict.n_threads = n_threads;
+  std::atomic<bool> total_ok{true};
+  int failures = run_batch(paths, n_threads, [&](size_t i) {
+    if (!process_file(paths[i].c_str(), dict, ccd_map, p.options))
+      total_ok = false;
+  });
+  return total_ok && failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
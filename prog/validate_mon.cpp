@@ -4,6 +4,7 @@
 // the Refmac monomer dictionary ("gemmi validate --monomer").
 
 #include "validate_mon.h"
+#include "batch.h"                // for batch_printf
 #include <stdio.h>
 #include "gemmi/chemcomp.hpp"     // for ChemComp
 #include "gemmi/mmcif.hpp"        // for make_residue_from_chemcomp_block
@@ -34,8 +35,8 @@ void check_valency(const ChemComp& cc) {
       ok = (valency == 3.0f || valency == 5.0f || valency == 5.5f);
     }
     if (!ok)
-      printf("%s [valency] %s (%s) has bond order %g\n", cc.name.c_str(),
-             atom.id.c_str(), element_name(atom.el), valency);
+      batch_printf("%s [valency] %s (%s) has bond order %g\n", cc.name.c_str(),
+                   atom.id.c_str(), element_name(atom.el), valency);
   }
 }
 
@@ -44,18 +45,18 @@ void check_bond_angle_consistency(const ChemComp& cc) {
   for (const Restraints::Angle& angle : cc.rt.angles) {
     if (!cc.rt.are_bonded(angle.id1, angle.id2) ||
         !cc.rt.are_bonded(angle.id2, angle.id3))
-      printf("%s angle %s with non-bonded atoms\n", tag.c_str(),
-             angle.str().c_str());
+      batch_printf("%s angle %s with non-bonded atoms\n", tag.c_str(),
+                   angle.str().c_str());
     if (angle.value < 20)
-      printf("%s angle %s with low value: %g\n", tag.c_str(),
-             angle.str().c_str(), angle.value);
+      batch_printf("%s angle %s with low value: %g\n", tag.c_str(),
+                   angle.str().c_str(), angle.value);
   }
   for (const Restraints::Torsion& tor : cc.rt.torsions) {
     if (!cc.rt.are_bonded(tor.id1, tor.id2) ||
         !cc.rt.are_bonded(tor.id2, tor.id3) ||
         !cc.rt.are_bonded(tor.id3, tor.id4))
-      printf("%s torsion %s with non-bonded atoms\n", tag.c_str(),
-             tor.str().c_str());
+      batch_printf("%s torsion %s with non-bonded atoms\n", tag.c_str(),
+                   tor.str().c_str());
   }
 }
 
@@ -64,8 +65,8 @@ void check_repeated_atoms_in_restraints(const ChemComp& cc) {
     for (auto s1 = strings.begin(); s1 != strings.end(); ++s1)
       for (auto s2 = s1 + 1; s2 != strings.end(); ++s2)
         if (*s1 == *s2)
-          printf("%s [restr-dup] duplicated atom %s in %s\n",
-                 cc.name.c_str(), s1->c_str(), gemmi::join_str(strings, '-').c_str());
+          batch_printf("%s [restr-dup] duplicated atom %s in %s\n",
+                       cc.name.c_str(), s1->c_str(), gemmi::join_str(strings, '-').c_str());
   };
   for (const Restraints::Bond& bond : cc.rt.bonds)
     ensure_unique({bond.id1.atom, bond.id2.atom});
@@ -79,16 +80,16 @@ void check_repeated_atoms_in_restraints(const ChemComp& cc) {
     for (auto a1 = t.ids.begin(); a1 != t.ids.end(); ++a1)
       for (auto a2 = a1 + 1; a2 != t.ids.end(); ++a2)
         if (a1->atom == a2->atom)
-          printf("%s [restr-dup] duplicated atom %s in plane %s\n",
-                 cc.name.c_str(), a1->atom.c_str(), t.label.c_str());
+          batch_printf("%s [restr-dup] duplicated atom %s in plane %s\n",
+                       cc.name.c_str(), a1->atom.c_str(), t.label.c_str());
     }
 }
 
 template <typename T>
 bool check_esd(const std::string& name, const T* restr) {
   if (restr->esd <= 0. && !(restr->esd == 0 && std::is_same<T, Restraints::Torsion>::value)) {
-    printf("%s [esd] %s %s has non-positive esd: %g\n", name.c_str(),
-           restr->what(), restr->str().c_str(), restr->esd);
+    batch_printf("%s [esd] %s %s has non-positive esd: %g\n", name.c_str(),
+                 restr->what(), restr->str().c_str(), restr->esd);
     return false;
   }
   return true;
@@ -100,16 +101,16 @@ void print_outliers(const Topo& topo, const std::string& name, double z_score) {
       continue;
     double value = t.calculate();
     if (std::abs(value - t.restr->value) > z_score * t.restr->esd)
-      printf("%s [atom.xyz] bond %s should be %g (esd %g) but is %.2f\n", name.c_str(),
-             t.restr->str().c_str(), t.restr->value, t.restr->esd, value);
+      batch_printf("%s [atom.xyz] bond %s should be %g (esd %g) but is %.2f\n", name.c_str(),
+                   t.restr->str().c_str(), t.restr->value, t.restr->esd, value);
   }
   for (const Topo::Angle& t : topo.angles) {
     if (!check_esd(name, t.restr))
       continue;
     double value = gemmi::deg(t.calculate());
     if (gemmi::angle_abs_diff(value, t.restr->value) > z_score * t.restr->esd)
-      printf("%s [atom.xyz] angle %s should be %g (esd %g) but is %.2f\n", name.c_str(),
-             t.restr->str().c_str(), t.restr->value, t.restr->esd, value);
+      batch_printf("%s [atom.xyz] angle %s should be %g (esd %g) but is %.2f\n", name.c_str(),
+                   t.restr->str().c_str(), t.restr->value, t.restr->esd, value);
   }
   for (const Topo::Torsion& t : topo.torsions) {
     if (!check_esd(name, t.restr))
@@ -117,16 +118,16 @@ void print_outliers(const Topo& topo, const std::string& name, double z_score) {
     double value = gemmi::deg(t.calculate());
     double full = 360. / std::max(1, t.restr->period);
     if (gemmi::angle_abs_diff(value, t.restr->value, full) > z_score * t.restr->esd)
-      printf("%s [atom.xyz] torsion %s should be %g (period %d, esd %g) but is %.2f\n",
-             name.c_str(),
-             t.restr->str().c_str(), t.restr->value, t.restr->period, t.restr->esd, value);
+      batch_printf("%s [atom.xyz] torsion %s should be %g (period %d, esd %g) but is %.2f\n",
+                   name.c_str(),
+                   t.restr->str().c_str(), t.restr->value, t.restr->period, t.restr->esd, value);
   }
   for (const Topo::Chirality& t : topo.chirs) {
     double value = t.calculate();
     if (t.restr->is_wrong(value))
-      printf("%s [atom.xyz] chir %s should be %s but is %.2f\n", name.c_str(),
-             t.restr->str().c_str(), gemmi::chirality_to_string(t.restr->sign),
-             value);
+      batch_printf("%s [atom.xyz] chir %s should be %s but is %.2f\n", name.c_str(),
+                   t.restr->str().c_str(), gemmi::chirality_to_string(t.restr->sign),
+                   value);
   }
   for (const Topo::Plane& t : topo.planes) {
     if (!check_esd(name, t.restr))
@@ -135,8 +136,8 @@ void print_outliers(const Topo& topo, const std::string& name, double z_score) {
     for (const gemmi::Atom* atom : t.atoms) {
       double dist = gemmi::get_distance_from_plane(atom->pos, coeff);
       if (dist > z_score * t.restr->esd)
-        printf("%s [atom.xyz] plane %s has atom %s in a distance %.2f\n", name.c_str(),
-               t.restr->str().c_str(), atom->name.c_str(), dist);
+        batch_printf("%s [atom.xyz] plane %s has atom %s in a distance %.2f\n", name.c_str(),
+                     t.restr->str().c_str(), atom->name.c_str(), dist);
     }
   }
 }
@@ -182,13 +183,13 @@ SortedAtoms sorted_heavy_atoms(const ChemComp& cc) {
     if (process_h(bond.id2.atom, bond.id1.atom) ||
         process_h(bond.id1.atom, bond.id2.atom)) {
       if (bond.type != gemmi::BondType::Single)
-        printf("%s [ccd] bond %s (hydrogen atom) is not SINGle\n",
-               cc.name.c_str(), bond.str().c_str());
+        batch_printf("%s [ccd] bond %s (hydrogen atom) is not SINGle\n",
+                     cc.name.c_str(), bond.str().c_str());
     } else {
       auto result = sa.bond_map.emplace(bond.lexicographic_str(), &bond);
       if (!result.second)
-        printf("%s [ccd:bond]   duplicated bond %s\n", cc.name.c_str(),
-               result.first->first.c_str());
+        batch_printf("%s [ccd:bond]   duplicated bond %s\n", cc.name.c_str(),
+                     result.first->first.c_str());
     }
   }
   for (const auto& h : hydrogen_names)
@@ -231,10 +232,10 @@ void check_consistency_with_ccd(const ChemComp& lib, const cif::Block& ccd_block
         const HeavyAtom& ccd_heavy = ccd_sa.heavys[i];
         const char* atom_id = lib_heavy.atom->id.c_str();
         if (lib_heavy.atom->el != ccd_heavy.atom->el)
-          printf("%s [ccd] different element for %s\n", name, atom_id);
+          batch_printf("%s [ccd] different element for %s\n", name, atom_id);
         if (lib_heavy.hydrogens.size() != ccd_heavy.hydrogens.size())
-          printf("%s [ccd] different protonation of %s, #H=%zu (%zu in CCD)\n",
-                 name, atom_id, lib_heavy.hydrogens.size(), ccd_heavy.hydrogens.size());
+          batch_printf("%s [ccd] different protonation of %s, #H=%zu (%zu in CCD)\n",
+                       name, atom_id, lib_heavy.hydrogens.size(), ccd_heavy.hydrogens.size());
         const auto* shorter = &lib_heavy.hydrogens;
         const auto* longer = &ccd_heavy.hydrogens;
         bool ccd_less = (longer->size() < shorter->size());
@@ -245,39 +246,39 @@ void check_consistency_with_ccd(const ChemComp& lib, const cif::Block& ccd_block
             for (const std::string& h : lib_heavy.hydrogens)
               for (const HeavyAtom& heavy : ccd_sa.heavys) {
                 if (&heavy != &ccd_heavy && gemmi::in_vector(h, heavy.hydrogens))
-                  printf("%s [ccd] wrong parent for hydrogen %s: %s (%s in CCD)\n",
-                         name, h.c_str(), atom_id, heavy.atom->id.c_str());
+                  batch_printf("%s [ccd] wrong parent for hydrogen %s: %s (%s in CCD)\n",
+                               name, h.c_str(), atom_id, heavy.atom->id.c_str());
               }
         } else {
-          printf("%s [ccd] different names of hydrogens on %s: %s  vs  %s\n",
-                 name, atom_id,
-                 gemmi::join_str(lib_heavy.hydrogens, ' ').c_str(),
-                 gemmi::join_str(ccd_heavy.hydrogens, ' ').c_str());
+          batch_printf("%s [ccd] different names of hydrogens on %s: %s  vs  %s\n",
+                       name, atom_id,
+                       gemmi::join_str(lib_heavy.hydrogens, ' ').c_str(),
+                       gemmi::join_str(ccd_heavy.hydrogens, ' ').c_str());
         }
       } else {
-        printf("%s [ccd] different names of heavy atoms\n", name);
+        batch_printf("%s [ccd] different names of heavy atoms\n", name);
         same_atoms = false;
         break;
       }
     }
   } else {
-    printf("%s [ccd] different number of heavy atoms: %zu (%zu in CCD)\n", name,
-           lib_sa.heavys.size(), ccd_sa.heavys.size());
+    batch_printf("%s [ccd] different number of heavy atoms: %zu (%zu in CCD)\n", name,
+                 lib_sa.heavys.size(), ccd_sa.heavys.size());
     same_atoms = false;
   }
   if (!same_atoms && verbose) {
     auto getter = [](const HeavyAtom& a) { return a.atom->id; };
-    printf("%s [ccd]   %s\n", name, gemmi::join_str(lib_sa.heavys, ' ', getter).c_str());
-    printf("%s [ccd]   %s\n", name, gemmi::join_str(ccd_sa.heavys, ' ', getter).c_str());
+    batch_printf("%s [ccd]   %s\n", name, gemmi::join_str(lib_sa.heavys, ' ', getter).c_str());
+    batch_printf("%s [ccd]   %s\n", name, gemmi::join_str(ccd_sa.heavys, ' ', getter).c_str());
     cif::Table audit = const_cast<cif::Block&>(ccd_block)
                          .find("_pdbx_chem_comp_audit.", {"action_type", "date"});
     int audit_len = audit.length();
     if (audit_len > 0) {
       cif::Table::Row last_row = audit[audit_len-1];
-      printf("%s [ccd]   Last modification: %s  %s\n", name,
-             last_row[1].c_str(), last_row.str(0).c_str());
+      batch_printf("%s [ccd]   Last modification: %s  %s\n", name,
+                   last_row[1].c_str(), last_row.str(0).c_str());
     } else {
-      printf("%s [ccd]   missing _pdbx_chem_comp_audit in CCD\n", name);
+      batch_printf("%s [ccd]   missing _pdbx_chem_comp_audit in CCD\n", name);
     }
   }
 
@@ -286,18 +287,18 @@ void check_consistency_with_ccd(const ChemComp& lib, const cif::Block& ccd_block
     const std::string& bond_str = lib_bond.first;
     auto ccd_iter = ccd_sa.bond_map.find(bond_str);
     if (ccd_iter == ccd_sa.bond_map.end()) {
-      printf("%s [ccd:bond]   extra bond %s\n", name, bond_str.c_str());
+      batch_printf("%s [ccd:bond]   extra bond %s\n", name, bond_str.c_str());
       continue;
     }
     if (lib_bond.second->type != ccd_iter->second->type && verbose)
-      printf("%s [ccd:bond]   %s bond type is: %s (%s in CCD)\n", name,
-             bond_str.c_str(),
-             gemmi::bond_type_to_string(lib_bond.second->type),
-             gemmi::bond_type_to_string(ccd_iter->second->type));
+      batch_printf("%s [ccd:bond]   %s bond type is: %s (%s in CCD)\n", name,
+                   bond_str.c_str(),
+                   gemmi::bond_type_to_string(lib_bond.second->type),
+                   gemmi::bond_type_to_string(ccd_iter->second->type));
     ccd_sa.bond_map.erase(ccd_iter);
   }
   for (const auto& ccd_iter : ccd_sa.bond_map)
-    printf("%s [ccd:bond]   missing bond %s\n", name, ccd_iter.first.c_str());
+    batch_printf("%s [ccd:bond]   missing bond %s\n", name, ccd_iter.first.c_str());
 }
 
 }  // anonymous namespace
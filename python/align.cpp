@@ -4,6 +4,7 @@
 #include "gemmi/seqalign.hpp"  // for align_string_sequences
 
 #include "common.h"
+#include "array.h"
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 
@@ -42,7 +43,7 @@ void add_alignment(nb::module_& m) {
 
   m.def("align_string_sequences", &align_string_sequences,
         nb::arg("query"), nb::arg("target"), nb::arg("target_gapo"),
-        nb::arg("scoring")=nb::none());
+        nb::arg("scoring")=nb::none(), nb::arg("band_width")=-1);
   m.def("align_sequence_to_polymer",
         [](const std::vector<std::string>& full_seq, const ResidueSpan& polymer,
            PolymerType polymer_type, AlignmentScoring* scoring) {
@@ -94,6 +95,37 @@ void add_alignment(nb::module_& m) {
           return superpose_positions(pos1.data(), pos2.data(), pos1.size(),
                                      weight.empty() ? nullptr : weight.data());
         }, nb::arg("pos1"), nb::arg("pos2"), nb::arg("weight")=std::vector<int>{});
+
+  nb::class_<QcpEnsemble>(m, "QcpEnsemble")
+    .def("__init__", [](QcpEnsemble* ens, size_t point_count, const std::vector<double>& weight) {
+        if (!weight.empty() && weight.size() != point_count)
+          fail("QcpEnsemble: weights must be empty or of length point_count");
+        new(ens) QcpEnsemble(point_count, weight.empty() ? nullptr : weight.data());
+    }, nb::arg("point_count"), nb::arg("weight")=std::vector<double>{})
+    .def_ro("point_count", &QcpEnsemble::point_count)
+    .def("add", [](QcpEnsemble& self, const std::vector<Position>& pos) {
+        if (pos.size() != self.point_count)
+          fail("QcpEnsemble.add: expected ", self.point_count, " positions");
+        self.add(pos.data());
+    }, nb::arg("pos"))
+    .def("add_array", [](QcpEnsemble& self,
+            const nb::ndarray<const double, nb::shape<-1,-1,3>, nb::c_contig, nb::device::cpu>& xyz) {
+        if (xyz.shape(1) != self.point_count)
+          fail("QcpEnsemble.add_array: expected array of shape (n, ", self.point_count, ", 3)");
+        // Position has the same memory layout as 3 doubles
+        const Position* pos = reinterpret_cast<const Position*>(xyz.data());
+        self.reserve(self.size() + xyz.shape(0));
+        for (size_t i = 0; i < xyz.shape(0); ++i)
+          self.add(pos + i * self.point_count);
+    }, nb::arg("xyz"))
+    .def("__len__", &QcpEnsemble::size)
+    .def("rmsd_to_reference", [](const QcpEnsemble& self, size_t ref, int threads) {
+        return numpy_array_from_vector(qcp_rmsd_to_reference(self, ref, threads));
+    }, nb::arg("ref"), nb::arg("threads")=1)
+    .def("rmsd_matrix", [](const QcpEnsemble& self, int threads) {
+        return numpy_array_from_vector(qcp_rmsd_matrix(self, threads));
+    }, nb::arg("threads")=1)
+    ;
 }
 
 void add_assign_label_seq_id(nb::class_<Structure>& structure) {
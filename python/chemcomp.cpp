@@ -2,6 +2,7 @@
 
 #include "gemmi/chemcomp.hpp"    // for ChemComp
 #include "gemmi/to_chemcomp.hpp" // for add_chemcomp_to_block
+#include "gemmi/ccd.hpp"         // for IndexedCcd
 
 #include "common.h"
 #include <nanobind/stl/bind_vector.h>
@@ -193,4 +194,31 @@ void add_chemcomp(nb::module_& m) {
     ;
   m.def("make_chemcomp_from_block", &make_chemcomp_from_block);
   m.def("add_chemcomp_to_block", &add_chemcomp_to_block);
+
+  nb::class_<IndexedCcd>(m, "IndexedCcd")
+    .def(nb::init<const std::string&, const std::string&, const Logger&>(),
+         nb::arg("path"), nb::arg("index_path")=std::string(),
+         nb::arg("logging")=nb::none())
+    .def_prop_ro("path", &IndexedCcd::path)
+    .def_prop_ro("names", &IndexedCcd::names)
+    .def_rw("cache_capacity", &IndexedCcd::cache_capacity)
+    .def("cache_size", &IndexedCcd::cache_size)
+    .def("clear_cache", &IndexedCcd::clear_cache)
+    .def("read_block", &IndexedCcd::read_block, nb::arg("name"))
+    // returns a copy, to avoid keeping references to the cache
+    .def("find", [](IndexedCcd& self, const std::string& name) -> nb::object {
+        if (std::shared_ptr<const ChemComp> cc = self.find(name))
+          return nb::cast(*cc);
+        return nb::none();
+    }, nb::arg("name"))
+    .def("__getitem__", [](IndexedCcd& self, const std::string& name) {
+        if (!self.has(name))
+          throw nb::key_error(name.c_str());
+        return ChemComp(*self.get(name));
+    }, nb::arg("name"))
+    .def("__contains__", &IndexedCcd::has)
+    .def("__len__", &IndexedCcd::size)
+    .def("__repr__", [](const IndexedCcd& self) {
+        return cat("<gemmi.IndexedCcd ", self.path(), " with ", self.size(), " blocks>");
+    });
 }
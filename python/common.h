@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <memory>  // for shared_ptr
+
 #if defined(__clang__)
   #pragma clang diagnostic push
 #elif defined(__GNUC__)
@@ -23,6 +25,8 @@
 
 namespace nb = nanobind;
 constexpr auto rv_ri = nb::rv_policy::reference_internal;
+// for long-running functions that don't touch Python objects
+using release_gil = nb::call_guard<nb::gil_scoped_release>;
 
 void add_elem(nb::module_& m); // elem.cpp
 void add_xds(nb::module_& m); // elem.cpp
@@ -115,6 +119,16 @@ inline nb::object handle_numpy_array_args(const nb::object& o, nb::handle dtype,
   return o.attr("astype")(dtype);
 }
 
+// Python object that can be copied, used and destroyed by C++ code
+// running without the GIL (functions with nb::gil_scoped_release).
+// Used in Logger callbacks.
+inline std::shared_ptr<nb::object> make_gil_safe_object(nb::handle h) {
+  return std::shared_ptr<nb::object>(new nb::object(nb::borrow(h)), [](nb::object* p) {
+    nb::gil_scoped_acquire acquire;
+    delete p;
+  });
+}
+
 namespace nanobind { namespace detail {
 template <> struct type_caster<gemmi::Logger> {
   NB_TYPE_CASTER(gemmi::Logger, const_name("object"))
@@ -129,12 +143,16 @@ template <> struct type_caster<gemmi::Logger> {
     if (src.is_none()) {
       // nothing
     } else if (nb::hasattr(src, "write") && nb::hasattr(src, "flush")) {
-      value.callback = {[obj=nb::borrow(src)](const std::string& s) {
-        obj.attr("write")(s + "\n");
-        obj.attr("flush")();
+      value.callback = {[obj=make_gil_safe_object(src)](const std::string& s) {
+        nb::gil_scoped_acquire acquire;
+        obj->attr("write")(s + "\n");
+        obj->attr("flush")();
       }};
     } else if (PyCallable_Check(src.ptr())) {
-      value.callback = {[obj=nb::borrow(src)](const std::string& s) { obj(s); }};
+      value.callback = {[obj=make_gil_safe_object(src)](const std::string& s) {
+        nb::gil_scoped_acquire acquire;
+        (*obj)(s);
+      }};
     } else {
       return false;
     }
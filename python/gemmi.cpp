@@ -8,6 +8,7 @@
 #include "gemmi/pirfasta.hpp"  // for read_pir_or_fasta
 #include "gemmi/seqtools.hpp"  // for calculate_sequence_weight
 #include "gemmi/stats.hpp"     // for Correlation
+#include "gemmi/profile.hpp"   // for Profiler
 #include "gemmi/third_party/tao/pegtl/parse_error.hpp" // for parse_error
 
 #include "common.h"
@@ -88,6 +89,20 @@ void add_misc(nb::module_& m) {
     .def("mean_ratio", &gemmi::Correlation::mean_ratio)
     ;
 
+  // profile.hpp
+  m.def("profiling_compiled_in", &gemmi::Profiler::compiled_in);
+  m.def("enable_profiling", [](bool on) {
+      gemmi::Profiler& profiler = gemmi::Profiler::instance();
+      if (on && !profiler.enabled())
+        profiler.clear();
+      profiler.enable(on);
+  }, nb::arg("on")=true);
+  m.def("profile_summary", []() { return gemmi::Profiler::instance().summary_json(); });
+  m.def("profile_trace", []() { return gemmi::Profiler::instance().chrome_trace_json(); });
+  m.def("write_profile", [](const std::string& path, bool trace) {
+      gemmi::Profiler::instance().write_file(path, trace);
+  }, nb::arg("path"), nb::arg("trace")=false);
+
   // utilities inspired by numpy.bincount()
   m.def("binmean", [](const cpu_array<int>& bins, const cpu_array<double>& values) {
       auto bins_ = bins.view();
@@ -21,6 +21,7 @@ bool operator>(const std::complex<float>& a, const std::complex<float>& b) {
 
 #include "gemmi/grid.hpp"
 #include "gemmi/floodfill.hpp"  // for flood_fill_above
+#include "gemmi/edt.hpp"        // for distance_transform
 #include "gemmi/solmask.hpp"  // for SolventMasker, mask_points_in_constant_radius
 #include "gemmi/blob.hpp"     // for Blob, find_blobs_by_flood_fill
 #include "gemmi/asumask.hpp"  // for MaskedGrid
@@ -180,18 +181,14 @@ void add_grid_interpolation(nb::class_<Grid<T>, GridBase<T>>& grid) {
          (std::array<double,4> (Gr::*)(const Fractional&) const)
          &Gr::tricubic_interpolation_der)
     .def("interpolate_position_array",
-         [](const Gr& self, const nb::ndarray<double, nb::shape<-1,3>, nb::device::cpu>& xyz,
+         [](const Gr& self,
+            const nb::ndarray<const double, nb::shape<-1,3>, nb::c_contig, nb::device::cpu>& xyz,
             int order, const Transform* to_frac) {
-        auto xyz_view = xyz.view();
-        size_t len = xyz_view.shape(0);
+        size_t len = xyz.shape(0);
         auto values = make_numpy_array<T>({len});
-        T* data = values.data();
-        const Transform& frac = to_frac ? *to_frac : self.unit_cell.frac;
-        for (size_t i = 0; i < len; ++i) {
-          Position pos(xyz_view(i, 0), xyz_view(i, 1), xyz_view(i, 2));
-          Fractional fpos = Fractional(frac.apply(pos));
-          data[i] = self.interpolate_value(fpos, order);
-        }
+        // Vec3 has the same memory layout as 3 doubles (cf. superpose_positions)
+        const Vec3* points = reinterpret_cast<const Vec3*>(xyz.data());
+        self.interpolate_position_array(points, len, values.data(), order, to_frac);
         return values;
     }, nb::arg("xyz"), nb::arg("order")=1, nb::arg("to_frac")=nb::none())
     // The name of this function is not very descriptive, but since it's used
@@ -264,6 +261,19 @@ void add_grid_interpolation(nb::class_<Grid<T>, GridBase<T>>& grid) {
     ;
 }
 
+template<typename T>
+void add_distance_transform(nb::class_<Grid<T>, GridBase<T>>& grid) {
+  grid.def("distance_transform",
+           [](const Grid<T>& self, T threshold, double max_dist, int threads) {
+             return distance_transform(self, [&](T x) { return x >= threshold; },
+                                       max_dist, threads);
+           }, nb::arg("threshold"), nb::arg("max_dist")=INFINITY,
+           nb::arg("threads")=1,
+           "Distance (A) to the nearest point with value >= threshold.\n"
+           "For non-orthogonal cells, the cost grows as max_dist^3 times\n"
+           "the number of boundary points - set max_dist if possible.");
+}
+
 }  // anonymous namespace
 
 void add_grid(nb::module_& m) {
@@ -293,7 +303,8 @@ void add_grid(nb::module_& m) {
 
   add_grid_base<int8_t>(m, "Int8GridBase")
     .def("get_nonzero_extent", &get_nonzero_extent<int8_t>);
-  add_grid_common<int8_t>(m, "Int8Grid");
+  auto grid_int8 = add_grid_common<int8_t>(m, "Int8Grid");
+  add_distance_transform<int8_t>(grid_int8);
 
   add_grid_base<float>(m, "FloatGridBase")
     .def("calculate_correlation", &calculate_correlation<float>)
@@ -301,6 +312,7 @@ void add_grid(nb::module_& m) {
     ;
   auto grid_float = add_grid_common<float>(m, "FloatGrid");
   add_grid_interpolation<float>(grid_float);
+  add_distance_transform<float>(grid_float);
   grid_float.def("symmetrize_avg", &Grid<float>::symmetrize_avg);
   grid_float.def("normalize", &Grid<float>::normalize);
   grid_float.def("add_soft_edge_to_mask", &add_soft_edge_to_mask<float>);
@@ -323,14 +335,16 @@ void add_grid(nb::module_& m) {
     .def_rw("constant_r", &SolventMasker::constant_r)
     .def_rw("ignore_hydrogen", &SolventMasker::ignore_hydrogen)
     .def_rw("ignore_zero_occupancy_atoms", &SolventMasker::ignore_zero_occupancy_atoms)
+    .def_rw("n_threads", &SolventMasker::n_threads)
     .def("set_radii", &SolventMasker::set_radii,
          nb::arg("choice"), nb::arg("constant_r")=0.)
-    .def("put_mask_on_int8_grid", &SolventMasker::put_mask_on_grid<int8_t>)
-    .def("put_mask_on_float_grid", &SolventMasker::put_mask_on_grid<float>)
+    .def("put_mask_on_int8_grid", &SolventMasker::put_mask_on_grid<int8_t>, release_gil())
+    .def("put_mask_on_float_grid", &SolventMasker::put_mask_on_grid<float>, release_gil())
     .def("set_to_zero", &SolventMasker::set_to_zero)
     ;
   m.def("interpolate_grid", &interpolate_grid<float>,
-        nb::arg("dest"), nb::arg("src"), nb::arg("tr"), nb::arg("order")=1);
+        nb::arg("dest"), nb::arg("src"), nb::arg("tr"), nb::arg("order")=1,
+        nb::arg("threads")=1, release_gil());
   m.def("interpolate_grid_around_model", &interpolate_grid_around_model<float>,
         nb::arg("dest"), nb::arg("src"), nb::arg("tr"),
         nb::arg("dest_model"), nb::arg("radius"), nb::arg("order")=1);
@@ -346,15 +360,16 @@ void add_grid(nb::module_& m) {
     ;
   m.def("find_blobs_by_flood_fill",
         [](const Grid<float>& grid, double cutoff, double min_volume,
-           double min_score, double min_peak, bool negate) {
+           double min_score, double min_peak, bool negate, int threads) {
        BlobCriteria crit;
        crit.cutoff = cutoff;
        crit.min_volume = min_volume;
        crit.min_score = min_score;
        crit.min_peak = min_peak;
-       return find_blobs_by_flood_fill(grid, crit, negate);
+       return find_blobs_by_flood_fill(grid, crit, negate, threads);
     }, nb::arg("grid"), nb::arg("cutoff"), nb::arg("min_volume")=10.,
-       nb::arg("min_score")=15., nb::arg("min_peak")=0., nb::arg("negate")=false);
+       nb::arg("min_score")=15., nb::arg("min_peak")=0., nb::arg("negate")=false,
+       nb::arg("threads")=1);
 
   // from floodfill.hpp
   m.def("flood_fill_above", &flood_fill_above,
@@ -181,9 +181,10 @@ void add_hkl(nb::module_& m) {
   m.def("hkl_cif_as_refln_block", &hkl_cif_as_refln_block, nb::arg("block"));
   m.def("transform_f_phi_grid_to_map", [](FPhiGrid<float> grid) {
           return transform_f_phi_grid_to_map<float>(std::move(grid));
-        }, nb::arg("grid"));
+        }, nb::arg("grid"), release_gil());
   m.def("transform_map_to_f_phi", &transform_map_to_f_phi<float>,
-        nb::arg("map"), nb::arg("half_l")=false, nb::arg("use_scale")=true);
+        nb::arg("map"), nb::arg("half_l")=false, nb::arg("use_scale")=true,
+        release_gil());
   m.def("cromer_liberman", [](int z, double energy) {
       std::pair<double, double> r;
       r.first = cromer_liberman(z, energy, &r.second);
@@ -5,12 +5,16 @@
 #include "gemmi/modify.hpp"     // for remove_alternative_conformations
 #include "gemmi/polyheur.hpp"   // for one_letter_code, trim_to_alanine
 #include "gemmi/assembly.hpp"   // for expand_ncs, HowToNameCopiedChain
+#include "gemmi/atomarr.hpp"    // for copy_atoms_to_arrays
+#include "gemmi/neighbor.hpp"   // for make_neighbor_search
 #include "gemmi/select.hpp"     // for Selection
 #include "gemmi/sprintf.hpp"    // for snprintf_z
 
 #include "common.h"
 #include "serial.h"  // for getstate, setstate
+#include "array.h"   // for make_numpy_array
 #include "make_iterator.h"
+#include <nanobind/operators.h>
 #include <nanobind/stl/bind_map.h>
 #include <nanobind/stl/array.h>  // for calculate_phi_psi, find_best_plane, ...
 #include <nanobind/stl/map.h>
@@ -69,6 +73,26 @@ template<typename P> void remove_children(P& parent, const nb::slice& slice) {
   delitem_slice(parent.children(), slice);
 }
 
+// NumPy array with one property of all atoms (width values per atom)
+template<typename T>
+nb::ndarray<nb::numpy, T> get_atom_array(const Model& model, T* AtomArrays::*field,
+                                         size_t width) {
+  size_t n = count_atom_sites(model);
+  auto arr = width == 1 ? make_numpy_array<T>({n}) : make_numpy_array<T>({n, width});
+  AtomArrays out;
+  out.*field = arr.data();
+  copy_atoms_to_arrays(model, out);
+  return arr;
+}
+
+// copy_arrays_to_atoms() only reads from the arrays
+template<typename T>
+void set_atom_array(Model& model, T* AtomArrays::*field, const T* data, size_t n) {
+  AtomArrays in;
+  in.*field = const_cast<T*>(data);
+  copy_arrays_to_atoms(in, n, model);
+}
+
 }  // anonymous namespace
 
 void add_mol(nb::module_& m) {
@@ -97,7 +121,8 @@ void add_mol(nb::module_& m) {
     .value("Pdb", CoorFormat::Pdb)
     .value("Mmcif", CoorFormat::Mmcif)
     .value("Mmjson", CoorFormat::Mmjson)
-    .value("ChemComp", CoorFormat::ChemComp);
+    .value("ChemComp", CoorFormat::ChemComp)
+    .value("Binary", CoorFormat::Binary);
 
   nb::bind_map<info_map_type, rv_ri>(m, "InfoMap");
 
@@ -282,6 +307,51 @@ void add_mol(nb::module_& m) {
     })
     .def("calculate_b_iso_range", &calculate_b_iso_range<Model>)
     .def("calculate_b_aniso_range", &calculate_b_aniso_range)
+    // columnar access to atoms, in the order of iteration over the model
+    .def("get_positions", [](const Model& self) {
+        return get_atom_array(self, &AtomArrays::pos, 3);
+    })
+    .def("get_b_isos", [](const Model& self) {
+        return get_atom_array(self, &AtomArrays::b_iso, 1);
+    })
+    .def("get_occupancies", [](const Model& self) {
+        return get_atom_array(self, &AtomArrays::occ, 1);
+    })
+    .def("get_atomic_numbers", [](const Model& self) {
+        return get_atom_array(self, &AtomArrays::element, 1);
+    })
+    .def("get_atom_arrays", [](const Model& self) {
+        size_t n = count_atom_sites(self);
+        auto pos = make_numpy_array<double>({n, 3});
+        auto b_iso = make_numpy_array<float>({n});
+        auto occ = make_numpy_array<float>({n});
+        auto element = make_numpy_array<uint8_t>({n});
+        AtomArrays out;
+        out.pos = pos.data();
+        out.b_iso = b_iso.data();
+        out.occ = occ.data();
+        out.element = element.data();
+        copy_atoms_to_arrays(self, out);
+        nb::dict d;
+        d["pos"] = pos;
+        d["b_iso"] = b_iso;
+        d["occ"] = occ;
+        d["element"] = element;
+        return d;
+    })
+    .def("set_positions",
+         [](Model& self,
+            const nb::ndarray<const double, nb::shape<-1,3>, nb::c_contig, nb::device::cpu>& arr) {
+        set_atom_array(self, &AtomArrays::pos, arr.data(), arr.shape(0));
+    }, nb::arg("positions"))
+    .def("set_b_isos",
+         [](Model& self, const nb::ndarray<const float, nb::shape<-1>, nb::c_contig, nb::device::cpu>& arr) {
+        set_atom_array(self, &AtomArrays::b_iso, arr.data(), arr.shape(0));
+    }, nb::arg("b_isos"))
+    .def("set_occupancies",
+         [](Model& self, const nb::ndarray<const float, nb::shape<-1>, nb::c_contig, nb::device::cpu>& arr) {
+        set_atom_array(self, &AtomArrays::occ, arr.data(), arr.shape(0));
+    }, nb::arg("occupancies"))
     .def("transform_pos_and_adp", transform_pos_and_adp<Model>, nb::arg("tr"))
     .def("split_chains_by_segments", &split_chains_by_segments)
     .def("clone", [](const Model& self) { return new Model(self); })
@@ -570,10 +640,39 @@ void add_mol(nb::module_& m) {
   m.def("calculate_u_from_tls", &calculate_u_from_tls);
   m.def("make_assembly", &make_assembly,
         nb::arg("assembly"), nb::arg("model"), nb::arg("how"), nb::arg("logging")=nb::none());
+  nb::class_<InstancedAssembly> instanced_assembly(m, "InstancedAssembly");
+  nb::class_<InstancedAssembly::Instance>(instanced_assembly, "Instance")
+    .def_ro("oper_name", &InstancedAssembly::Instance::oper_name)
+    .def_ro("transform", &InstancedAssembly::Instance::transform)
+    ;
+  nb::class_<InstancedAssembly::ChainCopy>(instanced_assembly, "ChainCopy")
+    .def_ro("instance_idx", &InstancedAssembly::ChainCopy::instance_idx)
+    .def_ro("chain_idx", &InstancedAssembly::ChainCopy::chain_idx)
+    .def_ro("name", &InstancedAssembly::ChainCopy::name)
+    .def_ro("residues", &InstancedAssembly::ChainCopy::residues)
+    ;
+  instanced_assembly
+    .def_ro("instances", &InstancedAssembly::instances)
+    .def_ro("chains", &InstancedAssembly::chains)
+    .def("atom_count", &InstancedAssembly::atom_count)
+    .def("get_positions", &InstancedAssembly::get_positions, nb::arg("threads")=1)
+    .def("to_model", &InstancedAssembly::to_model, nb::arg("threads")=1)
+    .def("make_chain", &InstancedAssembly::make_chain)
+    .def("make_neighbor_search", [](const InstancedAssembly& self, double radius,
+                                    bool include_h) {
+        return make_neighbor_search(self, radius, include_h);
+    }, nb::arg("radius"), nb::arg("include_h")=true, nb::keep_alive<0, 1>())
+    .def("__repr__", [](const InstancedAssembly& self) {
+        return cat("<gemmi.InstancedAssembly with ", self.instances.size(),
+                   " operators, ", self.chains.size(), " chain copies>");
+    });
+  m.def("make_instanced_assembly", &make_instanced_assembly,
+        nb::arg("assembly"), nb::arg("model"), nb::arg("how"),
+        nb::arg("logging")=nb::none(), nb::keep_alive<0, 2>());
   m.def("expand_ncs_model", &expand_ncs_model);
   m.def("merge_atoms_in_expanded_model", &merge_atoms_in_expanded_model,
         nb::arg("model"), nb::arg("cell"), nb::arg("max_dist")=0.2,
-        nb::arg("compare_serial")=true);
+        nb::arg("compare_serial")=true, nb::arg("threads")=1);
 
   // select.hpp
   nb::class_<FilterProxy<Selection, Model>> pySelectionModelsProxy(m, "SelectionModelsProxy");
@@ -605,6 +704,29 @@ void add_mol(nb::module_& m) {
     })
     .def("str", &Selection::str);
 
+  nb::class_<SelectionMask>(m, "SelectionMask")
+    .def(nb::init<const Selection&, const Model&>(),
+         nb::arg("selection"), nb::arg("model"))
+    .def("count", &SelectionMask::count)
+    .def("any", &SelectionMask::any)
+    .def("copy_selection", &SelectionMask::copy_selection)
+    .def("remove_selected", &SelectionMask::remove_selected)
+    .def("remove_not_selected", &SelectionMask::remove_not_selected)
+    .def("__len__", &SelectionMask::size)
+    .def("__getitem__", [](const SelectionMask& self, size_t i) {
+        if (i >= self.size())
+          throw nb::index_error();
+        return self.test(i);
+    })
+    .def(nb::self & nb::self)
+    .def(nb::self | nb::self)
+    .def(nb::self ^ nb::self)
+    .def(~nb::self)
+    .def(nb::self == nb::self)
+    .def("__repr__", [](const SelectionMask& self) {
+        return cat("<gemmi.SelectionMask ", self.count(), " of ", self.size(), " atoms>");
+    });
+
   pySelectionModelsProxy
     .def("__iter__", [](FilterProxy<Selection, Model>& self) {
         return usual_iterator(self, self);
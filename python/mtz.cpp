@@ -292,7 +292,7 @@ void add_mtz(nb::module_& m) {
     .def("ensure_asu", &Mtz::ensure_asu, nb::arg("tnt_asu")=false)
     .def("switch_to_original_hkl", &Mtz::switch_to_original_hkl)
     .def("switch_to_asu_hkl", &Mtz::switch_to_asu_hkl)
-    .def("write_to_file", &Mtz::write_to_file, nb::arg("path"))
+    .def("write_to_file", &Mtz::write_to_file, nb::arg("path"), release_gil())
     .def("write_to_bytes", [](const Mtz& self) {
         size_t nbytes = self.size_to_write();
         nb::bytes obj(nullptr, nbytes);
@@ -378,5 +378,6 @@ void add_mtz(nb::module_& m) {
     mtz->logger = std::move(logging);
     mtz->read_file_gz(path, with_data);
     return mtz.release();
-  }, nb::arg("path"), nb::arg("logging")=nb::none(), nb::arg("with_data")=true);
+  }, nb::arg("path"), nb::arg("logging")=nb::none(), nb::arg("with_data")=true,
+     release_gil());
 }
@@ -17,30 +17,53 @@
 #include "gemmi/mmread_gz.hpp"     // for read_structure_gz
 #include "gemmi/mmread.hpp"        // for read_structure_from_memory
 #include "gemmi/json.hpp"          // for read_mmjson_insitu
+#include "gemmi/parallel.hpp"      // for parallel_for_each_index
 
 
 using namespace gemmi;
 
 NB_MAKE_OPAQUE(std::vector<SmallStructure::Site>)
 
+namespace {
+
+// Calls read(path) for all paths in a pool of threads, without the GIL.
+template<typename T, typename Func>
+std::vector<T> read_files_in_parallel(const std::vector<std::string>& paths,
+                                      int n_threads, Func read) {
+  nb::gil_scoped_release release;
+  std::vector<T> result(paths.size());
+  parallel_for_each_index(paths.size(), n_threads, [&](size_t i) {
+    result[i] = read(paths[i]);
+  });
+  return result;
+}
+
+}  // anonymous namespace
+
 void add_cif_read(nb::module_& cif) {
   cif.def("read_file", &read_cif_gz, nb::arg("filename"), nb::arg("check_level")=1,
-          "Reads a CIF file copying data into Document.");
+          release_gil(), "Reads a CIF file copying data into Document.");
   cif.def("read", &read_cif_or_mmjson_gz,
-          nb::arg("filename"), "Reads normal or gzipped CIF file.");
+          nb::arg("filename"), release_gil(), "Reads normal or gzipped CIF file.");
+  cif.def("read_files", [](const std::vector<std::string>& paths, int check_level,
+                           int threads) {
+            return read_files_in_parallel<cif::Document>(paths, threads,
+                [&](const std::string& path) { return read_cif_gz(path, check_level); });
+          }, nb::arg("paths"), nb::arg("check_level")=1, nb::arg("threads")=0,
+          "Reads CIF files in parallel, returns a list of Documents.");
   cif.def("read_string", [](const std::string& str, int check_level) {
             return read_cif_from_memory(str.c_str(), str.size(), "string", check_level);
-          }, nb::arg("string"), nb::arg("check_level")=1,
+          }, nb::arg("string"), nb::arg("check_level")=1, release_gil(),
           "Reads a string as a CIF file.");
   cif.def("read_string", [](const nb::bytes& data, int check_level) {
             return read_cif_from_memory(data.c_str(), data.size(), "data", check_level);
           }, nb::arg("data"), nb::arg("check_level")=1,
           "Reads bytes as a CIF file.");
   cif.def("read_mmjson", &read_mmjson_gz,
-          nb::arg("filename"), "Reads normal or gzipped mmJSON file.");
+          nb::arg("filename"), release_gil(), "Reads normal or gzipped mmJSON file.");
   cif.def("read_mmjson_string", [](std::string data) {
       return cif::read_mmjson_insitu(data.data(), data.size());
-  });
+  }, release_gil());
   cif.def("read_mmjson_string", [](const nb::bytes& data) {
       std::string str(data.c_str(), data.size());
       return cif::read_mmjson_insitu(str.data(), str.size());
@@ -74,7 +97,7 @@ void add_read_structure(nb::module_& m) {
           return st;
         }, nb::arg("path"), nb::arg("merge_chain_parts")=true,
            nb::arg("format")=CoorFormat::Unknown,
-           nb::arg("save_doc")=nb::none(),
+           nb::arg("save_doc")=nb::none(), release_gil(),
         "Reads a coordinate file into Structure.");
   m.def("read_structure_string", [](nb::bytes& s, bool merge,
                                     CoorFormat format, cif::Document* save_doc) {
@@ -95,8 +118,20 @@ void add_read_structure(nb::module_& m) {
           return st;
         }, nb::arg("path"), nb::arg("merge_chain_parts")=true,
            nb::arg("format")=CoorFormat::Unknown,
-           nb::arg("save_doc")=nb::none(),
+           nb::arg("save_doc")=nb::none(), release_gil(),
         "Reads a coordinate file into Structure.");
+  m.def("read_structures", [](const std::vector<std::string>& paths, bool merge,
+                              CoorFormat format, int threads) {
+          return read_files_in_parallel<Structure>(paths, threads,
+              [&](const std::string& path) {
+                Structure st = read_structure_gz(path, format, nullptr);
+                if (merge)
+                  st.merge_chain_parts();
+                return st;
+          });
+        }, nb::arg("paths"), nb::arg("merge_chain_parts")=true,
+           nb::arg("format")=CoorFormat::Unknown, nb::arg("threads")=0,
+        "Reads coordinate files in parallel, returns a list of Structures.");
   m.def("make_structure_from_block", &make_structure_from_block,
         nb::arg("block"), "Takes mmCIF block and returns Structure.");
   m.def("make_structure_from_chemcomp_block", &make_structure_from_chemcomp_block,
@@ -108,7 +143,8 @@ void add_read_structure(nb::module_& m) {
           PdbReadOptions options{max_line_length, ignore_ter, split_chain_on_ter, false};
           return new Structure(read_pdb_string(s, "string", options));
         }, nb::arg("s"), nb::arg("max_line_length")=0,
-           nb::arg("ignore_ter")=false, nb::arg("split_chain_on_ter")=false, "Reads a string as PDB file.");
+           nb::arg("ignore_ter")=false, nb::arg("split_chain_on_ter")=false, release_gil(),
+        "Reads a string as PDB file.");
   m.def("read_pdb_string", [](const nb::bytes& s, int max_line_length,
                               bool ignore_ter, bool split_chain_on_ter) {
           PdbReadOptions options{max_line_length, ignore_ter, split_chain_on_ter, false};
@@ -120,13 +156,13 @@ void add_read_structure(nb::module_& m) {
           PdbReadOptions options{max_line_length, ignore_ter, split_chain_on_ter, false};
           return new Structure(read_pdb_gz(path, options));
         }, nb::arg("filename"), nb::arg("max_line_length")=0,
-           nb::arg("ignore_ter")=false, nb::arg("split_chain_on_ter")=false);
+           nb::arg("ignore_ter")=false, nb::arg("split_chain_on_ter")=false, release_gil());
 
   // from smcif.hpp
   m.def("read_small_structure", [](const std::string& path) {
           cif::Block block = read_cif_gz(path).sole_block();
           return new SmallStructure(make_small_structure_from_block(block));
-        }, nb::arg("path"), "Reads a small molecule CIF file.");
+        }, nb::arg("path"), release_gil(), "Reads a small molecule CIF file.");
   m.def("make_small_structure_from_block", &make_small_structure_from_block,
         nb::arg("block"), "Takes CIF block and returns SmallStructure.");
 
@@ -25,7 +25,7 @@ void add_scaling(nb::module_& m) {
          nb::arg("calc"), nb::arg("obs"), nb::arg("mask")=static_cast<FPhiData*>(nullptr))
     .def("fit_isotropic_b_approximately", &Scaling::fit_isotropic_b_approximately)
     .def("fit_b_star_approximately", &Scaling::fit_b_star_approximately)
-    .def("fit_parameters", &Scaling::fit_parameters)
+    .def("fit_parameters", &Scaling::fit_parameters, release_gil())
 #if WITH_NLOPT
     .def("fit_parameters_with_nlopt", &gemmi::fit_parameters_with_nlopt<float>)
 #endif
@@ -45,7 +45,7 @@ void add_search(nb::module_& m) {
     .def(nb::init<SmallStructure&, double>(),
          nb::arg("small_structure"), nb::arg("max_radius"),
          nb::keep_alive<1, 2>())
-    .def("populate", &NeighborSearch::populate, nb::arg("include_h")=true,
+    .def("populate", &NeighborSearch::populate, nb::arg("include_h")=true, release_gil(),
          "Usually run after constructing NeighborSearch.")
     .def("add_chain", &NeighborSearch::add_chain,
          nb::arg("chain"), nb::arg("include_h")=true)
@@ -77,6 +77,21 @@ void add_search(nb::module_& m) {
                    self.grid.nu, ", ", self.grid.nv, ", ", self.grid.nw, '>');
     });
 
+  nb::class_<NeighborSearchCache>(m, "NeighborSearchCache")
+    .def(nb::init<double>(), nb::arg("radius")=5.0)
+    .def_rw("radius", &NeighborSearchCache::radius)
+    .def_ro("build_count", &NeighborSearchCache::build_count)
+    .def("get", [](NeighborSearchCache& self, Structure& st, int model_index,
+                   double min_radius) -> NeighborSearch& {
+      return self.get(st.models.at(model_index), st.cell, min_radius);
+    }, nb::arg("st"), nb::arg("model_index")=0, nb::arg("min_radius")=0.,
+       nb::rv_policy::reference_internal, nb::keep_alive<1, 2>())
+    .def("invalidate", &NeighborSearchCache::invalidate)
+    .def("__repr__", [](const NeighborSearchCache& self) {
+        return cat("<gemmi.NeighborSearchCache radius=", self.radius,
+                   " built ", self.build_count, " times>");
+    });
+
   nb::class_<ContactSearch> contactsearch(m, "ContactSearch");
   nb::enum_<ContactSearch::Ignore> csignore(contactsearch, "Ignore");
   nb::class_<ContactSearch::Result> csresult(contactsearch, "Result");
@@ -95,7 +110,7 @@ void add_search(nb::module_& m) {
     .def("set_radius", [](ContactSearch& self, Element el, float r) {
         self.set_radius(el.elem, r);
     })
-    .def("find_contacts", &ContactSearch::find_contacts)
+    .def("find_contacts", &ContactSearch::find_contacts, release_gil())
     ;
 
   csignore
@@ -122,7 +137,8 @@ void add_search(nb::module_& m) {
          nb::arg("monlib"), nb::arg("use_alias")=true, nb::keep_alive<1, 2>())
     .def("find_possible_links", &LinkHunt::find_possible_links,
          nb::arg("st"), nb::arg("bond_margin"), nb::arg("radius_margin"),
-         nb::arg("ignore")=ContactSearch::Ignore::SameResidue)
+         nb::arg("ignore")=ContactSearch::Ignore::SameResidue,
+         nb::arg("ns_cache").none()=nb::none())
     ;
 
   linkhuntmatch
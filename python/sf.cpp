@@ -41,9 +41,9 @@ void add_dencalc(nb::module_& m, const char* name) {
     .def_rw("addends", &DenCalc::addends)
     .def("set_refmac_compatible_blur", &DenCalc::set_refmac_compatible_blur,
          nb::arg("model"), nb::arg("allow_negative")=false)
-    .def("put_model_density_on_grid", &DenCalc::put_model_density_on_grid)
+    .def("put_model_density_on_grid", &DenCalc::put_model_density_on_grid, release_gil())
     .def("initialize_grid", &DenCalc::initialize_grid)
-    .def("add_model_density_to_grid", &DenCalc::add_model_density_to_grid)
+    .def("add_model_density_to_grid", &DenCalc::add_model_density_to_grid, release_gil())
     .def("add_atom_density_to_grid", &DenCalc::add_atom_density_to_grid)
     .def("add_c_contribution_to_grid", &DenCalc::add_c_contribution_to_grid)
     // deprecated
@@ -3,6 +3,7 @@
 #include "gemmi/topo.hpp"
 #include "gemmi/riding_h.hpp"  // for adjust_hydrogen_distances
 #include "gemmi/crd.hpp"       // for prepare_refmac_crd, ...
+#include "gemmi/neighbor.hpp"  // for NeighborSearchCache
 
 #include "common.h"
 #include <nanobind/stl/bind_vector.h>
@@ -167,11 +168,13 @@ void add_topo(nb::module_& m) {
         nb::arg("st"), nb::arg("monlib"), nb::arg("model_index")=0,
         nb::arg("h_change")=HydrogenChange::NoChange, nb::arg("reorder")=false,
         nb::arg("warnings")=nb::none(), nb::arg("ignore_unknown_links")=false,
-        nb::arg("use_cispeps")=false);
+        nb::arg("use_cispeps")=false, nb::arg("threads")=1);
 
   // crd.hpp
   m.def("setup_for_crd", &setup_for_crd);
   m.def("prepare_refmac_crd", &prepare_refmac_crd);
-  m.def("add_automatic_links", &add_automatic_links);
+  m.def("add_automatic_links", &add_automatic_links,
+        nb::arg("model"), nb::arg("st"), nb::arg("monlib"),
+        nb::arg("ns_cache").none()=nb::none());
   m.def("add_dictionary_blocks", &add_dictionary_blocks);
 }
@@ -4,6 +4,7 @@
 #include <sstream>  // for ostringstream
 #include "gemmi/to_mmcif.hpp"
 #include "gemmi/to_pdb.hpp"
+#include "gemmi/assembly.hpp"  // for InstancedAssembly
 #include "gemmi/fstream.hpp"
 
 #include "common.h"
@@ -128,4 +129,17 @@ void add_write(nb::module_& m, nb::class_<Structure>& structure) {
          nb::arg("groups").sig("MmcifOutputGroups(True)")=MmcifOutputGroups(true))
     .def("make_mmcif_headers", &make_mmcif_headers)
     ;
+
+  m.def("write_assembly_pdb", [](const InstancedAssembly& assembly, const std::string& path,
+                                 PdbWriteOptions options) {
+      Ofstream f(path);
+      write_assembly_pdb(assembly, f.ref(), options);
+  }, nb::arg("assembly"), nb::arg("path"),
+     nb::arg("options").sig("PdbWriteOptions()")=PdbWriteOptions());
+  m.def("make_assembly_pdb_string", [](const InstancedAssembly& assembly,
+                                       PdbWriteOptions options) {
+      std::ostringstream os;
+      write_assembly_pdb(assembly, os, options);
+      return os.str();
+  }, nb::arg("assembly"), nb::arg("options").sig("PdbWriteOptions()")=PdbWriteOptions());
 }
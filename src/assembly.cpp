@@ -2,9 +2,13 @@
 
 #include "gemmi/assembly.hpp"
 
+#include <array>
+#include <atomic>
+#include <cmath>              // floor
 #include <memory>             // unique_ptr
 #include "gemmi/modify.hpp"   // transform_pos_and_adp
 #include "gemmi/neighbor.hpp" // NeighborSearch
+#include "gemmi/parallel.hpp" // parallel_for
 
 namespace gemmi {
 
@@ -63,75 +67,53 @@ void remove_cras(Model& model, std::vector<CRA>& vec) {
   }
 }
 
+void copy_chain(const InstancedAssembly& ia, const InstancedAssembly::ChainCopy& cc,
+                Chain& new_chain) {
+  const Chain& chain = ia.orig_chain(cc);
+  const Transform& tr = ia.transform(cc);
+  size_t n = ia.residue_count(cc);
+  new_chain.residues.reserve(n);
+  for (size_t i = 0; i != n; ++i) {
+    new_chain.residues.push_back(ia.residue(cc, i));
+    Residue& new_res = new_chain.residues.back();
+    transform_pos_and_adp(new_res, tr);
+    if (!new_res.subchain.empty()) {
+      // change subchain name for the residue
+      if (ia.how == HowToNameCopiedChain::Short)
+        new_res.subchain = new_chain.name + ":" + new_res.subchain;
+      else if (ia.how == HowToNameCopiedChain::AddNumber)
+        new_res.subchain += new_chain.name.substr(chain.name.size());
+    }
+    if (ia.how == HowToNameCopiedChain::Dup && cc.instance_idx != 0)
+      new_res.segment = std::to_string(cc.instance_idx);
+  }
+}
+
 Model make_assembly_(const Assembly& assembly, const Model& model,
                      HowToNameCopiedChain how, const Logger& logger,
                      AssemblyMapping* mapping) {
-  Model new_model(model.num);
-  ChainNameGenerator namegen(how);
-  std::map<std::string, std::string> subs = model.subchain_to_chain();
-  int counter = 0;
-  for (const Assembly::Gen& gen : assembly.generators) {
-    bool all_chains = (!gen.chains.empty() && gen.chains[0] == "(all)");
-    for (const Assembly::Operator& oper : gen.operators) {
-      if (logger.callback) {
-        std::string note = cat("Applying ", oper.name, " to");
-        if (all_chains)
-          note += " all chains";
-        else if (!gen.chains.empty())
-          cat_to(note, " chains: ", join_str(gen.chains, ','));
-        else if (!gen.subchains.empty())
-          cat_to(note, " subchains: ", join_str(gen.subchains, ','));
-        logger.note(note);
-      }
-      if (!all_chains) {
-        for (const std::string& chain_name : gen.chains)
-          if (!model.find_chain(chain_name))
-            logger.err("no chain ", chain_name);
-        for (const std::string& subchain_name : gen.subchains)
-          if (subs.find(subchain_name) == subs.end())
-            logger.err("no subchain ", subchain_name);
-      }
+  InstancedAssembly ia = make_instanced_assembly(assembly, model, how, logger);
+  Model new_model = ia.to_model();
+  if (mapping) {
+    size_t n = 0;
+    for (size_t i = 0; i != ia.instances.size(); ++i) {
       // chains are not merged here, multiple chains may have the same name
       ChainMap chain_map;
-      if (counter != 0) {
+      if (i != 0) {
         chain_map.uses_segments = (how == HowToNameCopiedChain::Dup);
-        chain_map.id = std::to_string(counter);
+        chain_map.id = std::to_string(i);
       }
-      for (const Chain& chain : model.chains) {
-        // PDB files specify bioassemblies in terms of chains,
-        // mmCIF files in terms of subchains.
-        bool whole_chain = (all_chains || in_vector(chain.name, gen.chains));
-        if (whole_chain ||
-            (!gen.subchains.empty() && any_subchain_matches(chain, gen))) {
-          // try add a new empty chain, but first figure out the name for it
-          auto result = chain_map.names.emplace(chain.name, "");
-          if (result.second)  // insertion happened - generate a new chain name
-            result.first->second = namegen.make_new_name(chain.name, counter+1);
-          new_model.chains.emplace_back(result.first->second);
-          Chain& new_chain = new_model.chains.back();
-          // add residues to the chain
-          for (const Residue& res : chain.residues)
-            if (whole_chain || in_vector(res.subchain, gen.subchains)) {
-              new_chain.residues.push_back(res);
-              Residue& new_res = new_chain.residues.back();
-              transform_pos_and_adp(new_res, oper.transform);
-              if (!new_res.subchain.empty()) {
-                // change subchain name for the residue
-                if (how == HowToNameCopiedChain::Short)
-                  new_res.subchain = new_chain.name + ":" + new_res.subchain;
-                else if (how == HowToNameCopiedChain::AddNumber)
-                  new_res.subchain += new_chain.name.substr(chain.name.size());
-                if (mapping)
-                  mapping->sub.emplace(new_res.subchain, res.subchain);
-              }
-              if (chain_map.uses_segments)
-                new_res.segment = chain_map.id;
-            }
-        }
+      for (; n != ia.chains.size() && ia.chains[n].instance_idx == (int) i; ++n) {
+        const InstancedAssembly::ChainCopy& cc = ia.chains[n];
+        chain_map.names.emplace(ia.orig_chain(cc).name, cc.name);
+        const Chain& new_chain = new_model.chains[n];
+        // records subchain name correspondence (new->old)
+        for (size_t j = 0; j != new_chain.residues.size(); ++j)
+          if (!new_chain.residues[j].subchain.empty())
+            mapping->sub.emplace(new_chain.residues[j].subchain,
+                                 ia.residue(cc, j).subchain);
       }
-      if (mapping)
-        mapping->chain_maps.push_back(std::move(chain_map));
-      ++counter;
+      mapping->chain_maps.push_back(std::move(chain_map));
     }
   }
   return new_model;
@@ -283,8 +265,234 @@ void finalize_expansion(Structure& st, const AssemblyMapping& mapping,
   st.sheets = new_sheets;
 }
 
+// Spatial hash: points are sorted by the (integer) index of a cubic cell
+// with edge >= max_dist, so all points within max_dist from a given point
+// are in the 27 cells around it. Cells are found by binary search.
+class PointHash {
+public:
+  explicit PointHash(double max_dist) : inv_size_(1 / max_dist) {}
+
+  // get_pos(i) returns position of point i
+  template<typename GetPos>
+  void build(size_t n, GetPos get_pos, int n_threads) {
+    entries_.resize(n);
+    parallel_for(n, n_threads, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i != end; ++i)
+        entries_[i] = {cell_of(get_pos(i)), i};
+    });
+    // ties are resolved by point index, so the order is deterministic
+    std::sort(entries_.begin(), entries_.end());
+  }
+
+  // calls func(i) for each point i that may be within max_dist from pos
+  template<typename Func>
+  void for_each_near(const Position& pos, const Func& func) const {
+    Key key = cell_of(pos);
+    for (int64_t dx = -1; dx <= 1; ++dx)
+      for (int64_t dy = -1; dy <= 1; ++dy)
+        for (int64_t dz = -1; dz <= 1; ++dz) {
+          Key k{{key[0] + dx, key[1] + dy, key[2] + dz}};
+          auto it = std::lower_bound(entries_.begin(), entries_.end(), Entry{k, 0});
+          for (; it != entries_.end() && it->key == k; ++it)
+            func(it->index);
+        }
+  }
+
+private:
+  using Key = std::array<int64_t, 3>;
+  struct Entry {
+    Key key;
+    size_t index;
+    bool operator<(const Entry& o) const {
+      return key < o.key || (key == o.key && index < o.index);
+    }
+  };
+  double inv_size_;
+  std::vector<Entry> entries_;
+
+  Key cell_of(const Position& p) const {
+    return {{(int64_t) std::floor(p.x * inv_size_),
+             (int64_t) std::floor(p.y * inv_size_),
+             (int64_t) std::floor(p.z * inv_size_)}};
+  }
+};
+
+void merge_atoms_using_neighbor_search(Model& model, const UnitCell& cell,
+                                       double max_dist, bool compare_serial) {
+  using Mark = NeighborSearch::Mark;
+  NeighborSearch ns(model, cell, 4.0);
+  ns.populate(true);
+  std::vector<CRA> to_be_deleted;
+  for (int n_ch = 0; n_ch != (int) model.chains.size(); ++n_ch) {
+    Chain& chain = model.chains[n_ch];
+    for (int n_res = 0; n_res != (int) chain.residues.size(); ++n_res) {
+      Residue& res = chain.residues[n_res];
+      for (int n_atom = 0; n_atom != (int) res.atoms.size(); ++n_atom) {
+        Atom& atom = res.atoms[n_atom];
+        std::vector<std::pair<CRA, int>> equiv;
+        ns.for_each_cell(atom.pos, [&](std::vector<Mark>& marks, const Fractional& fr) {
+            for (Mark& m : marks) {
+              // We look for the same atoms, but copied to a different chain.
+              // First quick check that filters out most of non-matching pairs.
+              if (m.altloc != atom.altloc || m.element != atom.element ||
+                  m.chain_idx == n_ch || m.atom_idx != n_atom)
+                continue;
+              // Now check if everything else matches.
+              CRA cra = m.to_cra(model);
+              if (cra.atom &&
+                  (!compare_serial || cra.atom->serial == atom.serial) &&
+                  cra.atom->name == atom.name &&
+                  cra.atom->b_iso == atom.b_iso &&
+                  cra.residue->matches_noseg(res) &&
+                  m.pos.dist_sq(ns.grid.unit_cell.orthogonalize(fr)) < sq(max_dist))
+                equiv.emplace_back(cra, m.image_idx);
+            }
+        });
+        if (!equiv.empty()) {
+          Position pos_sum = atom.pos;
+          for (auto& t : equiv) {
+            CRA& cra = t.first;
+            pos_sum += ns.grid.unit_cell.find_nearest_pbc_position(
+                                          atom.pos, cra.atom->pos, t.second);
+            // The atoms in equiv are to be discarded later.
+            // Deleting now would invalidate indices in NeighborSearch.
+            to_be_deleted.push_back(cra);
+            // Modify the atoms to avoid processing them again.
+            cra.atom->serial = -1;
+            cra.atom->name.clear();
+          }
+          size_t n = 1 + equiv.size();
+          atom.pos = pos_sum / double(n);
+          atom.occ = std::min(1.f, n * atom.occ);
+        }
+      }
+    }
+  }
+  remove_cras(model, to_be_deleted);
+}
+
 } // anonymous namespace
 
+std::vector<Position> InstancedAssembly::get_positions(int n_threads) const {
+  std::vector<size_t> offsets(chains.size() + 1, 0);
+  for (size_t i = 0; i != chains.size(); ++i) {
+    offsets[i+1] = offsets[i];
+    for (size_t j = 0; j != residue_count(chains[i]); ++j)
+      offsets[i+1] += residue(chains[i], j).atoms.size();
+  }
+  std::vector<Position> positions(offsets.back());
+  parallel_for(chains.size(), n_threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i != end; ++i) {
+      const ChainCopy& cc = chains[i];
+      const Transform& tr = transform(cc);
+      Position* out = &positions[offsets[i]];
+      for (size_t j = 0; j != residue_count(cc); ++j)
+        for (const Atom& atom : residue(cc, j).atoms)
+          *out++ = Position(tr.apply(atom.pos));
+    }
+  });
+  return positions;
+}
+
+Chain InstancedAssembly::make_chain(const ChainCopy& cc) const {
+  Chain new_chain(cc.name);
+  copy_chain(*this, cc, new_chain);
+  return new_chain;
+}
+
+Model InstancedAssembly::to_model(int n_threads) const {
+  Model new_model(model->num);
+  new_model.chains.reserve(chains.size());
+  for (const ChainCopy& cc : chains)
+    new_model.chains.emplace_back(cc.name);
+  parallel_for(chains.size(), n_threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i != end; ++i)
+      copy_chain(*this, chains[i], new_model.chains[i]);
+  });
+  return new_model;
+}
+
+InstancedAssembly make_instanced_assembly(const Assembly& assembly, const Model& model,
+                                          HowToNameCopiedChain how, const Logger& logger) {
+  InstancedAssembly ia;
+  ia.model = &model;
+  ia.how = how;
+  ChainNameGenerator namegen(how);
+  std::map<std::string, std::string> subs = model.subchain_to_chain();
+  for (const Assembly::Gen& gen : assembly.generators) {
+    bool all_chains = (!gen.chains.empty() && gen.chains[0] == "(all)");
+    for (const Assembly::Operator& oper : gen.operators) {
+      if (logger.callback) {
+        std::string note = cat("Applying ", oper.name, " to");
+        if (all_chains)
+          note += " all chains";
+        else if (!gen.chains.empty())
+          cat_to(note, " chains: ", join_str(gen.chains, ','));
+        else if (!gen.subchains.empty())
+          cat_to(note, " subchains: ", join_str(gen.subchains, ','));
+        logger.note(note);
+      }
+      if (!all_chains) {
+        for (const std::string& chain_name : gen.chains)
+          if (!model.find_chain(chain_name))
+            logger.err("no chain ", chain_name);
+        for (const std::string& subchain_name : gen.subchains)
+          if (subs.find(subchain_name) == subs.end())
+            logger.err("no subchain ", subchain_name);
+      }
+      int counter = (int) ia.instances.size();
+      ia.instances.push_back({oper.name, oper.transform});
+      std::map<std::string, std::string> names;  // old -> new chain name
+      for (size_t i = 0; i != model.chains.size(); ++i) {
+        const Chain& chain = model.chains[i];
+        // PDB files specify bioassemblies in terms of chains,
+        // mmCIF files in terms of subchains.
+        bool whole_chain = (all_chains || in_vector(chain.name, gen.chains));
+        if (whole_chain ||
+            (!gen.subchains.empty() && any_subchain_matches(chain, gen))) {
+          // figure out the name for the chain copy
+          auto result = names.emplace(chain.name, "");
+          if (result.second)  // insertion happened - generate a new chain name
+            result.first->second = namegen.make_new_name(chain.name, counter+1);
+          InstancedAssembly::ChainCopy cc;
+          cc.instance_idx = counter;
+          cc.chain_idx = (int) i;
+          cc.name = result.first->second;
+          if (!whole_chain)
+            for (size_t j = 0; j != chain.residues.size(); ++j)
+              if (in_vector(chain.residues[j].subchain, gen.subchains))
+                cc.residues.push_back((int) j);
+          ia.chains.push_back(std::move(cc));
+        }
+      }
+    }
+  }
+  return ia;
+}
+
+NeighborSearch make_neighbor_search(const InstancedAssembly& ia,
+                                    double radius, bool include_h) {
+  std::vector<Position> positions = ia.get_positions();
+  Box<Position> box;
+  for (const Position& pos : positions)
+    box.extend(pos);
+  NeighborSearch ns(box, radius);
+  ns.include_h = include_h;
+  const Position* pos = positions.data();
+  for (int n_ch = 0; n_ch != (int) ia.chains.size(); ++n_ch) {
+    const InstancedAssembly::ChainCopy& cc = ia.chains[n_ch];
+    for (int n_res = 0; n_res != (int) ia.residue_count(cc); ++n_res) {
+      const Residue& res = ia.residue(cc, n_res);
+      for (int n_atom = 0; n_atom != (int) res.atoms.size(); ++n_atom, ++pos) {
+        const Atom& atom = res.atoms[n_atom];
+        if (include_h || !atom.is_hydrogen())
+          ns.add_position(*pos, atom.altloc, atom.element.elem, n_ch, n_res, n_atom);
+      }
+    }
+  }
+  return ns;
+}
+
 Model make_assembly(const Assembly& assembly, const Model& model,
                     HowToNameCopiedChain how, const Logger& logging) {
   return make_assembly_(assembly, model, how, logging, nullptr);
@@ -353,55 +561,84 @@ void expand_ncs(Structure& st, HowToNameCopiedChain how, double merge_dist) {
 
 
 void merge_atoms_in_expanded_model(Model& model, const UnitCell& cell, double max_dist,
-                                   bool compare_serial) {
-  using Mark = NeighborSearch::Mark;
-  NeighborSearch ns(model, cell, 4.0);
-  ns.populate(true);
+                                   bool compare_serial, int n_threads) {
+  // Crystal symmetry (and NCS images in UnitCell) are handled by NeighborSearch.
+  if (cell.is_crystal() || !cell.images.empty()) {
+    merge_atoms_using_neighbor_search(model, cell, max_dist, compare_serial);
+    return;
+  }
+  if (!(max_dist > 0))
+    return;
+  struct Item {
+    CRA cra;
+    int n_ch;
+    int n_atom;
+  };
+  std::vector<Item> items;
+  for (int n_ch = 0; n_ch != (int) model.chains.size(); ++n_ch)
+    for (Residue& res : model.chains[n_ch].residues)
+      for (int n_atom = 0; n_atom != (int) res.atoms.size(); ++n_atom)
+        items.push_back({{&model.chains[n_ch], &res, &res.atoms[n_atom]}, n_ch, n_atom});
+  PointHash hash(max_dist);
+  hash.build(items.size(), [&](size_t i) { return items[i].cra.atom->pos; }, n_threads);
+
+  // Find equivalent atoms (in parallel, without modifying the model).
+  // Chunks can be processed in any order, the pairs are sorted afterwards.
+  std::vector<std::vector<std::pair<size_t, size_t>>> chunk_pairs(
+      (size_t) std::max(normalize_thread_count(n_threads), 1));
+  std::atomic<size_t> chunk_counter{0};
+  parallel_for(items.size(), n_threads, [&](size_t begin, size_t end) {
+    std::vector<std::pair<size_t, size_t>>& pairs = chunk_pairs[chunk_counter++];
+    for (size_t i = begin; i != end; ++i) {
+      const Item& item = items[i];
+      const Atom& atom = *item.cra.atom;
+      hash.for_each_near(atom.pos, [&](size_t j) {
+        const Item& other = items[j];
+        const Atom& a = *other.cra.atom;
+        // We look for the same atoms, but copied to a different chain.
+        if (a.altloc == atom.altloc && a.element == atom.element &&
+            other.n_ch != item.n_ch && other.n_atom == item.n_atom &&
+            (!compare_serial || a.serial == atom.serial) &&
+            a.name == atom.name &&
+            a.b_iso == atom.b_iso &&
+            other.cra.residue->matches_noseg(*item.cra.residue) &&
+            a.pos.dist_sq(atom.pos) < sq(max_dist))
+          pairs.emplace_back(i, j);
+      });
+    }
+  });
+  std::vector<std::pair<size_t, size_t>> pairs;
+  for (std::vector<std::pair<size_t, size_t>>& v : chunk_pairs)
+    vector_move_extend(pairs, std::move(v));
+  std::sort(pairs.begin(), pairs.end());
+
+  // Merge atoms in the original order of atoms (deterministic).
+  std::vector<char> deleted(items.size(), 0);
   std::vector<CRA> to_be_deleted;
-  for (int n_ch = 0; n_ch != (int) model.chains.size(); ++n_ch) {
-    Chain& chain = model.chains[n_ch];
-    for (int n_res = 0; n_res != (int) chain.residues.size(); ++n_res) {
-      Residue& res = chain.residues[n_res];
-      for (int n_atom = 0; n_atom != (int) res.atoms.size(); ++n_atom) {
-        Atom& atom = res.atoms[n_atom];
-        std::vector<std::pair<CRA, int>> equiv;
-        ns.for_each_cell(atom.pos, [&](std::vector<Mark>& marks, const Fractional& fr) {
-            for (Mark& m : marks) {
-              // We look for the same atoms, but copied to a different chain.
-              // First quick check that filters out most of non-matching pairs.
-              if (m.altloc != atom.altloc || m.element != atom.element ||
-                  m.chain_idx == n_ch || m.atom_idx != n_atom)
-                continue;
-              // Now check if everything else matches.
-              CRA cra = m.to_cra(model);
-              if (cra.atom &&
-                  (!compare_serial || cra.atom->serial == atom.serial) &&
-                  cra.atom->name == atom.name &&
-                  cra.atom->b_iso == atom.b_iso &&
-                  cra.residue->matches_noseg(res) &&
-                  m.pos.dist_sq(ns.grid.unit_cell.orthogonalize(fr)) < sq(max_dist))
-                equiv.emplace_back(cra, m.image_idx);
-            }
-        });
-        if (!equiv.empty()) {
-          Position pos_sum = atom.pos;
-          for (auto& t : equiv) {
-            CRA& cra = t.first;
-            pos_sum += ns.grid.unit_cell.find_nearest_pbc_position(
-                                          atom.pos, cra.atom->pos, t.second);
-            // The atoms in equiv are to be discarded later.
-            // Deleting now would invalidate indices in NeighborSearch.
-            to_be_deleted.push_back(cra);
-            // Modify the atoms to avoid processing them again.
-            cra.atom->serial = -1;
-            cra.atom->name.clear();
-          }
-          size_t n = 1 + equiv.size();
-          atom.pos = pos_sum / double(n);
-          atom.occ = std::min(1.f, n * atom.occ);
-        }
+  for (auto it = pairs.begin(); it != pairs.end(); ) {
+    size_t i = it->first;
+    auto group_end = it;
+    while (group_end != pairs.end() && group_end->first == i)
+      ++group_end;
+    if (!deleted[i]) {
+      Atom& atom = *items[i].cra.atom;
+      Position pos_sum = atom.pos;
+      size_t n = 1;
+      for (; it != group_end; ++it) {
+        size_t j = it->second;
+        if (deleted[j])
+          continue;
+        pos_sum += items[j].cra.atom->pos;
+        deleted[j] = 1;
+        to_be_deleted.push_back(items[j].cra);
+        ++n;
+      }
+      if (n > 1) {
+        atom.pos = pos_sum / double(n);
+        atom.occ = std::min(1.f, n * atom.occ);
       }
     }
+    it = group_end;
   }
   remove_cras(model, to_be_deleted);
 }
@@ -0,0 +1,125 @@
+// Copyright 2026 Global Phasing Ltd.
+
+#include <gemmi/binfile.hpp>
+#if defined(__GNUC__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include "../third_party/serializer.h"  // must be included before serialize.hpp
+#if defined(__GNUC__)
+# pragma GCC diagnostic pop
+#endif
+#include <gemmi/fileutil.hpp>   // for file_open, MappedFile
+#include <gemmi/serialize.hpp>  // for serialize(Archive&, Structure&), ...
+#include <gemmi/version.hpp>    // for GEMMI_VERSION
+#include <gemmi/profile.hpp>    // for GEMMI_PROFILE_SCOPE
+
+namespace gemmi {
+
+namespace {
+
+// increase when the serialized format of Structure or Document changes
+constexpr uint32_t kFormat = 1;
+
+enum class Content : uint32_t { Structure=1, Document=2 };
+
+const char* content_name(uint32_t content) {
+  switch (content) {
+    case (uint32_t) Content::Structure: return "Structure";
+    case (uint32_t) Content::Document: return "cif::Document";
+  }
+  return "unknown content";
+}
+
+template<typename T>
+void write_binary(const T& obj, Content content, const std::string& path) {
+  std::vector<unsigned char> data;
+  zpp::serializer::memory_output_archive out(data);
+  out(std::string(GEMMI_VERSION), obj);
+  unsigned char header[16];
+  std::memcpy(header, "gemmibin", 8);
+  std::memcpy(header + 8, &kFormat, 4);
+  std::memcpy(header + 12, &content, 4);
+  fileptr_t f = file_open(path.c_str(), "wb");
+  if (std::fwrite(header, sizeof(header), 1, f.get()) != 1 ||
+      std::fwrite(data.data(), data.size(), 1, f.get()) != 1)
+    sys_fail("Failed to write " + path);
+}
+
+template<typename T>
+void read_binary(const unsigned char* data, size_t size, Content content,
+                 const std::string& name, T& obj) {
+  if (!is_gemmi_binary((const char*) data, size))
+    fail(name + ": not a gemmi binary file");
+  uint32_t format, file_content;
+  std::memcpy(&format, data + 8, 4);
+  std::memcpy(&file_content, data + 12, 4);
+  if (format != kFormat)
+    fail(name + ": binary file format ", std::to_string(format),
+         " is not supported (expected ", std::to_string(kFormat),
+         "), convert the original file again");
+  if (file_content != (uint32_t) content)
+    fail(name + ": binary file contains ", content_name(file_content),
+         ", not ", content_name((uint32_t) content));
+  zpp::serializer::memory_view_input_archive in(data + 16, size - 16);
+  std::string version;
+  try {
+    in(version);
+  } catch (std::exception&) {
+    fail(name + ": truncated or corrupted binary file");
+  }
+  // layout of the classes may change between versions without a change of kFormat
+  if (version != GEMMI_VERSION)
+    fail(name + ": binary file written by gemmi ", version,
+         " can't be read by gemmi " GEMMI_VERSION
+         ", convert the original file again");
+  try {
+    in(obj);
+  } catch (std::exception&) {
+    obj = T();
+    fail(name + ": truncated or corrupted binary file");
+  }
+}
+
+} // anonymous namespace
+
+void write_binary_structure(const Structure& st, const std::string& path) {
+  write_binary(st, Content::Structure, path);
+}
+
+void write_binary_document(const cif::Document& doc, const std::string& path) {
+  write_binary(doc, Content::Document, path);
+}
+
+Structure read_binary_structure_from_memory(const char* data, size_t size,
+                                            const std::string& name) {
+  Structure st;
+  read_binary((const unsigned char*) data, size, Content::Structure, name, st);
+  return st;
+}
+
+cif::Document read_binary_document_from_memory(const char* data, size_t size,
+                                               const std::string& name) {
+  cif::Document doc;
+  read_binary((const unsigned char*) data, size, Content::Document, name, doc);
+  return doc;
+}
+
+Structure read_binary_structure(const std::string& path) {
+  GEMMI_PROFILE_SCOPE("binfile.read_structure");
+  MappedFile file;
+  file.open(path);
+  Structure st;
+  read_binary(file.data(), file.size(), Content::Structure, path, st);
+  return st;
+}
+
+cif::Document read_binary_document(const std::string& path) {
+  MappedFile file;
+  file.open(path);
+  cif::Document doc;
+  read_binary(file.data(), file.size(), Content::Document, path, doc);
+  return doc;
+}
+
+} // namespace gemmi
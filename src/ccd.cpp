@@ -0,0 +1,239 @@
+// Copyright 2026 Global Phasing Ltd.
+
+#include <gemmi/ccd.hpp>
+#include <cstdlib>              // for strtoull, strtoll
+#include <cstring>              // for memchr
+#include <random>               // for random_device
+#include <gemmi/atox.hpp>       // for is_space
+#include <gemmi/read_cif.hpp>   // for read_cif_from_memory
+#include <gemmi/util.hpp>       // for iends_with, ialpha4_id
+
+namespace gemmi {
+
+namespace {
+
+const char* const index_header = "# gemmi CIF block index, format 1\n";
+
+bool seek_to(std::FILE* f, uint64_t offset) {
+#if defined(_WIN32)
+  return ::_fseeki64(f, (__int64) offset, SEEK_SET) == 0;
+#else
+  return ::fseeko(f, (off_t) offset, SEEK_SET) == 0;
+#endif
+}
+
+} // anonymous namespace
+
+void CifBlockIndex::build(const std::string& path) {
+  if (iends_with(path, ".gz"))
+    fail(path + ": compressed file can't be indexed, uncompress it first.");
+  if (!get_file_stamp(path, stamp))
+    sys_fail("Failed to open " + path);
+  fileptr_t f = file_open(path.c_str(), "rb");
+  std::vector<uint64_t> offsets;
+  std::vector<std::string> all_names;
+  std::vector<char> buf(1 << 20);
+  uint64_t pos = 0;  // file offset of buf[0]
+  bool line_start = true;
+  bool in_text = false;  // in a multi-line text field
+  bool capturing = false;  // reading the first word of a line
+  std::string head;
+  uint64_t head_offset = 0;
+  auto finish_head = [&] {
+    capturing = false;
+    if (head.size() > 5 && ialpha4_id(head.c_str()) == ialpha4_id("data") &&
+        head[4] == '_') {
+      offsets.push_back(head_offset);
+      all_names.emplace_back(head, 5);
+    }
+  };
+  for (;;) {
+    size_t n = std::fread(buf.data(), 1, buf.size(), f.get());
+    const char* p = buf.data();
+    const char* end = p + n;
+    while (p < end) {
+      if (capturing) {
+        if (!is_space(*p)) {
+          head += *p++;
+          continue;
+        }
+        finish_head();
+      } else if (line_start) {
+        line_start = false;
+        if (*p == ';') {
+          in_text = !in_text;
+        } else if (!in_text && (*p | 0x20) == 'd') {
+          capturing = true;
+          head.assign(1, *p);
+          head_offset = pos + (p - buf.data());
+          ++p;
+          continue;
+        }
+      }
+      const char* nl = (const char*) std::memchr(p, '\n', end - p);
+      if (!nl)
+        break;
+      p = nl + 1;
+      line_start = true;
+    }
+    pos += n;
+    if (n < buf.size()) {
+      if (std::ferror(f.get()))
+        sys_fail("Failed to read " + path);
+      break;
+    }
+  }
+  if (capturing)
+    finish_head();
+  blocks.clear();
+  names.clear();
+  for (size_t i = 0; i != offsets.size(); ++i) {
+    uint64_t block_end = i + 1 < offsets.size() ? offsets[i+1] : pos;
+    if (blocks.emplace(all_names[i], Entry{offsets[i], block_end - offsets[i]}).second)
+      names.push_back(std::move(all_names[i]));
+  }
+}
+
+bool CifBlockIndex::load(const std::string& index_path, const FileStamp& expected) {
+  CharArray mem;
+  try {
+    mem = read_file_into_buffer(index_path);
+  } catch (std::system_error&) {
+    return false;
+  }
+  mem.resize(mem.size() + 1);
+  mem.data()[mem.size() - 1] = '\0';
+  const char* p = mem.data();
+  size_t header_len = std::strlen(index_header);
+  if (std::strncmp(p, index_header, header_len) != 0)
+    return false;
+  p += header_len;
+  char* endptr;
+  FileStamp st;
+  st.mtime = std::strtoll(p, &endptr, 10);
+  st.size = std::strtoull(endptr, &endptr, 10);
+  size_t count = std::strtoull(endptr, &endptr, 10);
+  if (*endptr != '\n' || st != expected)
+    return false;
+  p = endptr + 1;
+  std::unordered_map<std::string, Entry> new_blocks;
+  std::vector<std::string> new_names;
+  new_names.reserve(count);
+  new_blocks.reserve(count);
+  for (size_t i = 0; i != count; ++i) {
+    const char* name_end = p;
+    while (*name_end != ' ' && *name_end != '\0')
+      ++name_end;
+    if (*name_end != ' ' || name_end == p)
+      return false;
+    Entry entry;
+    entry.offset = std::strtoull(name_end, &endptr, 10);
+    entry.length = std::strtoull(endptr, &endptr, 10);
+    if (*endptr != '\n' || entry.offset + entry.length > st.size)
+      return false;
+    new_names.emplace_back(p, name_end);
+    new_blocks.emplace(new_names.back(), entry);
+    p = endptr + 1;
+  }
+  if (*p != '\0')
+    return false;
+  stamp = st;
+  blocks = std::move(new_blocks);
+  names = std::move(new_names);
+  return true;
+}
+
+// The index is written to a temporary file which is then renamed,
+// so that other processes never read a partially written index.
+void CifBlockIndex::save(const std::string& index_path) const {
+  std::string tmp_path = index_path + ".tmp" + std::to_string(std::random_device()());
+  {
+    fileptr_t f = file_open(tmp_path.c_str(), "wb");
+    bool ok = std::fputs(index_header, f.get()) >= 0 &&
+              std::fprintf(f.get(), "%lld %llu %zu\n", (long long) stamp.mtime,
+                           (unsigned long long) stamp.size, names.size()) > 0;
+    for (const std::string& name : names) {
+      if (!ok)
+        break;
+      const Entry& e = blocks.at(name);
+      ok = std::fprintf(f.get(), "%s %llu %llu\n", name.c_str(),
+                        (unsigned long long) e.offset, (unsigned long long) e.length) > 0;
+    }
+    if (!ok) {
+      f.reset();
+      std::remove(tmp_path.c_str());
+      sys_fail("Failed to write " + tmp_path);
+    }
+  }
+#if defined(_WIN32)
+  std::remove(index_path.c_str());
+#endif
+  if (std::rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    sys_fail("Failed to write " + index_path);
+  }
+}
+
+void IndexedCcd::open(const std::string& path, const std::string& index_path,
+                      const Logger& logger) {
+  path_ = path;
+  clear_cache();
+  std::string idx_path = index_path.empty() ? path + ".idx" : index_path;
+  FileStamp stamp;
+  if (!get_file_stamp(path, stamp))
+    sys_fail("Failed to open " + path);
+  if (index_.load(idx_path, stamp))
+    return;
+  logger.mesg("Indexing ", path, " ...");
+  index_.build(path);
+  try {
+    index_.save(idx_path);
+  } catch (std::exception& e) {
+    logger.note("index not saved: ", e.what());
+  }
+}
+
+cif::Block IndexedCcd::read_block(const std::string& name) const {
+  auto it = index_.blocks.find(name);
+  if (it == index_.blocks.end())
+    fail("block ", name, " not found in ", path_);
+  const CifBlockIndex::Entry& entry = it->second;
+  std::string buf(entry.length, '\0');
+  fileptr_t f = file_open(path_.c_str(), "rb");
+  if (!seek_to(f.get(), entry.offset) ||
+      std::fread(&buf[0], 1, buf.size(), f.get()) != buf.size())
+    sys_fail("Failed to read " + path_);
+  cif::Document doc = read_cif_from_memory(buf.data(), buf.size(), path_.c_str());
+  if (doc.blocks.size() != 1 || doc.blocks[0].name != name)
+    fail(path_ + " was modified after it was indexed, block " + name + " not found");
+  return std::move(doc.blocks[0]);
+}
+
+std::shared_ptr<const ChemComp> IndexedCcd::find(const std::string& name) {
+  auto cached = cache_.find(name);
+  if (cached != cache_.end()) {
+    lru_.splice(lru_.begin(), lru_, cached->second);
+    return cached->second->second;
+  }
+  if (!has(name))
+    return nullptr;
+  auto cc = std::make_shared<const ChemComp>(make_chemcomp_from_block(read_block(name)));
+  if (cache_capacity != 0) {
+    lru_.emplace_front(name, cc);
+    cache_[name] = lru_.begin();
+    while (lru_.size() > cache_capacity) {
+      cache_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+  return cc;
+}
+
+std::shared_ptr<const ChemComp> IndexedCcd::get(const std::string& name) {
+  std::shared_ptr<const ChemComp> cc = find(name);
+  if (!cc)
+    fail("chemical component ", name, " not found in ", path_);
+  return cc;
+}
+
+} // namespace gemmi
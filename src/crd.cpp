@@ -69,12 +69,15 @@ static std::string refmac_calc_flag(const Atom& a) {
   unreachable();
 }
 
-void add_automatic_links(Model& model, Structure& st, const MonLib& monlib) {
+void add_automatic_links(Model& model, Structure& st, const MonLib& monlib,
+                         NeighborSearchCache* ns_cache) {
   auto is_onsb = [](Element e) {
     return e == El::O || e == El::N || e == El::S || e == El::B;
   };
-  NeighborSearch ns(model, st.cell, 5.0);
-  ns.populate();
+  NeighborSearchCache local_cache(5.0);
+  if (!ns_cache)
+    ns_cache = &local_cache;
+  NeighborSearch& ns = ns_cache->get(model, st.cell);
   ContactSearch contacts(3.1f);  // 3.1 > 130% of ZN-CYS bond (2.34)
   contacts.ignore = ContactSearch::Ignore::AdjacentResidues;
   int counter = 0;
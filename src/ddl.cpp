@@ -2,8 +2,10 @@
 
 #include "gemmi/ddl.hpp"
 #include "gemmi/numb.hpp"  // for is_numb
+#include "gemmi/parallel.hpp"  // for parallel_chunks_with_logger
 #include <cmath>      // for INFINITY
 #include <algorithm>  // for find
+#include <atomic>
 #include <utility>    // for pair
 
 namespace gemmi { namespace cif {
@@ -46,6 +48,38 @@ std::string tags_as_str(const std::vector<std::string>& v) {
   return s;
 }
 
+// If re_str is a single-character pattern ([...] or .) followed by * or +,
+// returns the length of this pattern, otherwise returns 0.
+size_t single_char_pattern_length(const std::string& re_str) {
+  size_t n = re_str.size();
+  if (n < 2 || (re_str[n-1] != '*' && re_str[n-1] != '+'))
+    return 0;
+  if (re_str[0] == '.')
+    return n == 2 ? 1 : 0;
+  if (re_str[0] != '[')
+    return 0;
+  size_t pos = 1;
+  if (pos < n && re_str[pos] == '^')
+    ++pos;
+  if (pos < n && re_str[pos] == ']')  // ] right after [ or [^ is literal
+    ++pos;
+  while (pos < n && re_str[pos] != ']') {
+    if (re_str[pos] == '\\') {  // awk flavour recognizes escapes in brackets
+      pos += 2;
+    } else if (re_str[pos] == '[' && pos + 1 < n &&
+               (re_str[pos+1] == ':' || re_str[pos+1] == '.' || re_str[pos+1] == '=')) {
+      // [:alpha:], [.x.] or [=x=]
+      size_t end = re_str.find(std::string{re_str[pos+1], ']'}, pos + 2);
+      if (end == std::string::npos)
+        return 0;
+      pos = end + 2;
+    } else {
+      ++pos;
+    }
+  }
+  return pos + 2 == n ? n - 1 : 0;
+}
+
 std::string row_as_string(cif::Table::Row row) {
   return gemmi::join_str(row, '\v', [](const std::string& v) {
       return cif::is_null(v) ? std::string(1, '\0') : cif::as_string(v);
@@ -140,7 +174,7 @@ class Ddl2Rules {
 public:
   enum class Type : char { Unset, Int, Float };
 
-  Ddl2Rules(cif::Block& b, const Ddl* ddl, const std::string& tag) {
+  Ddl2Rules(cif::Block& b, const Ddl* ddl, const std::string& tag, const Logger& logger) {
     std::string item_type_code = "_item_type.code";
     std::string item_range = "_item_range.";
     std::string item_enumeration_value = "_item_enumeration.value";
@@ -159,11 +193,9 @@ public:
       } else if (type_code_ == "int") {
         type_ = Type::Int;
       } else {  // to make it faster, we don't use regex for int and float
-        auto it = ddl->regexes().find(type_code_);
-        if (it != ddl->regexes().end())
-          re_ = &it->second;
-        else
-          ddl->logger.mesg("Bad DDL2: ", tag, " has undefined type: ", type_code_);
+        re_ = ddl->find_type_matcher(type_code_);
+        if (!re_)
+          logger.mesg("Bad DDL2: ", tag, " has undefined type: ", type_code_);
       }
     }
     for (auto row : b.find(item_range, {"minimum", "maximum"}))
@@ -210,7 +242,7 @@ public:
     }
     if (!enumeration_.empty() && !validate_enumeration(value, msg))
       return false;
-    if (re_ && !std::regex_match(cif::as_string(value), *re_)) {
+    if (re_ && !re_->match(value)) {
       *msg = value + " does not match the " + type_code_ + " regex";
       return false;
     }
@@ -241,15 +273,48 @@ private:
   std::vector<std::string> enumeration_;
   std::string type_code_;
   std::vector<std::pair<double, double>> range_;
-  const std::regex* re_ = nullptr;
+  const Ddl::TypeMatcher* re_ = nullptr;
 };
 
 std::string major_ver(const std::string &s) {
   return s.substr(0, s.find('.'));
 }
 
+// Returns false and sets msg if any value in the column is invalid.
+// Stops after the first error to avoid clutter.
+template<typename Rules>
+bool validate_column(const Rules& rules, const cif::Loop& loop, size_t col,
+                     std::string* msg) {
+  const size_t ncol = loop.tags.size();
+  for (size_t j = col; j < loop.values.size(); j += ncol)
+    if (!rules.validate_value(loop.values[j], msg))
+      return false;
+  return true;
+}
+
 } // anonymous namespace
 
+bool Ddl::TypeMatcher::match(const std::string& value) const {
+  if (!simple)
+    return std::regex_match(cif::as_string(value), *re);
+  // unquoting as in cif::as_string(), but without making a copy
+  const char* begin = value.c_str();
+  const char* end = begin + value.size();
+  if (value[0] == '"' || value[0] == '\'') {
+    ++begin;
+    --end;
+  } else if (value[0] == ';' && value.size() > 2 && *(end - 2) == '\n') {
+    ++begin;
+    end -= *(end - 3) == '\r' ? 3 : 2;
+  }
+  if (begin == end)
+    return allow_empty;
+  for (const char* p = begin; p != end; ++p)
+    if (!chars[(unsigned char)*p])
+      return false;
+  return true;
+}
+
 // check if the dictionary name/version correspond to _audit_conform_dict_*
 void Ddl::check_audit_conform(const cif::Document& doc) const {
   std::string audit_conform = "_audit_conform.";
@@ -494,11 +559,26 @@ void Ddl::read_ddl2_block(cif::Block& block) {
         gemmi::replace_all(re_str, "\\\n", "");
         gemmi::replace_all(re_str, "\\\r\n", "");
         auto flag = std::regex::awk | std::regex::optimize;
-        regexes_.emplace(row.str(0), std::regex(re_str, flag));
+        auto result = regexes_.emplace(row.str(0), std::regex(re_str, flag));
+        if (!result.second)  // the first definition is used
+          continue;
+        TypeMatcher& matcher = type_matchers_[row.str(0)];
+        matcher.re = &result.first->second;
+        // The lookup table is filled using std::regex itself,
+        // so that the regex flavour doesn't need to be re-implemented.
+        if (size_t len = single_char_pattern_length(re_str)) {
+          std::regex one_char(re_str.substr(0, len), flag);
+          for (int c = 1; c < 256; ++c)
+            matcher.chars[c] = std::regex_match(std::string(1, (char)c), one_char);
+          matcher.allow_empty = (re_str.back() == '*');
+          matcher.simple = true;
+        }
       } catch (const std::regex_error& e) {
         logger.mesg("Bad DDL2: can't parse regex for '", row[0], "': ", e.what());
         // add an always-matching placeholder to avoid errors later
-        regexes_.emplace(row.str(0), std::regex(".*"));
+        auto result = regexes_.emplace(row.str(0), std::regex(".*"));
+        if (result.second)
+          type_matchers_[row.str(0)].re = &result.first->second;
       }
     }
 
@@ -577,6 +657,45 @@ bool Ddl::validate_cif(const cif::Document& doc) const {
   return ok;
 }
 
+// Columns are checked in parallel (if n_threads != 1), but the messages
+// are passed to the logger in the same order as when checked serially.
+bool Ddl::validate_loop(const cif::Item& item, const cif::Block& b,
+                        const std::string& source) const {
+  const cif::Loop& loop = item.loop;
+  std::atomic<bool> ok{true};
+  parallel_chunks_with_logger(loop.tags.size(), n_threads, logger,
+                              [&](size_t i, const Logger& log) {
+    auto err = [&](const std::string& s) {
+      ok = false;
+      log.level<3>(source, ':', item.line_number, " [", b.name, "] ", s);
+    };
+    const std::string& tag = loop.tags[i];
+    cif::Block* dict_block = find_rules(tag);
+    if (!dict_block) {
+      if (print_unknown_tags)
+        log.level<3>('[', b.name, "] unknown tag ", tag);
+      return;
+    }
+    std::string msg;
+    // validate column in loop
+    if (major_version == 1) {
+      Ddl1Rules rules(*dict_block);
+      if (rules.is_list() == Trinary::No)
+        err(tag + " in list");
+      if (!validate_column(rules, loop, i, &msg))
+        err(cat(tag, ": ", msg));
+    } else {
+      if (use_context)
+        if (const char* bad_ctx = wrong_ddl2_context(*dict_block))
+          err(tag + bad_ctx);
+      Ddl2Rules rules(*dict_block, this, tag, log);
+      if (!validate_column(rules, loop, i, &msg))
+        err(cat(tag, ": ", msg));
+    }
+  });
+  return ok;
+}
+
 bool Ddl::validate_block(const cif::Block& b, const std::string& source) const {
   bool ok = true;
   std::string msg;
@@ -604,42 +723,13 @@ bool Ddl::validate_block(const cif::Block& b, const std::string& source) const {
         if (use_context)
           if (const char* bad_ctx = wrong_ddl2_context(*dict_block))
             err(item, tag + bad_ctx);
-        Ddl2Rules rules(*dict_block, this, tag);
+        Ddl2Rules rules(*dict_block, this, tag, logger);
         if (!rules.validate_value(item.pair[1], &msg))
           err(item, msg);
       }
     } else if (item.type == cif::ItemType::Loop) {
-      const size_t ncol = item.loop.tags.size();
-      for (size_t i = 0; i != ncol; i++) {
-        const std::string& tag = item.loop.tags[i];
-        cif::Block* dict_block = find_rules(tag);
-        if (!dict_block) {
-          if (print_unknown_tags)
-            warn(b, "unknown tag ", tag);
-          continue;
-        }
-        // validate column in loop
-        if (major_version == 1) {
-          Ddl1Rules rules(*dict_block);
-          if (rules.is_list() == Trinary::No)
-            err(item, tag + " in list");
-          for (size_t j = i; j < item.loop.values.size(); j += ncol)
-            if (!rules.validate_value(item.loop.values[j], &msg)) {
-              err(item, cat(tag, ": ", msg));
-              break; // stop after first error to avoid clutter
-            }
-        } else {
-          if (use_context)
-            if (const char* bad_ctx = wrong_ddl2_context(*dict_block))
-              err(item, tag + bad_ctx);
-          Ddl2Rules rules(*dict_block, this, tag);
-          for (size_t j = i; j < item.loop.values.size(); j += ncol)
-            if (!rules.validate_value(item.loop.values[j], &msg)) {
-              err(item, cat(tag, ": ", msg));
-              break; // stop after first error to avoid clutter
-            }
-        }
-      }
+      if (!validate_loop(item, b, source))
+        ok = false;
     } else if (item.type == cif::ItemType::Frame) {
       validate_block(item.frame, source);
     }
@@ -0,0 +1,48 @@
+// Copyright 2026 Global Phasing Ltd.
+
+#include <gemmi/fileutil.hpp>
+#if !defined(_WIN32)
+# include <sys/stat.h>  // for fstat
+# include <fcntl.h>     // for open
+# include <sys/mman.h>  // for mmap
+# include <unistd.h>    // for close
+#endif
+
+namespace gemmi {
+
+void MappedFile::open(const std::string& path) {
+  close();
+#if defined(_WIN32)
+  buffer_ = read_file_into_buffer(path);
+  data_ = (const unsigned char*) buffer_.data();
+  size_ = buffer_.size();
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    sys_fail("Failed to open " + path);
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    sys_fail("Failed to read " + path);
+  }
+  void* ptr = ::mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (ptr == MAP_FAILED)
+    sys_fail("Failed to mmap " + path);
+  data_ = (const unsigned char*) ptr;
+  size_ = (size_t) st.st_size;
+#endif
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+  buffer_ = CharArray();
+#else
+  if (data_)
+    ::munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+  data_ = nullptr;
+  size_ = 0;
+}
+
+} // namespace gemmi
@@ -4,6 +4,7 @@
 #include <gemmi/atof.hpp>       // for fast_from_chars
 #include <gemmi/binner.hpp>     // for Binner
 #include <gemmi/mtz.hpp>        // for Mtz
+#include <gemmi/reciproc.hpp>   // for ReflnProperties
 #include <gemmi/refln.hpp>      // for ReflnBlock
 #include <gemmi/xds_ascii.hpp>  // for XdsAscii
 
@@ -286,23 +287,34 @@ double MergingStats::cc_half() const {
 void Intensities::switch_to_asu_indices() {
   if (!spacegroup)
     return;
-  GroupOps gops = spacegroup->operations();
   if (isym_ops.empty())
-    isym_ops = gops.sym_ops;
+    isym_ops = spacegroup->operations().sym_ops;
   ReciprocalAsu asu(spacegroup);
+  std::vector<Refl*> outside;
+  std::vector<Miller> hkls;
   for (Refl& refl : data) {
     if (asu.is_in(refl.hkl)) {
       if (refl.isym == 0)
         refl.isym = 1;
     } else {
       assert(refl.isym == 0);
-      std::tie(refl.hkl, refl.isym) = asu.to_asu(refl.hkl, isym_ops);
-      if (type == DataType::Anomalous && refl.isym % 2 == 0) {
-        if (refl.isign == 1 && gops.is_reflection_centric(refl.hkl)) {
-          // leave it as 1
-        } else {
-          refl.isign = -refl.isign;
-        }
+      outside.push_back(&refl);
+      hkls.push_back(refl.hkl);
+    }
+  }
+  if (outside.empty())
+    return;
+  ReflnProperties props;
+  props.calculate(hkls, unit_cell, spacegroup, 1, &isym_ops);
+  for (size_t i = 0; i != outside.size(); ++i) {
+    Refl& refl = *outside[i];
+    refl.hkl = props.asu_hkl[i];
+    refl.isym = (int8_t) props.isym[i];
+    if (type == DataType::Anomalous && refl.isym % 2 == 0) {
+      if (refl.isign == 1 && props.centric[i]) {
+        // leave it as 1
+      } else {
+        refl.isign = -refl.isign;
       }
     }
   }
@@ -1,6 +1,11 @@
 // Copyright Global Phasing Ltd.
 
 #include <gemmi/json.hpp>
+#include <gemmi/mmcif.hpp>    // for make_structure_from_mmjson_insitu
+#include <gemmi/profile.hpp>  // for GEMMI_PROFILE_SCOPE
+#include <algorithm>  // for count
+#include <cstring>    // for memmove
+#include <deque>
 #include <utility>  // for move
 
 #define SAJSON_UNSORTED_OBJECT_KEYS
@@ -49,7 +54,7 @@ static std::string as_cif_value(const sajson::value& val) {
       for (size_t i = 0; i < val.get_length(); ++i) {
         if (i != 0)
           s += ' ';
-        s += val.get_array_element(0).as_string();
+        s += val.get_array_element(i).as_string();
       }
       return quote(s);
     }
@@ -111,6 +116,7 @@ static void fill_document_from_sajson(Document& d, const sajson::document& s) {
 }
 
 Document read_mmjson_insitu(char* buffer, size_t size, const std::string& name) {
+  GEMMI_PROFILE_SCOPE("json.parse");
   Document doc;
   sajson::document json = sajson::parse(sajson::dynamic_allocation(),
                                     sajson::mutable_string_view(size, buffer));
@@ -122,7 +128,333 @@ Document read_mmjson_insitu(char* buffer, size_t size, const std::string& name)
   return doc;
 }
 
+namespace {
 
+// Streaming (pull) parser for mmJSON. It doesn't build DOM, values are
+// consumed as they are read. Like sajson, it works in-situ: strings are
+// unescaped in the buffer, and strings and numbers are NUL-terminated.
+class MmjsonReader {
+public:
+  MmjsonReader(char* buffer, size_t size, const std::string& name)
+    : begin_(buffer), p_(buffer), end_(buffer + size), name_(name) {}
+
+  // values that are not in the buffer (arrays converted to strings)
+  std::deque<std::string> string_pool;
+
+  // Reads all blocks into doc, except that _atom_site from the first block
+  // is stored by columns in atom_site.
+  void read(Document& doc, impl::ColumnTable& atom_site) {
+    if (peek() != '{')
+      fail("not mmJSON - the root is not of type object");
+    ++p_;
+    for (bool first = true; !consume_end('}', first); first = false) {
+      std::string block_name = read_key();
+      if (!starts_with(block_name, "data_"))
+        fail("not mmJSON - top level key should start with data_\n"
+             "(if you use gemmi-cif2json to write JSON, use -m for mmJSON)");
+      doc.blocks.emplace_back(block_name.substr(5));
+      expect('{');
+      for (bool first_cat = true; !consume_end('}', first_cat); first_cat = false) {
+        std::string category = read_key();
+        if (doc.blocks.size() == 1 && category == "atom_site")
+          read_columns(atom_site);
+        else
+          read_category(category, doc.blocks.back().items);
+      }
+    }
+    if (peek() != '\0')
+      error("unexpected data after the root object");
+  }
+
+private:
+  char* begin_;
+  char* p_;
+  char* end_;
+  const std::string& name_;
+
+  [[noreturn]] void error(const std::string& msg) const {
+    fail(name_ + ":" + std::to_string(1 + std::count(begin_, p_, '\n')) + " error: " + msg);
+  }
+
+  // skips whitespace, returns the next character or '\0' at the end
+  char peek() {
+    while (p_ != end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t'))
+      ++p_;
+    return p_ != end_ ? *p_ : '\0';
+  }
+
+  void expect(char c) {
+    if (peek() != c)
+      error(std::string("expected '") + c + "'");
+    ++p_;
+  }
+
+  // in object or array: returns true after closing bracket, consumes comma
+  bool consume_end(char close, bool first) {
+    char c = peek();
+    if (c == close) {
+      ++p_;
+      return true;
+    }
+    if (!first) {
+      if (c != ',')
+        error(std::string("expected ',' or '") + close + "'");
+      ++p_;
+    }
+    return false;
+  }
+
+  std::string read_key() {
+    if (peek() != '"')
+      error("expected string as object key");
+    std::string key = read_string();
+    expect(':');
+    return key;
+  }
+
+  static void append_utf8(char*& out, unsigned cp) {
+    if (cp < 0x80) {
+      *out++ = (char) cp;
+    } else if (cp < 0x800) {
+      *out++ = (char) (0xC0 | (cp >> 6));
+      *out++ = (char) (0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+      *out++ = (char) (0xE0 | (cp >> 12));
+      *out++ = (char) (0x80 | ((cp >> 6) & 0x3F));
+      *out++ = (char) (0x80 | (cp & 0x3F));
+    } else {
+      *out++ = (char) (0xF0 | (cp >> 18));
+      *out++ = (char) (0x80 | ((cp >> 12) & 0x3F));
+      *out++ = (char) (0x80 | ((cp >> 6) & 0x3F));
+      *out++ = (char) (0x80 | (cp & 0x3F));
+    }
+  }
+
+  unsigned read_hex4() {
+    if (end_ - p_ < 4)
+      error("unexpected end of \\u escape");
+    unsigned cp = 0;
+    for (int i = 0; i < 4; ++i) {
+      char c = *p_++;
+      cp <<= 4;
+      if (c >= '0' && c <= '9')
+        cp |= unsigned(c - '0');
+      else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+        cp |= unsigned((c | 0x20) - 'a' + 10);
+      else
+        error("invalid \\u escape");
+    }
+    return cp;
+  }
+
+  // p_ points to the opening quote; returns unescaped NUL-terminated string
+  char* read_string() {
+    char* start = ++p_;
+    // fast path - nothing to unescape
+    while (p_ != end_ && *p_ != '"' && *p_ != '\\')
+      ++p_;
+    char* out = p_;
+    for (;;) {
+      if (p_ == end_)
+        error("unterminated string");
+      char c = *p_++;
+      if (c == '"')
+        break;
+      if (c != '\\') {
+        *out++ = c;
+        continue;
+      }
+      if (p_ == end_)
+        error("unterminated string");
+      switch (*p_++) {
+        case '"': *out++ = '"'; break;
+        case '\\': *out++ = '\\'; break;
+        case '/': *out++ = '/'; break;
+        case 'b': *out++ = '\b'; break;
+        case 'f': *out++ = '\f'; break;
+        case 'n': *out++ = '\n'; break;
+        case 'r': *out++ = '\r'; break;
+        case 't': *out++ = '\t'; break;
+        case 'u': {
+          unsigned cp = read_hex4();
+          if (cp >= 0xD800 && cp < 0xDC00 && end_ - p_ >= 6 &&
+              p_[0] == '\\' && p_[1] == 'u') {
+            p_ += 2;
+            unsigned low = read_hex4();
+            if (low < 0xDC00 || low >= 0xE000)
+              error("invalid surrogate pair");
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+          }
+          append_utf8(out, cp);
+          break;
+        }
+        default:
+          error("invalid escape sequence");
+      }
+    }
+    *out = '\0';
+    return start;
+  }
+
+  // The number is moved one byte to the left (over the already consumed
+  // separator) to make space for NUL.
+  char* read_number() {
+    char* start = p_;
+    while (p_ != end_ && (is_digit(*p_) || *p_ == '-' || *p_ == '+' ||
+                          *p_ == '.' || *p_ == 'e' || *p_ == 'E'))
+      ++p_;
+    std::memmove(start - 1, start, p_ - start);
+    *(p_ - 1) = '\0';
+    return start - 1;
+  }
+
+  void expect_word(const char* word) {
+    size_t len = std::strlen(word);
+    if (size_t(end_ - p_) < len || std::strncmp(p_, word, len) != 0)
+      error("unexpected value");
+    p_ += len;
+  }
+
+  // Reads scalar value. Null is returned as nullptr, booleans as YES|NO
+  // (see as_cif_value() above). Sets quotable if the value is a string.
+  const char* read_scalar(bool& quotable) {
+    quotable = false;
+    char c = peek();
+    if (c == '"') {
+      quotable = true;
+      return read_string();
+    }
+    if (c == '-' || is_digit(c))
+      return read_number();
+    if (c == 'n') {
+      expect_word("null");
+      return nullptr;
+    }
+    if (c == 't') {
+      expect_word("true");
+      return "YES";
+    }
+    if (c == 'f') {
+      expect_word("false");
+      return "NO";
+    }
+    if (c == '{')
+      error("unexpected <object> as value in JSON");
+    error("unexpected value");
+  }
+
+  // Reads value in an array of values. Arrays in this place are
+  // converted to a string, as in as_cif_value().
+  const char* read_value(bool& quotable) {
+    if (peek() != '[')
+      return read_scalar(quotable);
+    ++p_;
+    std::string s;
+    for (bool first = true; !consume_end(']', first); first = false) {
+      bool q;
+      const char* v = read_scalar(q);
+      if (!first)
+        s += ' ';
+      s += v ? v : "?";
+    }
+    quotable = true;
+    string_pool.push_back(std::move(s));
+    return string_pool.back().c_str();
+  }
+
+  // calls func(tag, value, quotable) for each value of each column in category
+  template<typename Func>
+  void read_category_columns(const std::string& category, Func func) {
+    expect('{');
+    size_t n_rows = 0;
+    bool first_col = true;
+    for (; !consume_end('}', first_col); first_col = false) {
+      std::string tag = read_key();
+      if (peek() != '[')
+        error("expected array in _" + category + "." + tag);
+      ++p_;
+      size_t n = 0;
+      for (; !consume_end(']', n == 0); ++n) {
+        bool quotable;
+        const char* value = read_value(quotable);
+        func(tag, n, value, quotable);
+      }
+      if (first_col)
+        n_rows = n;
+      else if (n != n_rows)
+        fail("Expected array of length ", std::to_string(n_rows), " not ",
+             std::to_string(n));
+    }
+    if (first_col)
+      error("empty category " + category);
+  }
+
+  void read_category(const std::string& category, std::vector<Item>& items) {
+    std::string prefix = "_" + category + ".";
+    std::vector<std::string> tags;
+    std::vector<std::vector<std::string>> columns;
+    read_category_columns(category, [&](const std::string& tag, size_t n,
+                                        const char* value, bool quotable) {
+      if (n == 0) {
+        tags.emplace_back(prefix + tag);
+        columns.emplace_back();
+      }
+      if (!value)
+        columns.back().emplace_back(1, '?');
+      else if (quotable)
+        columns.back().emplace_back(quote(value));
+      else
+        columns.back().emplace_back(value);
+    });
+    size_t n_rows = columns.empty() ? 0 : columns[0].size();
+    if (n_rows == 1) {
+      for (size_t j = 0; j != tags.size(); ++j)
+        items.emplace_back(tags[j], std::move(columns[j][0]));
+    } else if (n_rows > 1) {
+      items.emplace_back(LoopArg{});
+      Loop& loop = items.back().loop;
+      loop.tags = std::move(tags);
+      loop.values.resize(loop.tags.size() * n_rows);
+      for (size_t j = 0; j != loop.tags.size(); ++j)
+        for (size_t k = 0; k != n_rows; ++k)
+          loop.values[j + k * loop.tags.size()] = std::move(columns[j][k]);
+    }
+  }
+
+  void read_columns(impl::ColumnTable& table) {
+    read_category_columns("atom_site", [&](const std::string& tag, size_t n,
+                                           const char* value, bool) {
+      if (n == 0) {
+        table.tags.push_back(tag);
+        table.columns.emplace_back();
+        if (table.columns.size() > 1)
+          table.columns.back().reserve(table.columns[0].size());
+      }
+      table.columns.back().push_back(value);
+    });
+  }
+};
+
+} // anonymous namespace
 
 } // namespace cif
+
+Structure make_structure_from_mmjson_insitu(char* buffer, size_t size,
+                                            const std::string& name) {
+  GEMMI_PROFILE_SCOPE("mmjson.make_structure");
+  cif::Document doc;
+  impl::ColumnTable atom_site;
+  cif::MmjsonReader reader(buffer, size, name);
+  reader.read(doc, atom_site);
+  doc.source = name;
+  // the same check as in make_structure()
+  for (size_t i = 1; i < doc.blocks.size(); ++i)
+    if (doc.blocks[i].has_tag("_atom_site.id"))
+      fail("2+ blocks are ok if only the first one has coordinates;\n"
+           "_atom_site in block #" + std::to_string(i+1) + ": " + doc.source);
+  Structure st = impl::make_structure_from_block_and_columns(doc.blocks.at(0), atom_site);
+  st.input_format = CoorFormat::Mmjson;
+  return st;
+}
+
 } // namespace gemmi
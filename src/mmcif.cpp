@@ -2,12 +2,15 @@
 
 #include <gemmi/mmcif.hpp>   // for string_to_int
 #include <array>
+#include <algorithm>  // for find
+#include <cstring>    // for strlen, strcmp
 #include <unordered_map>
 #include <gemmi/mmcif_impl.hpp> // for set_cell_from_mmcif
 #include <gemmi/atox.hpp>    // for string_to_int
 #include <gemmi/enumstr.hpp> // for entity_type_from_string, polymer_type_from_string
 #include <gemmi/numb.hpp>    // for as_number
 #include <gemmi/polyheur.hpp>  // for restore_full_ccd_codes
+#include <gemmi/profile.hpp>   // for GEMMI_PROFILE_SCOPE
 
 namespace gemmi {
 
@@ -62,11 +65,9 @@ Transform get_transform_matrix(const cif::Table::Row& r) {
   return t;
 }
 
-SeqId make_seqid(std::string seqid, const std::string* icode) {
+SeqId make_seqid(std::string seqid, char icode) {
   SeqId ret;
-  if (icode)
-    // the insertion code happens to be always a single letter
-    ret.icode = cif::as_char(*icode, ' ');
+  ret.icode = icode;
   if (!seqid.empty()) {
     // old mmCIF files have auth_seq_id as number + icode (e.g. 15A)
     if (seqid.back() >= 'A') {
@@ -83,6 +84,11 @@ SeqId make_seqid(std::string seqid, const std::string* icode) {
   return ret;
 }
 
+SeqId make_seqid(std::string seqid, const std::string* icode) {
+  // the insertion code happens to be always a single letter
+  return make_seqid(std::move(seqid), icode ? cif::as_char(*icode, ' ') : ' ');
+}
+
 inline ResidueId make_resid(const std::string& name,
                             const std::string& seqid,
                             const std::string* icode) {
@@ -779,146 +785,251 @@ void read_ncs_info(cif::Block& block, Structure& st) {
     }
 }
 
-void read_atom_sites(cif::Block& block, Structure& st) {
-    auto aniso_map = get_anisotropic_u(block);
+// _atom_site tags; optional tags start with '?'
+enum { kId=0, kGroupPdb, kSymbol, kLabelAtomId, kAltId, kLabelCompId,
+       kLabelAsymId, kLabelEntityId, kLabelSeqId, kInsCode,
+       kX, kY, kZ, kOcc, kBiso, kCharge,
+       kAuthSeqId, kAuthCompId, kAuthAsymId, kAuthAtomId, kModelNum,
+       kCalcFlag, kTlsGroupId, kDeuterium };
+const char* const atom_site_tags[] = {"id",
+                                      "?group_PDB",
+                                      "type_symbol",
+                                      "?label_atom_id",
+                                      "label_alt_id",
+                                      "?label_comp_id",
+                                      "label_asym_id",
+                                      "?label_entity_id",
+                                      "?label_seq_id",
+                                      "?pdbx_PDB_ins_code",
+                                      "Cartn_x",
+                                      "Cartn_y",
+                                      "Cartn_z",
+                                      "?occupancy",
+                                      "?B_iso_or_equiv",
+                                      "?pdbx_formal_charge",
+                                      "?auth_seq_id",
+                                      "?auth_comp_id",
+                                      "?auth_asym_id",
+                                      "?auth_atom_id",
+                                      "?pdbx_PDB_model_num",
+                                      "?calc_flag",
+                                      "?pdbx_tls_group_id",
+                                      "?ccp4_deuterium_fraction",
+                                     };
+constexpr int atom_site_tag_count = sizeof(atom_site_tags) / sizeof(atom_site_tags[0]);
 
-    // atom list
-    enum { kId=0, kGroupPdb, kSymbol, kLabelAtomId, kAltId, kLabelCompId,
-           kLabelAsymId, kLabelEntityId, kLabelSeqId, kInsCode,
-           kX, kY, kZ, kOcc, kBiso, kCharge,
-           kAuthSeqId, kAuthCompId, kAuthAsymId, kAuthAtomId, kModelNum,
-           kCalcFlag, kTlsGroupId, kDeuterium };
-    cif::Table atom_table = block.find("_atom_site.",
-                                       {"id",
-                                        "?group_PDB",
-                                        "type_symbol",
-                                        "?label_atom_id",
-                                        "label_alt_id",
-                                        "?label_comp_id",
-                                        "label_asym_id",
-                                        "?label_entity_id",
-                                        "?label_seq_id",
-                                        "?pdbx_PDB_ins_code",
-                                        "Cartn_x",
-                                        "Cartn_y",
-                                        "Cartn_z",
-                                        "?occupancy",
-                                        "?B_iso_or_equiv",
-                                        "?pdbx_formal_charge",
-                                        "?auth_seq_id",
-                                        "?auth_comp_id",
-                                        "?auth_asym_id",
-                                        "?auth_atom_id",
-                                        "?pdbx_PDB_model_num",
-                                        "?calc_flag",
-                                        "?pdbx_tls_group_id",
-                                        "?ccp4_deuterium_fraction",
-                                       });
-    if (atom_table.length() != 0) {
-        RowAccess asym_id(atom_table, kAuthAsymId, kLabelAsymId);
-        // we use only one comp (residue) and one atom name
-        RowAccess comp_id(atom_table, kAuthCompId, kLabelCompId);
-        RowAccess atom_id(atom_table, kAuthAtomId, kLabelAtomId);
-        RowAccess seq_id(atom_table, kAuthSeqId, kLabelSeqId);
-        if (!asym_id.ok())
-            fail("Neither _atom_site.label_asym_id nor auth_asym_id found");
-        if (!comp_id.ok())
-            fail("Neither _atom_site.label_comp_id nor auth_comp_id found");
-        if (!atom_id.ok())
-            fail("Neither _atom_site.label_atom_id nor auth_atom_id found");
-        if (!seq_id.ok())
-            fail("Neither _atom_site.label_seq_id nor auth_seq_id found");
-        size_t loop_width = 0;
-        if (const cif::Loop* loop = atom_table.get_loop())
-            loop_width = loop->width();
-
-        st.has_d_fraction = atom_table.has_column(kDeuterium);
-
-        Model *model = nullptr;
-        Chain *chain = nullptr;
-        Residue *resi = nullptr;
-        std::string model_num;
-        if (!atom_table.has_column(kModelNum)) {
-            st.models.emplace_back(1);
-            model = &st.models[0];
+// Access to _atom_site values in cif::Table (mmCIF).
+struct CifAtomRows {
+  std::vector<const std::string*> cols;  // nullptr for absent tags
+  size_t stride = 0;
+  size_t n = 0;
+
+  explicit CifAtomRows(cif::Table& tab) : cols(tab.positions.size(), nullptr) {
+    n = tab.length();
+    const cif::Loop* loop = tab.get_loop();
+    if (loop)
+      stride = loop->width();
+    for (size_t k = 0; k < cols.size(); ++k) {
+      int pos = tab.positions[k];
+      if (pos >= 0)
+        cols[k] = loop ? &loop->values[pos] : &tab.bloc.items[pos].pair[1];
+    }
+  }
+  size_t length() const { return n; }
+  bool has_column(int k) const { return cols[k] != nullptr; }
+  const std::string& raw(size_t i, int k) const { return cols[k][i * stride]; }
+  const char* c_str(size_t i, int k) const { return raw(i, k).c_str(); }
+  bool has2(size_t i, int k) const { return cols[k] && !cif::is_null(raw(i, k)); }
+  std::string str(size_t i, int k) const { return cif::as_string(raw(i, k)); }
+  double num(size_t i, int k, double null=NAN) const {
+    return cif::as_number(raw(i, k), null);
+  }
+  int integer(size_t i, int k) const { return cif::as_int(raw(i, k)); }
+  char chr(size_t i, int k, char null) const { return cif::as_char(raw(i, k), null); }
+};
+
+// Access to _atom_site values in impl::ColumnTable (mmJSON).
+struct ColumnAtomRows {
+  std::vector<const std::vector<const char*>*> cols;  // nullptr for absent tags
+  size_t n = 0;
+
+  explicit ColumnAtomRows(const impl::ColumnTable& tab)
+      : cols(atom_site_tag_count, nullptr) {
+    for (int k = 0; k < atom_site_tag_count; ++k) {
+      const char* tag = atom_site_tags[k];
+      bool optional = tag[0] == '?';
+      auto it = std::find(tab.tags.begin(), tab.tags.end(), tag + int(optional));
+      if (it != tab.tags.end())
+        cols[k] = &tab.columns[it - tab.tags.begin()];
+      else if (!optional)
+        return;  // like cif::Table with missing required tag - no atoms
+    }
+    n = cols[0]->size();
+  }
+  size_t length() const { return n; }
+  bool has_column(int k) const { return cols[k] != nullptr; }
+  const char* c_str(size_t i, int k) const {
+    const char* v = (*cols[k])[i];
+    return v ? v : "?";
+  }
+  std::string raw(size_t i, int k) const { return c_str(i, k); }
+  bool has2(size_t i, int k) const { return cols[k] && (*cols[k])[i]; }
+  std::string str(size_t i, int k) const {
+    const char* v = (*cols[k])[i];
+    return v ? v : "";
+  }
+  double num(size_t i, int k, double null=NAN) const {
+    const char* v = (*cols[k])[i];
+    return v ? cif::as_number(v, v + std::strlen(v), null) : null;
+  }
+  int integer(size_t i, int k) const { return string_to_int(c_str(i, k), true); }
+  char chr(size_t i, int k, char null) const {
+    const char* v = (*cols[k])[i];
+    if (!v)
+      return null;
+    if (v[0] == '\0' || v[1] == '\0')
+      return v[0];
+    fail("Not a single character: " + cif::quote(v));
+  }
+};
+
+using AnisoMap = std::unordered_map<std::string, SMat33<float>>;
+
+template<typename Rows>
+void read_atom_rows(const Rows& rows, const AnisoMap& aniso_map, Structure& st) {
+    // we use only one comp (residue) and one atom name
+    auto auth_or_label = [&](size_t i, int auth, int label) {
+        bool use_auth = rows.has_column(auth) &&
+                        (rows.has2(i, auth) || !rows.has_column(label));
+        return rows.str(i, use_auth ? auth : label);
+    };
+    if (!rows.has_column(kAuthAsymId) && !rows.has_column(kLabelAsymId))
+        fail("Neither _atom_site.label_asym_id nor auth_asym_id found");
+    if (!rows.has_column(kAuthCompId) && !rows.has_column(kLabelCompId))
+        fail("Neither _atom_site.label_comp_id nor auth_comp_id found");
+    if (!rows.has_column(kAuthAtomId) && !rows.has_column(kLabelAtomId))
+        fail("Neither _atom_site.label_atom_id nor auth_atom_id found");
+    if (!rows.has_column(kAuthSeqId) && !rows.has_column(kLabelSeqId))
+        fail("Neither _atom_site.label_seq_id nor auth_seq_id found");
+
+    st.has_d_fraction = rows.has_column(kDeuterium);
+
+    // Number of consecutive rows, starting from i, in the same residue.
+    // Used only to allocate Residue::atoms once, with the right capacity.
+    auto count_residue_rows = [&](size_t i) {
+        static const int keys[] = {kModelNum, kAuthAsymId, kLabelAsymId, kAuthSeqId,
+                                   kLabelSeqId, kInsCode, kAuthCompId, kLabelCompId};
+        size_t j = i + 1;
+        for (; j < rows.length(); ++j)
+            for (int k : keys)
+                if (rows.has_column(k) &&
+                    std::strcmp(rows.c_str(i, k), rows.c_str(j, k)) != 0)
+                    return j - i;
+        return j - i;
+    };
+
+    Model *model = nullptr;
+    Chain *chain = nullptr;
+    Residue *resi = nullptr;
+    std::string model_num;
+    if (!rows.has_column(kModelNum)) {
+        st.models.emplace_back(1);
+        model = &st.models[0];
+    }
+    for (size_t i = 0; i != rows.length(); ++i) {
+        if (rows.has_column(kModelNum) && model_num != rows.c_str(i, kModelNum)) {
+            model_num = rows.c_str(i, kModelNum);
+            model = &st.find_or_add_model(cif::as_int(model_num, 0));
+            chain = nullptr;
         }
-        for (auto row : atom_table) {
-            size_t gap = row.row_index * loop_width;
-            if (row.has(kModelNum) && row[kModelNum] != model_num) {
-                model_num = row[kModelNum];
-                model = &st.find_or_add_model(cif::as_int(model_num, 0));
-                chain = nullptr;
-            }
-            if (!chain || cif::as_string(asym_id.get(gap)) != chain->name) {
-                model->chains.emplace_back(cif::as_string(asym_id.get(gap)));
-                chain = &model->chains.back();
-                resi = nullptr;
-            }
-            ResidueId rid = make_resid(cif::as_string(comp_id.get(gap)),
-                                       cif::as_string(seq_id.get(gap)),
-                                       row.has(kInsCode) ? &row[kInsCode] : nullptr);
-            if (!resi || !resi->matches(rid)) {
-                resi = chain->find_or_add_residue(rid);
-                if (resi->atoms.empty()) {
-                    if (row.has2(kLabelSeqId))
-                        resi->label_seq = cif::as_int(row[kLabelSeqId]);
-                    resi->subchain = row.str(kLabelAsymId);
-                    if (row.has2(kLabelEntityId))
-                        resi->entity_id = row.str(kLabelEntityId);
-                    // don't check if group_PDB is consistent, it's not that important
-                    if (row.has2(kGroupPdb))
-                        for (int i = 0; i < 2; ++i) { // first character could be " or '
-                            const char c = alpha_up(row[kGroupPdb][i]);
-                            if (c == 'A' || c == 'H' || c == '\0')
-                                resi->het_flag = c;
-                        }
-                }
-            } else if (resi->seqid != rid.seqid) {
-                fail("Inconsistent sequence ID: " + resi->str() + " / " + rid.str());
-            }
-            Atom atom;
-            atom.name = cif::as_string(atom_id.get(gap));
-            // altloc is always a single letter (not guaranteed by the mmCIF spec)
-            atom.altloc = cif::as_char(row[kAltId], '\0');
-            atom.charge = row.has2(kCharge) ? cif::as_int(row[kCharge]) : 0;
-            atom.element = gemmi::Element(cif::as_string(row[kSymbol]));
-            // According to the PDBx/mmCIF spec _atom_site.id can be a string,
-            // but in all the files it is a serial number; its value is not essential,
-            // so we just ignore non-integer ids.
-            atom.serial = string_to_int(row[kId], false);
-            if (st.has_d_fraction)
-                atom.fraction = (float) cif::as_number(row[kDeuterium], 0.);
-            if (row.has2(kCalcFlag)) {
-                const std::string& cf = row[kCalcFlag];
-                if (cf[0] == 'c')
-                    atom.calc_flag = CalcFlag::Calculated;
-                if (cf[0] == 'd')
-                    atom.calc_flag = cf[1] == 'u' ? CalcFlag::Dummy
-                                                  : CalcFlag::Determined;
-            }
-            if (row.has2(kTlsGroupId)) {
-                const char* str = row[kTlsGroupId].c_str();
-                const char* endptr;
-                int tls_id = no_sign_atoi(str, &endptr);
-                if (endptr != str)
-                    atom.tls_group_id = (short) tls_id;
-            }
-            atom.pos.x = cif::as_number(row[kX]);
-            atom.pos.y = cif::as_number(row[kY]);
-            atom.pos.z = cif::as_number(row[kZ]);
-            if (row.has2(kOcc))
-                atom.occ = (float) cif::as_number(row[kOcc]);
-            if (row.has2(kBiso))
-                atom.b_iso = (float) cif::as_number(row[kBiso]);
-
-            if (!aniso_map.empty()) {
-                auto ani = aniso_map.find(row[kId]);
-                if (ani != aniso_map.end())
-                    atom.aniso = ani->second;
+        std::string asym_id = auth_or_label(i, kAuthAsymId, kLabelAsymId);
+        if (!chain || asym_id != chain->name) {
+            model->chains.emplace_back(asym_id);
+            chain = &model->chains.back();
+            resi = nullptr;
+        }
+        std::string comp_id = auth_or_label(i, kAuthCompId, kLabelCompId);
+        char icode = rows.has_column(kInsCode) ? rows.chr(i, kInsCode, ' ') : ' ';
+        ResidueId rid{make_seqid(auth_or_label(i, kAuthSeqId, kLabelSeqId), icode),
+                      {}, comp_id};
+        if (!resi || !resi->matches(rid)) {
+            resi = chain->find_or_add_residue(rid);
+            if (resi->atoms.empty()) {
+                resi->atoms.reserve(count_residue_rows(i));
+                if (rows.has2(i, kLabelSeqId))
+                    resi->label_seq = rows.integer(i, kLabelSeqId);
+                resi->subchain = rows.str(i, kLabelAsymId);
+                if (rows.has2(i, kLabelEntityId))
+                    resi->entity_id = rows.str(i, kLabelEntityId);
+                // don't check if group_PDB is consistent, it's not that important
+                if (rows.has2(i, kGroupPdb))
+                    for (int j = 0; j < 2; ++j) { // first character could be " or '
+                        const char c = alpha_up(rows.c_str(i, kGroupPdb)[j]);
+                        if (c == 'A' || c == 'H' || c == '\0')
+                            resi->het_flag = c;
+                    }
             }
-            resi->atoms.emplace_back(atom);
+        } else if (resi->seqid != rid.seqid) {
+            fail("Inconsistent sequence ID: " + resi->str() + " / " + rid.str());
+        }
+        Atom atom;
+        atom.name = auth_or_label(i, kAuthAtomId, kLabelAtomId);
+        // altloc is always a single letter (not guaranteed by the mmCIF spec)
+        atom.altloc = rows.chr(i, kAltId, '\0');
+        atom.charge = rows.has2(i, kCharge) ? rows.integer(i, kCharge) : 0;
+        atom.element = gemmi::Element(rows.str(i, kSymbol));
+        // According to the PDBx/mmCIF spec _atom_site.id can be a string,
+        // but in all the files it is a serial number; its value is not essential,
+        // so we just ignore non-integer ids.
+        atom.serial = string_to_int(rows.c_str(i, kId), false);
+        if (st.has_d_fraction)
+            atom.fraction = (float) rows.num(i, kDeuterium, 0.);
+        if (rows.has2(i, kCalcFlag)) {
+            const char* cf = rows.c_str(i, kCalcFlag);
+            if (cf[0] == 'c')
+                atom.calc_flag = CalcFlag::Calculated;
+            if (cf[0] == 'd')
+                atom.calc_flag = cf[1] == 'u' ? CalcFlag::Dummy
+                                              : CalcFlag::Determined;
+        }
+        if (rows.has2(i, kTlsGroupId)) {
+            const char* str = rows.c_str(i, kTlsGroupId);
+            const char* endptr;
+            int tls_id = no_sign_atoi(str, &endptr);
+            if (endptr != str)
+                atom.tls_group_id = (short) tls_id;
         }
+        atom.pos.x = rows.num(i, kX);
+        atom.pos.y = rows.num(i, kY);
+        atom.pos.z = rows.num(i, kZ);
+        if (rows.has2(i, kOcc))
+            atom.occ = (float) rows.num(i, kOcc);
+        if (rows.has2(i, kBiso))
+            atom.b_iso = (float) rows.num(i, kBiso);
+
+        if (!aniso_map.empty()) {
+            auto ani = aniso_map.find(rows.raw(i, kId));
+            if (ani != aniso_map.end())
+                atom.aniso = ani->second;
+        }
+        resi->atoms.emplace_back(atom);
+    }
+}
+
+// atom_site is nullptr when reading mmCIF and non-null for mmJSON
+void read_atom_sites(cif::Block& block, const impl::ColumnTable* atom_site,
+                     Structure& st) {
+    auto aniso_map = get_anisotropic_u(block);
+    if (atom_site) {
+        ColumnAtomRows rows(*atom_site);
+        if (rows.length() != 0)
+            read_atom_rows(rows, aniso_map, st);
+        return;
     }
+    cif::Table atom_table = block.find("_atom_site.",
+            std::vector<std::string>(atom_site_tags, atom_site_tags + atom_site_tag_count));
+    if (atom_table.length() != 0)
+        read_atom_rows(CifAtomRows(atom_table), aniso_map, st);
 }
 
 void read_entity_and_sequence_info(cif::Block& block, Structure& st) {
@@ -1010,10 +1121,9 @@ void read_entity_and_sequence_info(cif::Block& block, Structure& st) {
     }
 }
 
-} // anonymous namespace
-
-
-Structure make_structure_from_block(const cif::Block& block_) {
+Structure make_structure_from_block_(const cif::Block& block_,
+                                     const impl::ColumnTable* atom_site) {
+  GEMMI_PROFILE_SCOPE("mmcif.make_structure");
   // find() and Table don't have const variants, but we don't change anything.
   cif::Block& block = const_cast<cif::Block&>(block_);
   gemmi::Structure st;
@@ -1049,7 +1159,7 @@ Structure make_structure_from_block(const cif::Block& block_) {
     st.origx = get_transform_matrix(origx_tv[0]);
   }
 
-  read_atom_sites(block, st);
+  read_atom_sites(block, atom_site, st);
   read_entity_and_sequence_info(block, st);
   fill_residue_entity_type(st);
   st.setup_cell_images();
@@ -1076,6 +1186,17 @@ Structure make_structure_from_block(const cif::Block& block_) {
   return st;
 }
 
+} // anonymous namespace
+
+Structure make_structure_from_block(const cif::Block& block) {
+  return make_structure_from_block_(block, nullptr);
+}
+
+Structure impl::make_structure_from_block_and_columns(const cif::Block& block,
+                                                      const ColumnTable& atom_site) {
+  return make_structure_from_block_(block, &atom_site);
+}
+
 
 Residue make_residue_from_chemcomp_block(const cif::Block& block, ChemCompModel kind) {
   std::array<std::string, 3> xyz_tags;
@@ -2,15 +2,27 @@
 
 #include <gemmi/mmread_gz.hpp>
 #include <gemmi/mmread.hpp> // for read_structure
+#include <gemmi/binfile.hpp>   // for read_binary_structure
 #include <gemmi/pdb.hpp>    // for read_pdb
 #include <gemmi/gz.hpp>     // for MaybeGzipped
 #include <gemmi/read_cif.hpp>  // for read_cif_gz
+#include <gemmi/profile.hpp>   // for GEMMI_PROFILE_SCOPE
 
 namespace gemmi {
 
 Structure read_structure_gz(const std::string& path, CoorFormat format,
                             cif::Document* save_doc) {
-  return read_structure(MaybeGzipped(path), format, save_doc);
+  GEMMI_PROFILE_SCOPE("read_structure");
+  MaybeGzipped input(path);
+  // uncompressed binary files are memory-mapped
+  if (!input.is_compressed() && !input.is_stdin() &&
+      (format == CoorFormat::Binary ||
+       (format == CoorFormat::Unknown && coor_format_from_ext(path) == CoorFormat::Binary))) {
+    if (save_doc)
+      save_doc->clear();
+    return read_binary_structure(path);
+  }
+  return read_structure(input, format, save_doc);
 }
 
 Structure read_pdb_gz(const std::string& path, PdbReadOptions options) {
@@ -1,10 +1,22 @@
 // Copyright 2018-2023 Global Phasing Ltd.
 
 #include <gemmi/monlib.hpp>
+#if defined(__GNUC__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include "../third_party/serializer.h"  // must be included before serialize.hpp
+#if defined(__GNUC__)
+# pragma GCC diagnostic pop
+#endif
 #include <gemmi/calculate.hpp>  // for calculate_chiral_volume
 #include <gemmi/modify.hpp>     // for rename_atom_names
 #include <gemmi/read_cif.hpp>   // for read_cif_gz
 #include <gemmi/numb.hpp>       // for as_number
+#include <gemmi/fileutil.hpp>   // for file_open, MappedFile
+#include <gemmi/serialize.hpp>  // for serialize(Archive&, ChemComp&), ...
+#include <gemmi/version.hpp>    // for GEMMI_VERSION
+#include <random>               // for random_device
 
 namespace gemmi {
 
@@ -110,7 +122,7 @@ Restraints read_link_restraints(const cif::Block& block_) {
   return rt;
 }
 
-void insert_chemlinks_into(const cif::Document& doc, std::map<std::string,ChemLink>& links) {
+void read_chemlinks(const cif::Document& doc, std::vector<ChemLink>& links) {
   const cif::Block* list_block = doc.find_block("link_list");
   auto use_chem_link = [](const cif::Block& block, ChemLink& link) {
     for (auto row : const_cast<cif::Block&>(block).find("_chem_link.",
@@ -144,7 +156,7 @@ void insert_chemlinks_into(const cif::Document& doc, std::map<std::string,ChemLi
       use_chem_link(block, link);
       link.rt = read_link_restraints(block);
       link.block = block;
-      links.emplace(link.id, link);
+      links.push_back(std::move(link));
     }
 }
 
@@ -205,7 +217,7 @@ Restraints read_restraint_modifications(const cif::Block& block_) {
   return rt;
 }
 
-void insert_chemmods_into(const cif::Document& doc, std::map<std::string, ChemMod>& mods) {
+void read_chemmods(const cif::Document& doc, std::vector<ChemMod>& mods) {
   const cif::Block* list_block = doc.find_block("mod_list");
   auto use_chem_mod = [](const cif::Block& block, ChemMod& mod) {
     for (auto row : const_cast<cif::Block&>(block).find("_chem_mod.",
@@ -237,7 +249,7 @@ void insert_chemmods_into(const cif::Document& doc, std::map<std::string, ChemMo
                                  ra.str(4)});
       mod.rt = read_restraint_modifications(block);
       mod.block = block;
-      mods.emplace(mod.id, mod);
+      mods.push_back(std::move(mod));
     }
 }
 
@@ -480,17 +492,42 @@ std::string MonLib::relative_monomer_path(const std::string& code) {
   return path;
 }
 
-void MonLib::read_monomer_doc(const cif::Document& doc) {
+MonLibDocContent MonLib::parse_monomer_doc(const cif::Document& doc) {
+  MonLibDocContent content;
   // ChemComp
   if (const cif::Block* block = doc.find_block("comp_list"))
     for (auto row : const_cast<cif::Block*>(block)->find("_chem_comp.", {"id", "group"}))
-      cc_groups.emplace(row.str(0), ChemComp::read_group(row.str(1)));
+      content.cc_groups.emplace_back(row.str(0), ChemComp::read_group(row.str(1)));
   for (const cif::Block& block : doc.blocks)
-    add_monomer_if_present(block);
+    if (block.has_tag("_chem_comp_atom.atom_id"))
+      content.monomers.push_back(make_chemcomp_from_block(block));
   // ChemLink
-  insert_chemlinks_into(doc, links);
+  read_chemlinks(doc, content.links);
   // ChemMod
-  insert_chemmods_into(doc, modifications);
+  read_chemmods(doc, content.modifications);
+  return content;
+}
+
+void MonLib::add_monomer_doc_content(MonLibDocContent&& content) {
+  for (auto& item : content.cc_groups)
+    cc_groups.emplace(std::move(item));
+  for (ChemComp& cc : content.monomers) {
+    if (cc.group == ChemComp::Group::Null) {
+      auto it = cc_groups.find(cc.name);
+      if (it != cc_groups.end())
+        cc.group = it->second;
+    }
+    std::string name = cc.name;
+    monomers.emplace(name, std::move(cc));
+  }
+  for (ChemLink& link : content.links) {
+    std::string id = link.id;
+    links.emplace(id, std::move(link));
+  }
+  for (ChemMod& mod : content.modifications) {
+    std::string id = mod.id;
+    modifications.emplace(id, std::move(mod));
+  }
 }
 
 namespace {
@@ -522,6 +559,157 @@ double find_radius(const EnerLib& ener_lib, const std::string& chemtype,
   return std::isnan(r) ? 0 : r;
 }
 
+// Binary cache of parsed monomer library files, used by read_monomer_lib().
+// The file contains a header with an index of entries, followed by
+// serialized entries (MonLibDocContent or EnerLib), one per source file.
+// Only entries that are requested are deserialized. Each entry records
+// the size and mtime of the source file; if they change, the file is
+// parsed again and the cache is rewritten.
+class MonLibCache {
+public:
+  struct Entry {
+    std::string path;  // relative to monomer_dir
+    FileStamp stamp;
+    uint64_t offset;   // from the start of data
+    uint64_t length;
+    template<typename Archive, typename Self>
+    static void serialize(Archive& archive, Self& self) {
+      archive(self.path, self.stamp.mtime, self.stamp.size, self.offset, self.length);
+    }
+  };
+
+  MonLibCache(const std::string& cache_path, const std::string& monomer_dir,
+              const Logger& logger)
+    : cache_path_(cache_path), monomer_dir_(monomer_dir), logger_(logger) {
+    if (cache_path_.empty())
+      return;
+    try {
+      file_.open(cache_path_);
+    } catch (std::system_error&) {
+      return;  // no cache yet
+    }
+    try {
+      zpp::serializer::memory_view_input_archive in(file_.data(), file_.size());
+      std::string magic, version, dir;
+      uint32_t format = 0;
+      in(magic, format);
+      if (magic != "gemmi-monlib-cache" || format != kFormat)
+        return;
+      in(version, dir);
+      if (version != GEMMI_VERSION || dir != monomer_dir_)
+        return;
+      in(old_entries_);
+      data_ = file_.data() + in.offset();
+      data_size_ = file_.size() - in.offset();
+    } catch (std::exception&) {
+      old_entries_.clear();
+      logger_.note("ignoring corrupted monomer library cache ", cache_path_);
+    }
+  }
+
+  bool enabled() const { return !cache_path_.empty(); }
+
+  // Returns false if the file is not cached or the cache entry is outdated.
+  template<typename T>
+  bool get(const std::string& rel_path, const FileStamp& stamp, T& obj) {
+    for (const Entry& e : old_entries_)
+      if (e.path == rel_path) {
+        if (e.stamp != stamp || e.offset > data_size_ ||
+            e.length > data_size_ - e.offset)
+          return false;
+        try {
+          zpp::serializer::memory_view_input_archive in(data_ + e.offset, e.length);
+          in(obj);
+          return true;
+        } catch (std::exception&) {
+          obj = T();
+          return false;
+        }
+      }
+    return false;
+  }
+
+  template<typename T>
+  void put(const std::string& rel_path, const FileStamp& stamp, const T& obj) {
+    new_entries_.push_back({rel_path, stamp, 0, 0});
+    new_data_.emplace_back();
+    zpp::serializer::memory_output_archive out(new_data_.back());
+    out(obj);
+  }
+
+  // Writes a new cache file if any entries were added. To avoid partially
+  // written files being read by other processes, the file is written
+  // under a temporary name and then renamed.
+  void save() {
+    if (new_entries_.empty())
+      return;
+    std::vector<Entry> entries;
+    std::vector<std::pair<const unsigned char*, size_t>> blobs;
+    uint64_t offset = 0;
+    for (const Entry& e : old_entries_)
+      if (!in_vector_f([&](const Entry& n) { return n.path == e.path; }, new_entries_) &&
+          e.offset <= data_size_ && e.length <= data_size_ - e.offset) {
+        entries.push_back({e.path, e.stamp, offset, e.length});
+        blobs.emplace_back(data_ + e.offset, (size_t) e.length);
+        offset += e.length;
+      }
+    for (size_t i = 0; i != new_entries_.size(); ++i) {
+      const Entry& e = new_entries_[i];
+      entries.push_back({e.path, e.stamp, offset, new_data_[i].size()});
+      blobs.emplace_back(new_data_[i].data(), new_data_[i].size());
+      offset += new_data_[i].size();
+    }
+    std::vector<unsigned char> header;
+    zpp::serializer::memory_output_archive out(header);
+    out(std::string("gemmi-monlib-cache"), kFormat,
+        std::string(GEMMI_VERSION), monomer_dir_, entries);
+    std::string tmp_path;
+    try {
+      tmp_path = cache_path_ + ".tmp" + std::to_string(std::random_device()());
+      {
+        fileptr_t f = file_open(tmp_path.c_str(), "wb");
+        bool ok = std::fwrite(header.data(), header.size(), 1, f.get()) == 1;
+        for (const auto& blob : blobs)
+          if (ok && blob.second != 0)
+            ok = std::fwrite(blob.first, blob.second, 1, f.get()) == 1;
+        if (!ok)
+          sys_fail("Failed to write " + tmp_path);
+      }
+      file_.close();  // on Windows, a mapped/open file can't be replaced
+#if defined(_WIN32)
+      std::remove(cache_path_.c_str());
+#endif
+      if (std::rename(tmp_path.c_str(), cache_path_.c_str()) != 0)
+        sys_fail("Failed to rename " + tmp_path);
+    } catch (std::exception& e) {
+      if (!tmp_path.empty())
+        std::remove(tmp_path.c_str());
+      logger_.note("monomer library cache not saved: ", e.what());
+    }
+  }
+
+private:
+  // increase when the serialized format of any of the cached types changes
+  static constexpr uint32_t kFormat = 1;
+
+  std::string cache_path_;
+  std::string monomer_dir_;
+  const Logger& logger_;
+  MappedFile file_;
+  const unsigned char* data_ = nullptr;
+  uint64_t data_size_ = 0;
+  std::vector<Entry> old_entries_;
+  std::vector<Entry> new_entries_;
+  std::vector<std::vector<unsigned char>> new_data_;
+};
+
+void add_ener_lib(EnerLib& target, EnerLib&& source) {
+  for (auto& item : source.atoms)
+    target.atoms.emplace(item.first, item.second);
+  for (auto& item : source.bonds)
+    target.bonds.emplace(item.first, std::move(item.second));
+}
+
 } // anonymous namespace
 
 void MonLib::read_monomer_cif(const std::string& path_) {
@@ -530,26 +718,49 @@ void MonLib::read_monomer_cif(const std::string& path_) {
 
 bool MonLib::read_monomer_lib(const std::string& monomer_dir_,
                               const std::vector<std::string>& resnames,
-                              const Logger& logger) {
+                              const Logger& logger,
+                              const std::string& cache_path) {
   if (monomer_dir_.empty())
     fail("read_monomer_lib: monomer_dir not specified.");
   set_monomer_dir(monomer_dir_);
 
+  MonLibCache cache(cache_path, monomer_dir, logger);
+  // parse() returns MonLibDocContent or EnerLib, which is cached
+  auto read_file = [&](const std::string& rel_path, auto&& parse, auto&& add) {
+    std::string full_path = monomer_dir + rel_path;
+    FileStamp stamp;
+    if (cache.enabled() && get_file_stamp(full_path, stamp)) {
+      typename std::decay<decltype(parse(cif::Document()))>::type content;
+      if (!cache.get(rel_path, stamp, content)) {
+        content = parse(read_cif_gz(full_path));
+        cache.put(rel_path, stamp, content);
+      }
+      add(std::move(content));
+    } else {
+      add(parse(read_cif_gz(full_path)));
+    }
+  };
+  auto read_doc = [&](const std::string& rel_path) {
+    read_file(rel_path, &MonLib::parse_monomer_doc,
+              [&](MonLibDocContent&& c) { add_monomer_doc_content(std::move(c)); });
+  };
+
   // Only recent versions of CCP4 Monomer Library have links_and_mods.cif
   try {
-    read_monomer_cif(monomer_dir + "links_and_mods.cif");
+    read_doc("links_and_mods.cif");
   } catch (std::system_error&) {
-    read_monomer_cif(monomer_dir + "list/mon_lib_list.cif");
+    read_doc("list/mon_lib_list.cif");
   }
-  ener_lib.read(read_cif_gz(monomer_dir + "ener_lib.cif"));
+  read_file("ener_lib.cif",
+            [](const cif::Document& doc) { EnerLib el; el.read(doc); return el; },
+            [&](EnerLib&& el) { add_ener_lib(ener_lib, std::move(el)); });
 
   bool ok = true;
   for (const std::string& name : resnames) {
     if (monomers.find(name) != monomers.end())
       continue;
     try {
-      const cif::Document& doc = read_cif_gz(path(name));
-      read_monomer_doc(doc);
+      read_doc(relative_monomer_path(name));
     } catch (std::system_error& err) {
       if (err.code().value() == ENOENT)
         logger.mesg("Monomer not in the library: ", name, '.');
@@ -561,6 +772,7 @@ bool MonLib::read_monomer_lib(const std::string& monomer_dir_,
       ok = false;
     }
   }
+  cache.save();
   return ok;
 }
 
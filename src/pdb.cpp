@@ -13,6 +13,7 @@
 #include "gemmi/metadata.hpp" // for Metadata
 #include "gemmi/model.hpp"    // for Structure, impl::find_or_add
 #include "gemmi/polyheur.hpp" // for assign_subchains
+#include "gemmi/profile.hpp"  // for GEMMI_PROFILE_SCOPE
 #include "gemmi/util.hpp"     // for trim_str, alpha_up, istarts_with
 
 namespace gemmi {
@@ -859,6 +860,7 @@ void read_metadata_from_remarks(Structure& st) {
 
 Structure read_pdb_from_stream(AnyStream& line_reader, const std::string& source,
                                PdbReadOptions options) {
+  GEMMI_PROFILE_SCOPE("pdb.read");
   if (options.max_line_length <= 0 || options.max_line_length > 120)
     options.max_line_length = 120;
   Structure st;
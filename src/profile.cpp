@@ -0,0 +1,174 @@
+// Copyright 2026 Global Phasing Ltd.
+
+#include <gemmi/profile.hpp>
+#include <cstdio>              // for snprintf
+#include <algorithm>           // for find, max
+#include <gemmi/fileutil.hpp>  // for file_open
+
+namespace gemmi {
+
+namespace {
+
+// names are string literals from the code, but quote them just in case
+void append_json_string(std::string& out, const std::string& s) {
+  out += '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    if ((unsigned char)c >= 0x20)
+      out += c;
+  }
+  out += '"';
+}
+
+// seconds in the summary
+void append_seconds(std::string& out, int64_t ns) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.9g", ns * 1e-9);
+  out += buf;
+}
+
+// microseconds in the trace format
+void append_microseconds(std::string& out, int64_t ns) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.3f", ns * 1e-3);
+  out += buf;
+}
+
+} // anonymous namespace
+
+Profiler& Profiler::instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+bool Profiler::compiled_in() {
+#ifdef GEMMI_PROFILE
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Profiler::enable(bool on) {
+  enabled_.store(on, std::memory_order_relaxed);
+}
+
+void Profiler::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  origin_ = Clock::now();
+  events_.clear();
+  counters_.clear();
+}
+
+// must be called with mutex_ locked
+uint32_t Profiler::thread_number() {
+  std::thread::id id = std::this_thread::get_id();
+  auto it = std::find(threads_.begin(), threads_.end(), id);
+  if (it != threads_.end())
+    return uint32_t(it - threads_.begin());
+  threads_.push_back(id);
+  return uint32_t(threads_.size() - 1);
+}
+
+void Profiler::add_event(const char* name, Clock::time_point start, Clock::time_point end) {
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  std::lock_guard<std::mutex> lock(mutex_);
+  events_.push_back({name,
+                     duration_cast<nanoseconds>(start - origin_).count(),
+                     duration_cast<nanoseconds>(end - start).count(),
+                     thread_number()});
+}
+
+void Profiler::add_count(const char* name, int64_t n) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  counters_[name] += n;
+}
+
+std::vector<Profiler::Event> Profiler::events() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return events_;
+}
+
+std::map<std::string, int64_t> Profiler::counters() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return counters_;
+}
+
+std::string Profiler::summary_json() const {
+  struct Timer {
+    size_t calls = 0;
+    int64_t total_ns = 0;
+    int64_t max_ns = 0;
+  };
+  std::map<std::string, Timer> timers;
+  for (const Event& event : events()) {
+    Timer& t = timers[event.name];
+    t.calls++;
+    t.total_ns += event.duration_ns;
+    t.max_ns = std::max(t.max_ns, event.duration_ns);
+  }
+  std::string out = "{\n \"timers\": {";
+  const char* sep = "\n  ";
+  for (const auto& item : timers) {
+    out += sep;
+    append_json_string(out, item.first);
+    out += ": {\"calls\": " + std::to_string(item.second.calls) + ", \"total_s\": ";
+    append_seconds(out, item.second.total_ns);
+    out += ", \"max_s\": ";
+    append_seconds(out, item.second.max_ns);
+    out += '}';
+    sep = ",\n  ";
+  }
+  out += "\n },\n \"counters\": {";
+  sep = "\n  ";
+  for (const auto& item : counters()) {
+    out += sep;
+    append_json_string(out, item.first);
+    out += ": " + std::to_string(item.second);
+    sep = ",\n  ";
+  }
+  out += "\n }\n}\n";
+  return out;
+}
+
+std::string Profiler::chrome_trace_json() const {
+  std::vector<Event> evs = events();
+  int64_t end_ns = 0;
+  std::string out = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  const char* sep = "\n";
+  for (const Event& event : evs) {
+    out += sep;
+    out += "{\"name\": ";
+    append_json_string(out, event.name);
+    out += ", \"ph\": \"X\", \"pid\": 1, \"tid\": " + std::to_string(event.thread);
+    out += ", \"ts\": ";
+    append_microseconds(out, event.start_ns);
+    out += ", \"dur\": ";
+    append_microseconds(out, event.duration_ns);
+    out += '}';
+    sep = ",\n";
+    end_ns = std::max(end_ns, event.start_ns + event.duration_ns);
+  }
+  for (const auto& item : counters()) {
+    out += sep;
+    out += "{\"name\": ";
+    append_json_string(out, item.first);
+    out += ", \"ph\": \"C\", \"pid\": 1, \"tid\": 0, \"ts\": ";
+    append_microseconds(out, end_ns);
+    out += ", \"args\": {\"value\": " + std::to_string(item.second) + "}}";
+    sep = ",\n";
+  }
+  out += "\n]}\n";
+  return out;
+}
+
+void Profiler::write_file(const std::string& path, bool chrome_trace) const {
+  std::string json = chrome_trace ? chrome_trace_json() : summary_json();
+  fileptr_t f = file_open(path.c_str(), "wb");
+  if (std::fwrite(json.data(), 1, json.size(), f.get()) != json.size())
+    sys_fail("Failed to write " + path);
+}
+
+} // namespace gemmi
@@ -0,0 +1,176 @@
+// Copyright 2026 Global Phasing Ltd.
+//
+// Batched RMSD calculations with the QCP method.
+
+#include <gemmi/qcp.hpp>
+#include <gemmi/fail.hpp>      // for fail
+#include <gemmi/parallel.hpp>  // for parallel_for
+
+namespace gemmi {
+
+namespace {
+
+// Sums in inner products are accumulated in this many independent lanes,
+// so that the compiler can vectorize the loop over points.
+constexpr size_t kLanes = 4;
+// Number of pairs that go through the Newton-Raphson iterations together.
+constexpr size_t kBatch = 8;
+
+Mat33 ensemble_inner_product(const QcpEnsemble& ens, size_t i, size_t j) {
+  const size_t stride = ens.stride;
+  const double* x1 = ens.coords.data() + i * 3 * stride;
+  const double* y1 = x1 + stride;
+  const double* z1 = y1 + stride;
+  const double* x2 = ens.coords.data() + j * 3 * stride;
+  const double* y2 = x2 + stride;
+  const double* z2 = y2 + stride;
+  double acc[9][kLanes] = {};
+  for (size_t m = 0; m < stride; m += kLanes)
+    for (size_t l = 0; l < kLanes; ++l) {
+      size_t k = m + l;
+      acc[0][l] += x1[k] * x2[k];
+      acc[1][l] += x1[k] * y2[k];
+      acc[2][l] += x1[k] * z2[k];
+      acc[3][l] += y1[k] * x2[k];
+      acc[4][l] += y1[k] * y2[k];
+      acc[5][l] += y1[k] * z2[k];
+      acc[6][l] += z1[k] * x2[k];
+      acc[7][l] += z1[k] * y2[k];
+      acc[8][l] += z1[k] * z2[k];
+    }
+  Mat33 mat(0);
+  for (int n = 0; n < 9; ++n)
+    for (size_t l = 0; l < kLanes; ++l)
+      mat.a[n / 3][n % 3] += acc[n][l];
+  return mat;
+}
+
+// Calculates RMSDs for pairs (a[k], b[k]), k < n <= kBatch.
+// It follows fast_calc_rmsd_and_rotation(), except that the Newton-Raphson
+// iterations run for all pairs in a batch (converged pairs are masked).
+void rmsd_batch(const QcpEnsemble& ens, const size_t* a, const size_t* b,
+                size_t n, double* rmsd) {
+  const double evalprec = 1e-11;
+  double E0[kBatch], C0[kBatch], C1[kBatch], C2[kBatch], x[kBatch];
+  bool active[kBatch];
+  for (size_t k = 0; k < kBatch; ++k) {
+    if (k < n) {
+      Mat33 A = ensemble_inner_product(ens, a[k], b[k]);
+      double C[3];
+      qcp_characteristic_polynomial(A, C);
+      C0[k] = C[0];
+      C1[k] = C[1];
+      C2[k] = C[2];
+      E0[k] = (ens.self_products[a[k]] + ens.self_products[b[k]]) * 0.5;
+      active[k] = true;
+    } else {
+      // unused lane, with values that don't produce NaNs
+      C0[k] = C2[k] = E0[k] = 0.;
+      C1[k] = 1.;
+      active[k] = false;
+    }
+    x[k] = E0[k];
+  }
+  for (int iter = 0; iter < 50; ++iter) {
+    bool any_active = false;
+    for (size_t k = 0; k < kBatch; ++k) {
+      double x2 = x[k] * x[k];
+      double bb = (x2 + C2[k]) * x[k];
+      double aa = bb + C1[k];
+      double delta = (aa * x[k] + C0[k]) / (2.0 * x2 * x[k] + bb + aa);
+      double new_x = x[k] - delta;
+      bool converged = std::fabs(new_x - x[k]) < std::fabs(evalprec * new_x);
+      x[k] = active[k] ? new_x : x[k];
+      active[k] = active[k] && !converged;
+      any_active = any_active || active[k];
+    }
+    if (!any_active)
+      break;
+  }
+  for (size_t k = 0; k < n; ++k)
+    rmsd[k] = std::sqrt(std::fabs(2.0 * (E0[k] - x[k]) / ens.weight_sum));
+}
+
+} // anonymous namespace
+
+QcpEnsemble::QcpEnsemble(size_t point_count_, const double* weight)
+    : point_count(point_count_),
+      stride((point_count_ + kLanes - 1) / kLanes * kLanes) {
+  if (weight) {
+    weights.assign(weight, weight + point_count);
+    for (double w : weights)
+      weight_sum += w;
+  } else {
+    weight_sum = (double) point_count;
+  }
+}
+
+void QcpEnsemble::add(const Position* pos) {
+  const double* weight = weights.empty() ? nullptr : weights.data();
+  Position ctr = qcp_calculate_center(pos, point_count, weight);
+  size_t offset = coords.size();
+  coords.resize(offset + 3 * stride, 0.);
+  double* x = &coords[offset];
+  double* y = x + stride;
+  double* z = y + stride;
+  double self_product = 0.;
+  for (size_t i = 0; i < point_count; ++i) {
+    double sqrt_w = weight ? std::sqrt(weight[i]) : 1.;
+    Position f = (pos[i] - ctr) * sqrt_w;
+    x[i] = f.x;
+    y[i] = f.y;
+    z[i] = f.z;
+    self_product += f.length_sq();
+  }
+  self_products.push_back(self_product);
+}
+
+std::vector<double> qcp_rmsd_to_reference(const QcpEnsemble& ens, size_t ref,
+                                          int n_threads) {
+  if (ref >= ens.size())
+    fail("qcp_rmsd_to_reference: reference index out of range");
+  std::vector<double> result(ens.size());
+  parallel_for(ens.size(), n_threads, [&](size_t begin, size_t end) {
+    size_t a[kBatch], b[kBatch];
+    for (size_t k = 0; k < kBatch; ++k)
+      a[k] = ref;
+    for (size_t start = begin; start < end; start += kBatch) {
+      size_t n = std::min(kBatch, end - start);
+      for (size_t k = 0; k < n; ++k)
+        b[k] = start + k;
+      rmsd_batch(ens, a, b, n, &result[start]);
+    }
+  });
+  return result;
+}
+
+std::vector<double> qcp_rmsd_matrix(const QcpEnsemble& ens, int n_threads) {
+  size_t size = ens.size();
+  size_t n_pairs = size < 2 ? 0 : size * (size - 1) / 2;
+  std::vector<double> result(n_pairs);
+  // index of pair (i, i+1) in the condensed matrix
+  auto row_start = [size](size_t i) { return i * size - i * (i + 1) / 2; };
+  // pairs are distributed evenly among threads, regardless of rows
+  parallel_for(n_pairs, n_threads, [&](size_t begin, size_t end) {
+    size_t i = 0;
+    while (row_start(i + 1) <= begin)
+      ++i;
+    size_t j = i + 1 + (begin - row_start(i));
+    size_t a[kBatch], b[kBatch];
+    for (size_t start = begin; start < end; start += kBatch) {
+      size_t n = std::min(kBatch, end - start);
+      for (size_t k = 0; k < n; ++k) {
+        a[k] = i;
+        b[k] = j;
+        if (++j == size) {
+          ++i;
+          j = i + 1;
+        }
+      }
+      rmsd_batch(ens, a, b, n, &result[start]);
+    }
+  });
+  return result;
+}
+
+} // namespace gemmi
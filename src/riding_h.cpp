@@ -1,6 +1,8 @@
 // Copyright 2018-2022 Global Phasing Ltd.
 
 #include <gemmi/riding_h.hpp>
+#include <gemmi/parallel.hpp>  // for parallel_chunks_with_logger
+#include <unordered_map>
 
 namespace gemmi {
 
@@ -156,7 +158,7 @@ void giveup(const std::string& message, const std::vector<BondedAtom>& hs) {
 
 // known and hs are lists of heavy atoms and hydrogens bonded to atom.
 // hs is const, but nevertheless atoms it points to are modified.
-void place_hydrogens(const Topo& topo, const Atom& atom,
+void place_hydrogens(const Topo& topo, const Logger& logger, const Atom& atom,
                      const std::vector<BondedAtom>& known,
                      const std::vector<BondedAtom>& hs) {
   using Angle = Restraints::Angle;
@@ -333,7 +335,7 @@ void place_hydrogens(const Topo& topo, const Atom& atom,
       Vec3 v14 = rotate_about_axis(v12, axis, theta1 * ratio);
       hs[0].pos = atom.pos + Position(hs[0].dist / v14.length() * v14);
       if (hs.size() > 1) {
-        topo.logger.err("Unhandled topology of ", hs.size(), " hydrogens bonded to ", atom.name);
+        logger.err("Unhandled topology of ", hs.size(), " hydrogens bonded to ", atom.name);
         for (size_t i = 1; i < hs.size(); ++i) {
           hs[i].ptr->occ = 0;
           hs[i].ptr->calc_flag = CalcFlag::Dummy;
@@ -408,73 +410,150 @@ void place_hydrogens(const Topo& topo, const Atom& atom,
   }
 }
 
-}  // anonymous namespace
-
-void place_hydrogens_on_all_atoms(Topo& topo) {
+// Buffers reused for consecutive atoms, to avoid allocations in the loop.
+struct BondedAtomBuffers {
   std::vector<BondedAtom> known;
   std::vector<BondedAtom> hs;
-  auto filter = [](char alt, const std::vector<BondedAtom>& v) {
-    std::vector<BondedAtom> out;
-    out.reserve(v.size());
-    for (const BondedAtom& ba : v)
-      if (ba.ptr->altloc_matches(alt))
-        out.push_back(ba);
-    return out;
+  std::vector<BondedAtom> known_alt;
+  std::vector<BondedAtom> hs_alt;
+};
+
+void filter_altloc(char alt, const std::vector<BondedAtom>& v,
+                   std::vector<BondedAtom>& out) {
+  out.clear();
+  for (const BondedAtom& ba : v)
+    if (ba.ptr->altloc_matches(alt))
+      out.push_back(ba);
+}
+
+void place_hydrogens_on_atom(const Topo& topo, const Logger& logger, Atom& atom,
+                             BondedAtomBuffers& buf) {
+  std::vector<BondedAtom>& known = buf.known;
+  std::vector<BondedAtom>& hs = buf.hs;
+  // gather bonded atoms
+  known.clear();
+  hs.clear();
+  auto range = topo.bond_index.equal_range(&atom);
+  for (auto i = range.first; i != range.second; ++i) {
+    const Topo::Bond* t = i->second;
+    Atom* other = t->atoms[t->atoms[0] == &atom ? 1 : 0];
+    if (other->altloc && atom.altloc) {
+      // We support links between different altlocs in Topo (e.g. link A-B),
+      // although these are rare, special cases.
+      // But if we had bonds between atom 1 (A/B) and atom 2 (A/B/C),
+      // and we had bonds B-B and B-C, we'd want to use only one of them (B-B).
+      // Checking atom's name is not robust, but should suffice here.
+      if (atom.altloc != other->altloc &&
+          in_vector_f([&](const BondedAtom& a) { return a.ptr->name == other->name; },
+                      known))
+        continue;
+    }
+    auto& atom_list = other->is_hydrogen() ? hs : known;
+    atom_list.push_back({other, other->pos, t->restr->value});
+  }
+  if (hs.size() == 0)
+    return;
+  std::string altlocs;
+  // In a special case: Hs with altlocs on a parent without altloc,
+  // we need to process conformations one by one.
+  if (atom.altloc == '\0')
+    for (const auto& h : hs) {
+      char alt = h.ptr->altloc;
+      if (alt && altlocs.find(alt) == std::string::npos) {
+        altlocs += alt;
+        filter_altloc(alt, known, buf.known_alt);
+        filter_altloc(alt, hs, buf.hs_alt);
+        place_hydrogens(topo, logger, atom, buf.known_alt, buf.hs_alt);
+      }
+    }
+  // In all other cases, all bonded atoms are from the same conformation.
+  if (altlocs.empty())
+    place_hydrogens(topo, logger, atom, known, hs);
+}
+
+// Returns indices of items where chunks of work can start, so that residues
+// connected by links (directly or not) are in the same chunk.
+// Hydrogens are placed using positions of bonded atoms and of their
+// hydrogens, so such residues must be processed serially, in order.
+std::vector<size_t> chunk_starts(const Topo& topo,
+                                 const std::vector<const Residue*>& items,
+                                 size_t max_chunks) {
+  std::vector<size_t> starts(1, 0);
+  if (max_chunks <= 1)
+    return starts;
+  // union-find over all residues in topo
+  std::unordered_map<const Residue*, int> res_index;
+  for (const Topo::ChainInfo& chain_info : topo.chain_infos)
+    for (const Topo::ResInfo& ri : chain_info.res_infos)
+      res_index.emplace(ri.res, (int) res_index.size());
+  std::vector<int> parent(res_index.size());
+  for (size_t i = 0; i != parent.size(); ++i)
+    parent[i] = (int) i;
+  auto find_root = [&](int n) {
+    while (parent[n] != n)
+      n = parent[n] = parent[parent[n]];
+    return n;
+  };
+  auto join = [&](const Topo::Link& link) {
+    auto it1 = res_index.find(link.res1);
+    auto it2 = res_index.find(link.res2);
+    if (it1 != res_index.end() && it2 != res_index.end())
+      parent[find_root(it1->second)] = find_root(it2->second);
   };
+  for (const Topo::ChainInfo& chain_info : topo.chain_infos)
+    for (const Topo::ResInfo& ri : chain_info.res_infos)
+      for (const Topo::Link& link : ri.prev)
+        join(link);
+  for (const Topo::Link& link : topo.extras)
+    join(link);
+  // a chunk can start at item i if no group spans items i-1 and i
+  std::vector<size_t> group_end(parent.size(), 0);
+  for (size_t i = 0; i != items.size(); ++i)
+    group_end[find_root(res_index.at(items[i]))] = i + 1;
+  size_t reach = 0;  // items up to i-1 are in groups that end before reach
+  for (size_t i = 0; i != items.size(); ++i) {
+    if (i == reach && i >= starts.size() * items.size() / max_chunks &&
+        i != starts.back())
+      starts.push_back(i);
+    reach = std::max(reach, group_end[find_root(res_index.at(items[i]))]);
+  }
+  return starts;
+}
+
+}  // anonymous namespace
+
+void place_hydrogens_on_all_atoms(Topo& topo, int n_threads) {
+  std::vector<std::pair<Topo::ChainInfo*, Topo::ResInfo*>> items;
+  std::vector<const Residue*> residues;
   for (Topo::ChainInfo& chain_info : topo.chain_infos)
-    for (Topo::ResInfo& ri : chain_info.res_infos) {
+    for (Topo::ResInfo& ri : chain_info.res_infos)
       // If we don't have monomer description from a cif file,
       // only ad-hoc restraints, don't try to place hydrogens.
-      if (ri.orig_chemcomp == nullptr)
-        continue;
-      for (Atom& atom : ri.res->atoms) {
-        if (atom.is_hydrogen())
-          continue;
-        try {
-          // gather bonded atoms
-          known.clear();
-          hs.clear();
-          auto range = topo.bond_index.equal_range(&atom);
-          for (auto i = range.first; i != range.second; ++i) {
-            const Topo::Bond* t = i->second;
-            Atom* other = t->atoms[t->atoms[0] == &atom ? 1 : 0];
-            if (other->altloc && atom.altloc) {
-              // We support links between different altlocs in Topo (e.g. link A-B),
-              // although these are rare, special cases.
-              // But if we had bonds between atom 1 (A/B) and atom 2 (A/B/C),
-              // and we had bonds B-B and B-C, we'd want to use only one of them (B-B).
-              // Checking atom's name is not robust, but should suffice here.
-              if (atom.altloc != other->altloc &&
-                  in_vector_f([&](const BondedAtom& a) { return a.ptr->name == other->name; },
-                              known))
-                continue;
-            }
-            auto& atom_list = other->is_hydrogen() ? hs : known;
-            atom_list.push_back({other, other->pos, t->restr->value});
+      if (ri.orig_chemcomp != nullptr) {
+        items.emplace_back(&chain_info, &ri);
+        residues.push_back(ri.res);
+      }
+  n_threads = normalize_thread_count(n_threads);
+  std::vector<size_t> starts = chunk_starts(topo, residues, 4 * (size_t) n_threads);
+  starts.push_back(items.size());
+  parallel_chunks_with_logger(starts.size() - 1, n_threads, topo.logger,
+                              [&](size_t n, const Logger& logger) {
+    BondedAtomBuffers buf;
+    for (size_t i = starts[n]; i != starts[n + 1]; ++i) {
+      const Topo::ChainInfo& chain_info = *items[i].first;
+      Residue& res = *items[i].second->res;
+      for (Atom& atom : res.atoms)
+        if (!atom.is_hydrogen()) {
+          try {
+            place_hydrogens_on_atom(topo, logger, atom, buf);
+          } catch (const std::runtime_error& e) {
+            logger.err("Placing of hydrogen bonded to ",
+                       atom_str(chain_info.chain_ref, res, atom),
+                       " failed:\n  ", e.what());
           }
-          if (hs.size() == 0)
-            continue;
-          std::string altlocs;
-          // In a special case: Hs with altlocs on a parent without altloc,
-          // we need to process conformations one by one.
-          if (atom.altloc == '\0')
-            for (const auto& h : hs) {
-              char alt = h.ptr->altloc;
-              if (alt && altlocs.find(alt) == std::string::npos) {
-                altlocs += alt;
-                place_hydrogens(topo, atom, filter(alt, known), filter(alt, hs));
-              }
-            }
-          // In all other cases, all bonded atoms are from the same conformation.
-          if (altlocs.empty())
-            place_hydrogens(topo, atom, known, hs);
-        } catch (const std::runtime_error& e) {
-          topo.logger.err("Placing of hydrogen bonded to ",
-                          atom_str(chain_info.chain_ref, *ri.res, atom),
-                          " failed:\n  ", e.what());
         }
-      }
     }
+  });
 }
 
 }  // namespace gemmi
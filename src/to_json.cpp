@@ -2,68 +2,88 @@
 
 #include <gemmi/to_json.hpp>
 #include <cctype>    // for isdigit
+#include <cmath>     // for isfinite
 #include <set>       // for set
-#include <gemmi/numb.hpp>  // for is_numb
-#include <gemmi/util.hpp>  // for starts_with
+#include <gemmi/numb.hpp>     // for is_numb
+#include <gemmi/util.hpp>     // for starts_with
 #include <gemmi/cifdoc.hpp>
+#include <gemmi/model.hpp>    // for Structure
+#include <gemmi/sprintf.hpp>  // for to_str, sprintf_z
+#include <gemmi/to_mmcif.hpp> // for update_mmcif_block_without_atom_values
+#include <gemmi/to_pdb.hpp>   // for use_hetatm
 
 namespace gemmi {
 namespace cif {
 
 // based on tao/json/internal/escape.hpp
-static void escape(std::ostream& os, const std::string& s, size_t pos, bool to_lower) {
+static void escape(std::string& out, const std::string& s, size_t pos, bool to_lower) {
   static const char* h = "0123456789abcdef";
   const char* p = s.data() + pos;
   const char* l = p;
   const char* const e = s.data() + s.size();
   while (p != e) {
     const unsigned char c = *p;
+    // fast path for the most common characters
+    if (c >= 32 && c != '"' && c != '\\' && c != 127 &&
+        !(to_lower && c >= 'A' && c <= 'Z')) {
+      ++p;
+      continue;
+    }
+    out.append(l, p);
+    l = ++p;
     if (c == '\\') {
-      os.write(l, p - l);
-      l = ++p;
-      os << "\\\\";
+      out += "\\\\";
     } else if (c == '"') {
-      os.write(l, p - l);
-      l = ++p;
-      os << "\\\"";
+      out += "\\\"";
     } else if (c < 32) {
-      os.write(l, p - l);
-      l = ++p;
       switch ( c ) {
-        case '\b': os << "\\b"; break;
-        case '\f': os << "\\f"; break;
-        case '\n': os << "\\n"; break;
-        case '\r': os << "\\r"; break;
-        case '\t': os << "\\t"; break;
-        default: os << "\\u00" << h[(c & 0xf0) >> 4] << h[c & 0x0f];
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+          out += "\\u00";
+          out += h[(c & 0xf0) >> 4];
+          out += h[c & 0x0f];
       }
-    } else if (to_lower && c >= 'A' && c <= 'Z') {
-      os.write(l, p - l);
-      l = ++p;
-      os.put(c + 32);
     } else if (c == 127) {
-      os.write(l, p - l);
-      l = ++p;
-      os << "\\u007f";
-    } else {
-      ++p;
+      out += "\\u007f";
+    } else {  // to_lower
+      out += char(c + 32);
     }
   }
-  os.write(l, p - l);
+  out.append(l, p);
 }
 
+// cheap check that rejects most non-numbers before calling is_numb()
+static bool may_be_numb(const std::string& s) {
+  char c = s[0];
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.';
+}
 
+// Output is accumulated in a buffer and passed to ostream in large chunks.
 class JsonWriter {
 public:
-  explicit JsonWriter(std::ostream& os) : os_(os), linesep_("\n ") {}
+  JsonWriter(std::ostream& os, const Structure* st)
+    : os_(os), st_(st), linesep_("\n ") {}
   void write_json(const Document& d);
 
   JsonWriteOptions opt;
 
 private:
   std::ostream& os_;
+  const Structure* st_;  // if set, provides values for _atom_site
+  std::string out_;
   std::string linesep_;
 
+  void flush_if_full() {
+    if (out_.size() > 65536) {
+      os_.write(out_.data(), out_.size());
+      out_.clear();
+    }
+  }
+
   void change_indent(int n) { linesep_.resize(linesep_.size() + n, ' '); }
 
   // returns category with trailing dot
@@ -87,21 +107,21 @@ private:
   }
 
   void write_string(const std::string& s, size_t pos=0, bool to_lower=false) {
-    os_.put('"');
-    escape(os_, s, pos, to_lower);
-    os_.put('"');
+    out_ += '"';
+    escape(out_, s, pos, to_lower);
+    out_ += '"';
   }
 
   void write_as_number(const std::string& value) {
     // if we are here, value is not empty
     if (value[0] == '.') // in JSON numbers cannot start with dot
-      os_.put('0');
+      out_ += '0';
     // in JSON the number cannot start with +
     size_t pos = 0;
     if (value[pos] == '+') {
       pos = 1;
     } else if (value[pos] == '-') { // make handling -001 easier
-      os_.put('-');
+      out_ += '-';
       pos = 1;
     }
     // in JSON left-padding with 0s is not allowed
@@ -110,21 +130,22 @@ private:
     // in JSON dot must be followed by digit
     size_t dotpos = value.find('.');
     if (dotpos != std::string::npos && !std::isdigit(value[dotpos+1])) {
-      os_ << value.substr(pos, dotpos+1-pos) << '0';
+      out_.append(value, pos, dotpos+1-pos);
+      out_ += '0';
       pos = dotpos + 1;
     }
     if (value.back() != ')')
-      os_ << value.c_str() + pos;
+      out_.append(value, pos, std::string::npos);
     else
-      os_ << value.substr(pos, value.find('(', pos) - pos);
+      out_.append(value, pos, value.find('(', pos) - pos);
   }
 
   void write_value(const std::string& value) {
     if (value == "?")
-      os_ << "null";
+      out_ += "null";
     else if (value == ".")
-      os_ << opt.cif_dot;
-    else if (opt.quote_numbers < 2 && is_numb(value) &&
+      out_ += opt.cif_dot;
+    else if (opt.quote_numbers < 2 && may_be_numb(value) && is_numb(value) &&
              // exception: 012 (but not 0.12) is assumed to be a string
              (value[0] != '0' || value[1] == '.' || value[1] == '\0') &&
              (opt.quote_numbers == 0 || value.back() != ')'))
@@ -133,11 +154,43 @@ private:
       write_string(as_string(value));
   }
 
+  // the same as write_value(cif::quote(s)), without making a copy
+  void write_quoted_value(const std::string& s) {
+    if (!s.empty() && !is_null(s) &&
+        std::all_of(s.begin(), s.end(), [](char c) { return char_table(c) == 1; }))
+      write_value(s);
+    else
+      write_string(s);
+  }
+
+  // the same as write_value(std::to_string(n))
+  void write_int(int n) {
+    if (opt.quote_numbers == 2)
+      out_ += '"';
+    out_ += std::to_string(n);
+    if (opt.quote_numbers == 2)
+      out_ += '"';
+  }
+
+  // the same as write_value(to_str(x))
+  template<typename T>
+  void write_float(T x) {
+    if (!std::isfinite(x) || opt.quote_numbers == 2) {
+      write_value(to_str(x));
+      return;
+    }
+    // %g gives numbers that are valid in JSON
+    char buf[24];
+    int len = sprintf_z(buf, sizeof(T) == 4 ? "%.6g" : "%.9g", (double) x);
+    out_.append(buf, len > 0 ? len : 0);
+  }
+
   void open_cat(const std::string& cat, size_t* tag_pos) {
     if (!cat.empty()) {
       change_indent(+1);
       write_string(cat.substr(0, cat.size() - 1), opt.bare_tags ? 1 : 0, opt.lowercase_names);
-      os_ << ": {" << linesep_;
+      out_ += ": {";
+      out_ += linesep_;
       *tag_pos += cat.size() - 1;
     }
   }
@@ -145,12 +198,15 @@ private:
   void close_cat(std::string& cat, size_t* tag_pos) {
     if (!cat.empty()) {
       change_indent(-1);
-      os_ << linesep_ << '}';
+      out_ += linesep_;
+      out_ += '}';
       *tag_pos -= cat.size() - 1;
       cat.clear();
     }
   }
 
+  // Writes values of the loop column by column. If values are not given
+  // (loop.values is empty), they are taken from st_ (_atom_site only).
   void write_loop(const Loop& loop) {
     size_t ncol = loop.tags.size();
     const auto& vals = loop.values;
@@ -158,25 +214,152 @@ private:
     size_t tag_pos = opt.bare_tags ? 1 : 0;
     open_cat(cat, &tag_pos);
     for (size_t i = 0; i < ncol; i++) {
-      if (i != 0)
-        os_ << "," << linesep_;
+      if (i != 0) {
+        out_ += ',';
+        out_ += linesep_;
+      }
       write_string(loop.tags[i], tag_pos, opt.lowercase_names);
-      os_ << ": [";
-      for (size_t j = i; j < vals.size(); j += ncol) {
-        if (j != i)
-          os_.put(',');
-        write_value(vals[j]);
+      out_ += ": [";
+      if (vals.empty()) {
+        write_atom_site_column(loop.tags[i]);
+      } else {
+        for (size_t j = i; j < vals.size(); j += ncol) {
+          if (j != i)
+            out_ += ',';
+          write_value(vals[j]);
+        }
       }
-      os_.put(']');
+      out_ += ']';
+      flush_if_full();
     }
     close_cat(cat, &tag_pos);
   }
 
+  // calls func(model, chain, res, atom) for all atoms in st_
+  template<typename Func>
+  void for_each_atom(Func func) {
+    bool first = true;
+    for (const Model& model : st_->models)
+      for (const Chain& chain : model.chains)
+        for (const Residue& res : chain.residues)
+          for (const Atom& atom : res.atoms) {
+            if (!first)
+              out_ += ',';
+            first = false;
+            func(model, chain, res, atom);
+          }
+  }
+
+  // Writes values of one _atom_site column from st_. Must give the same
+  // output as writing values from add_cif_atoms() in to_mmcif.cpp.
+  void write_atom_site_column(const std::string& tag) {
+    using M = const Model&;
+    using C = const Chain&;
+    using R = const Residue&;
+    using A = const Atom&;
+    std::string name = tag.substr(tag.find('.') + 1);
+    if (name == "group_PDB") {
+      for_each_atom([&](M, C, R res, A) {
+        out_ += use_hetatm(res) ? "\"HETATM\"" : "\"ATOM\"";
+      });
+    } else if (name == "id") {
+      int serial = 0;
+      for_each_atom([&](M, C, R, A) { write_int(++serial); });
+    } else if (name == "type_symbol") {
+      for_each_atom([&](M, C, R, A atom) { write_value(atom.element.uname()); });
+    } else if (name == "label_atom_id" || name == "auth_atom_id") {
+      for_each_atom([&](M, C, R, A atom) { write_quoted_value(atom.name); });
+    } else if (name == "label_alt_id") {
+      for_each_atom([&](M, C, R, A atom) {
+        write_value(std::string(1, atom.altloc_or('.')));
+      });
+    } else if (name == "label_comp_id" || name == "auth_comp_id") {
+      for_each_atom([&](M, C, R res, A) { write_quoted_value(res.name); });
+    } else if (name == "label_asym_id") {
+      for_each_atom([&](M, C, R res, A) {
+        if (res.subchain.empty())
+          write_value(".");
+        else
+          write_quoted_value(res.subchain);
+      });
+    } else if (name == "label_entity_id") {
+      const Residue* prev = nullptr;
+      std::string entity_id;
+      for_each_atom([&](M, C, R res, A) {
+        if (&res != prev) {
+          prev = &res;
+          if (const Entity* ent = find_entity_of_subchain(res.subchain, st_->entities))
+            entity_id = quote(ent->name);
+          else
+            entity_id = res.entity_id.empty() ? "." : quote(res.entity_id);
+        }
+        write_value(entity_id);
+      });
+    } else if (name == "label_seq_id") {
+      for_each_atom([&](M, C, R res, A) { write_value(res.label_seq.str('.')); });
+    } else if (name == "pdbx_PDB_ins_code") {
+      for_each_atom([&](M, C, R res, A) {
+        write_value(std::string(1, res.seqid.has_icode() ? res.seqid.icode : '?'));
+      });
+    } else if (name == "Cartn_x") {
+      for_each_atom([&](M, C, R, A atom) { write_float(atom.pos.x); });
+    } else if (name == "Cartn_y") {
+      for_each_atom([&](M, C, R, A atom) { write_float(atom.pos.y); });
+    } else if (name == "Cartn_z") {
+      for_each_atom([&](M, C, R, A atom) { write_float(atom.pos.z); });
+    } else if (name == "occupancy") {
+      for_each_atom([&](M, C, R, A atom) { write_float(atom.occ); });
+    } else if (name == "B_iso_or_equiv") {
+      for_each_atom([&](M, C, R, A atom) { write_float(atom.b_iso); });
+    } else if (name == "pdbx_formal_charge") {
+      for_each_atom([&](M, C, R, A atom) {
+        if (atom.charge == 0)
+          write_value("?");
+        else
+          write_int(atom.charge);
+      });
+    } else if (name == "auth_seq_id") {
+      for_each_atom([&](M, C, R res, A) { write_value(res.seqid.num.str()); });
+    } else if (name == "auth_asym_id") {
+      for_each_atom([&](M, C chain, R, A) { write_quoted_value(chain.name); });
+    } else if (name == "pdbx_PDB_model_num") {
+      for_each_atom([&](M model, C, R, A) { write_int(model.num); });
+    } else if (name == "calc_flag") {
+      for_each_atom([&](M, C, R, A atom) {
+        write_value(&".\0.\0d\0c\0dum"[2 * (int) atom.calc_flag]);
+      });
+    } else if (name == "pdbx_tls_group_id") {
+      for_each_atom([&](M, C, R, A atom) {
+        if (atom.tls_group_id == -1)
+          write_value("?");
+        else
+          write_int(atom.tls_group_id);
+      });
+    } else if (name == "ccp4_deuterium_fraction") {
+      for_each_atom([&](M, C, R, A atom) { write_float(atom.fraction); });
+    } else {
+      fail("write_json: no values for ", tag);
+    }
+  }
+
+  bool has_values(const Loop& loop) const {
+    if (!loop.values.empty())
+      return true;
+    // loop with only tags, for values from Structure
+    if (!st_ || loop.tags.empty() || !starts_with(loop.tags[0], "_atom_site."))
+      return false;
+    for (const Model& model : st_->models)
+      for (const Chain& chain : model.chains)
+        for (const Residue& res : chain.residues)
+          if (!res.atoms.empty())
+            return true;
+    return false;
+  }
 
   // works for both block and frame
   void write_map(const std::string& name, const std::vector<Item>& items) {
     write_string(name, 0, opt.lowercase_names);
-    os_ << ": ";
+    out_ += ": ";
     change_indent(+1);
     char first = '{';
     bool has_frames = false;
@@ -189,25 +372,27 @@ private:
         case ItemType::Pair:
           if (!cat.empty() && !starts_with(item.pair[0], cat))
             close_cat(cat, &tag_pos);
-          os_ << first << linesep_;
+          out_ += first;
+          out_ += linesep_;
           if (opt.group_ddl2_categories && cat.empty()) {
             cat = get_tag_category(item.pair[0]);
             if (seen_cats.insert(cat).second)
               open_cat(cat, &tag_pos);
           }
           write_string(item.pair[0], tag_pos, opt.lowercase_names);
-          os_ << ": ";
+          out_ += ": ";
           if (opt.values_as_arrays)
-            os_.put('[');
+            out_ += '[';
           write_value(item.pair[1]);
           if (opt.values_as_arrays)
-            os_.put(']');
+            out_ += ']';
           first = ',';
           break;
         case ItemType::Loop:
-          if (!item.loop.values.empty()) {
+          if (has_values(item.loop)) {
             close_cat(cat, &tag_pos);
-            os_ << first << linesep_;
+            out_ += first;
+            out_ += linesep_;
             write_loop(item.loop);
             first = ',';
           }
@@ -222,28 +407,33 @@ private:
       }
     }
     if (has_frames) {  // usually, we don't have any frames
-      os_ << first << linesep_ << "\"Frames\": ";
+      out_ += first;
+      out_ += linesep_;
+      out_ += "\"Frames\": ";
       change_indent(+1);
       first = '{';
       for (const Item& item : items)
         if (item.type == ItemType::Frame) {
-          os_ << first << linesep_;
+          out_ += first;
+          out_ += linesep_;
           write_map(item.frame.name, item.frame.items);
           first = ',';
         }
       change_indent(-1);
-      os_ << linesep_ << '}';
+      out_ += linesep_;
+      out_ += '}';
     }
     close_cat(cat, &tag_pos);
     change_indent(-1);
-    os_ << linesep_ << '}';
+    out_ += linesep_;
+    out_ += '}';
   }
 };
 
 void JsonWriter::write_json(const Document& d) {
-  os_.put('{');
+  out_ += '{';
   if (opt.as_comcifs) {
-    os_ << R"(
+    out_ += R"(
  "CIF-JSON": {
   "Metadata": {
    "cif-version": "2.0",
@@ -255,23 +445,44 @@ void JsonWriter::write_json(const Document& d) {
   }
   for (const Block& block : d.blocks) {
     if (&block != &d.blocks[0])
-      os_.put(',');
+      out_ += ',';
     // start mmJSON with {"data_ so it can be easily recognized
     if (&block != &d.blocks[0] || opt.as_comcifs || !opt.with_data_keyword)
-      os_ << linesep_;
+      out_ += linesep_;
     write_map((opt.with_data_keyword ? "data_" : "") + block.name, block.items);
   }
   if (opt.as_comcifs)
-    os_ << "\n }";
-  os_ << "\n}\n";
+    out_ += "\n }";
+  out_ += "\n}\n";
+  os_.write(out_.data(), out_.size());
+  out_.clear();
 }
 
 
 void write_json_to_stream(std::ostream& os, const Document& doc, const JsonWriteOptions& options) {
-  cif::JsonWriter writer(os);
+  cif::JsonWriter writer(os, nullptr);
   writer.opt = options;
   writer.write_json(doc);
 }
 
 } // namespace cif
+
+void write_mmjson_with_atoms(std::ostream& os, const cif::Document& doc, const Structure& st) {
+  cif::JsonWriter writer(os, &st);
+  writer.opt = cif::JsonWriteOptions::mmjson();
+  writer.write_json(doc);
+}
+
+void write_structure_as_mmjson(std::ostream& os, const Structure& st,
+                               const MmcifOutputGroups& groups) {
+  cif::Document doc;
+  doc.blocks.resize(1);
+  impl::update_mmcif_block_without_atom_values(st, doc.blocks[0], groups);
+  write_mmjson_with_atoms(os, doc, st);
+}
+
+void write_structure_as_mmjson(std::ostream& os, const Structure& st) {
+  write_structure_as_mmjson(os, st, MmcifOutputGroups(true));
+}
+
 } // namespace gemmi
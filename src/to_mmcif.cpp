@@ -13,6 +13,7 @@
 #include <gemmi/enumstr.hpp>    // for entity_type_to_string, ...
 #include <gemmi/seqtools.hpp>   // for pdbx_one_letter_code, ...
 #include <gemmi/to_pdb.hpp>     // for use_hetatm
+#include <gemmi/profile.hpp>    // for GEMMI_PROFILE_SCOPE
 
 namespace gemmi {
 
@@ -59,8 +60,10 @@ inline std::string qchain(const std::string& s) {
 }
 
 
+// If with_values is false, _atom_site gets only tags (values are written
+// elsewhere); _atom_site_anisotrop is written anyway.
 void add_cif_atoms(const Structure& st, cif::Block& block,
-                   bool use_group_pdb, bool auth_all) {
+                   bool use_group_pdb, bool auth_all, bool with_values=true) {
   // atom list
   cif::Loop& atom_loop = block.init_mmcif_loop("_atom_site.", {
       "id",
@@ -109,7 +112,8 @@ void add_cif_atoms(const Structure& st, cif::Block& block,
     atom_loop.tags.emplace_back("_atom_site.ccp4_deuterium_fraction");
 
   std::vector<std::string>& vv = atom_loop.values;
-  vv.reserve(atom_site_count * atom_loop.tags.size());
+  if (with_values)
+    vv.reserve(atom_site_count * atom_loop.tags.size());
   std::vector<std::tuple<int, int, const Atom*>> aniso;
   int serial = 0;
   for (const Model& model : st.models) {
@@ -124,9 +128,14 @@ void add_cif_atoms(const Structure& st, cif::Block& block,
         else
           entity_id = string_or_dot(res.entity_id);
         for (const Atom& atom : res.atoms) {
+          ++serial;
+          if (atom.aniso.nonzero())
+            aniso.emplace_back(serial, model.num, &atom);
+          if (!with_values)
+            continue;
           if (use_group_pdb)
             vv.emplace_back(as_het ? "HETATM" : "ATOM");
-          vv.emplace_back(std::to_string(++serial));
+          vv.emplace_back(std::to_string(serial));
           vv.emplace_back(atom.element.uname());
           vv.emplace_back(cif::quote(atom.name));
           vv.emplace_back(1, atom.altloc_or('.'));
@@ -155,8 +164,6 @@ void add_cif_atoms(const Structure& st, cif::Block& block,
             vv.emplace_back(int_or_qmark(atom.tls_group_id));
           if (st.has_d_fraction)
             vv.emplace_back(to_str(atom.fraction));
-          if (atom.aniso.nonzero())
-            aniso.emplace_back(serial, model.num, &atom);
         }
       }
     }
@@ -457,7 +464,11 @@ void write_cispeps(const Structure& st, cif::Block& block) {
   }
 }
 
-void update_mmcif_block(const Structure& st, cif::Block& block, MmcifOutputGroups groups) {
+namespace {
+
+void update_block(const Structure& st, cif::Block& block, MmcifOutputGroups groups,
+                  bool atom_values) {
+  GEMMI_PROFILE_SCOPE("mmcif.update_block");
   if (st.models.empty())
     return;
 
@@ -1213,7 +1224,7 @@ void update_mmcif_block(const Structure& st, cif::Block& block, MmcifOutputGroup
   }
 
   if (groups.atoms)
-    add_cif_atoms(st, block, groups.group_pdb, groups.auth_all);
+    add_cif_atoms(st, block, groups.group_pdb, groups.auth_all, atom_values);
 
   if (groups.tls && st.meta.get_tls_groups() != nullptr) {
     // pdbx_refine_id doesn't make sense here, but it's required
@@ -1291,6 +1302,17 @@ void update_mmcif_block(const Structure& st, cif::Block& block, MmcifOutputGroup
   }
 }
 
+} // anonymous namespace
+
+void update_mmcif_block(const Structure& st, cif::Block& block, MmcifOutputGroups groups) {
+  update_block(st, block, groups, true);
+}
+
+void impl::update_mmcif_block_without_atom_values(const Structure& st, cif::Block& block,
+                                                  MmcifOutputGroups groups) {
+  update_block(st, block, groups, false);
+}
+
 cif::Document make_mmcif_document(const Structure& st, MmcifOutputGroups groups) {
   cif::Document doc;
   doc.blocks.resize(1);
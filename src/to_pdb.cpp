@@ -9,7 +9,9 @@
 #include <array>
 #include <sstream>       // for ostringstream
 
+#include <gemmi/assembly.hpp>   // for InstancedAssembly
 #include <gemmi/fail.hpp>       // for fail
+#include <gemmi/profile.hpp>    // for GEMMI_PROFILE_SCOPE
 #include <gemmi/sprintf.hpp>
 #include <gemmi/resinfo.hpp>    // for find_tabulated_residue
 #include <gemmi/util.hpp>
@@ -317,6 +319,7 @@ void write_chain_atoms(const Chain& chain, std::ostream& os,
 } // anonymous namespace
 
 void write_pdb(const Structure& st, std::ostream& os, PdbWriteOptions opt) {
+  GEMMI_PROFILE_SCOPE("pdb.write");
   // check if structure can be written as pdb
   for (const gemmi::Model& model : st.models)
     for (const gemmi::Chain& chain : model.chains)
@@ -706,6 +709,26 @@ void write_pdb(const Structure& st, std::ostream& os, PdbWriteOptions opt) {
     WRITE("%-80s", "END");
 }
 
+void write_assembly_pdb(const InstancedAssembly& assembly, std::ostream& os,
+                        PdbWriteOptions opt) {
+  for (const InstancedAssembly::ChainCopy& cc : assembly.chains)
+    if (cc.name.size() > 2)
+      gemmi::fail("chain name too long for the PDB format: " + cc.name);
+  char buf[88];
+  if (opt.cryst1_record) {
+    UnitCell cell;
+    WRITE("CRYST1%9.3f%9.3f%9.3f%7.2f%7.2f%7.2f %-11s%4s          ",
+          cell.a, cell.b, cell.c, cell.alpha, cell.beta, cell.gamma, "P 1", "");
+  }
+  if (opt.atom_records) {
+    int serial = 0;
+    for (const InstancedAssembly::ChainCopy& cc : assembly.chains)
+      write_chain_atoms(assembly.make_chain(cc), os, serial, opt);
+  }
+  if (opt.end_record)
+    WRITE("%-80s", "END");
+}
+
 std::string make_pdb_string(const Structure& st, PdbWriteOptions opt) {
   std::ostringstream os;
   write_pdb(st, os, opt);
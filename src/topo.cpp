@@ -7,9 +7,48 @@
 #include <gemmi/polyheur.hpp>  // for get_or_check_polymer_type, ...
 #include <gemmi/riding_h.hpp>  // for place_hydrogens_on_all_atoms, ...
 #include <gemmi/modify.hpp>    // for remove_hydrogens
+#include <gemmi/parallel.hpp>  // for parallel_chunks_with_logger
 
 namespace gemmi {
 
+namespace {
+
+// Residues from Topo::chain_infos split into contiguous chunks that can be
+// processed in parallel. Each chunk has own Logger; the messages are
+// collected and passed to the main logger in the original order,
+// so the output doesn't depend on the number of threads.
+struct ResidueChunks {
+  std::vector<std::pair<Topo::ChainInfo*, Topo::ResInfo*>> items;
+  std::vector<size_t> bounds;  // chunk n is [bounds[n], bounds[n+1])
+
+  ResidueChunks(Topo& topo, int n_threads) {
+    for (Topo::ChainInfo& ci : topo.chain_infos)
+      for (Topo::ResInfo& ri : ci.res_infos)
+        items.emplace_back(&ci, &ri);
+    // a few chunks per thread, for load balancing
+    size_t n = (size_t) normalize_thread_count(n_threads);
+    if (n > 1)
+      n = std::min(4 * n, items.size());
+    n = std::max(n, (size_t) 1);
+    for (size_t i = 0; i <= n; ++i)
+      bounds.push_back(i * items.size() / n);
+  }
+
+  size_t size() const { return bounds.size() - 1; }
+
+  // func(size_t chunk, const Logger&, Topo::ChainInfo&, Topo::ResInfo&)
+  template<typename Func>
+  void run(const Logger& logger, int n_threads, Func func) {
+    parallel_chunks_with_logger(size(), n_threads, logger,
+                                [&](size_t n, const Logger& chunk_logger) {
+      for (size_t i = bounds[n]; i != bounds[n+1]; ++i)
+        func(n, chunk_logger, *items[i].first, *items[i].second);
+    });
+  }
+};
+
+} // anonymous namespace
+
 std::unique_ptr<ChemComp> make_chemcomp_with_restraints(const Residue& res) {
   std::unique_ptr<ChemComp> cc(new ChemComp());
   cc->name = res.name;
@@ -587,30 +626,68 @@ void Topo::initialize_refmac_topology(Structure& st, Model& model0,
     }
 }
 
-void Topo::apply_all_restraints(const MonLib& monlib) {
+void Topo::apply_all_restraints(const MonLib& monlib, int n_threads) {
   bonds.clear();
   angles.clear();
   torsions.clear();
   chirs.clear();
   planes.clear();
   rt_storage.clear();
-  for (ChainInfo& chain_info : chain_infos)
-    for (ResInfo& ri : chain_info.res_infos) {
-      // link restraints
-      for (Link& link : ri.prev)
-        apply_restraints_from_link(link, monlib);
-      // monomer restraints
-      auto it = ri.chemcomps.cbegin();
-      ri.monomer_rules = apply_restraints(it->cc->rt, *ri.res, nullptr, Asu::Same,
-                                          it->altloc, '\0', /*require_alt=*/false);
-      while (++it != ri.chemcomps.end()) {
-        auto rules = apply_restraints(it->cc->rt, *ri.res, nullptr, Asu::Same,
-                                      it->altloc, '\0', /*require_alt=*/true);
-        // calling reserve avoids bogus GCC warning -Wstringop-overflow
-        ri.monomer_rules.reserve(ri.monomer_rules.size() + rules.size());
-        vector_move_extend(ri.monomer_rules, std::move(rules));
+  auto apply_to_residue = [&monlib](Topo& target, ResInfo& ri) {
+    // link restraints
+    for (Link& link : ri.prev)
+      target.apply_restraints_from_link(link, monlib);
+    // monomer restraints
+    auto it = ri.chemcomps.cbegin();
+    ri.monomer_rules = target.apply_restraints(it->cc->rt, *ri.res, nullptr, Asu::Same,
+                                               it->altloc, '\0', /*require_alt=*/false);
+    while (++it != ri.chemcomps.end()) {
+      auto rules = target.apply_restraints(it->cc->rt, *ri.res, nullptr, Asu::Same,
+                                           it->altloc, '\0', /*require_alt=*/true);
+      // calling reserve avoids bogus GCC warning -Wstringop-overflow
+      ri.monomer_rules.reserve(ri.monomer_rules.size() + rules.size());
+      vector_move_extend(ri.monomer_rules, std::move(rules));
+    }
+  };
+  ResidueChunks chunks(*this, n_threads);
+  if (chunks.size() == 1) {
+    for (auto& item : chunks.items)
+      apply_to_residue(*this, *item.second);
+  } else {
+    // Each chunk of residues has restraints stored in a separate Topo.
+    // Then the restraints are moved here and indices in Rules are shifted.
+    std::vector<std::unique_ptr<Topo>> parts(chunks.size());
+    chunks.run(logger, n_threads,
+               [&](size_t n, const Logger& chunk_logger, ChainInfo&, ResInfo& ri) {
+      if (!parts[n]) {
+        parts[n].reset(new Topo);
+        parts[n]->logger = chunk_logger;
+        parts[n]->only_bonds = only_bonds;
+      }
+      apply_to_residue(*parts[n], ri);
+    });
+    for (size_t n = 0; n != parts.size(); ++n) {
+      Topo& part = *parts[n];
+      const size_t offsets[5] = {bonds.size(), angles.size(), torsions.size(),
+                                 chirs.size(), planes.size()};
+      auto shift_rules = [&](std::vector<Rule>& rules) {
+        for (Rule& rule : rules)
+          rule.index += offsets[static_cast<int>(rule.rkind)];
+      };
+      for (size_t i = chunks.bounds[n]; i != chunks.bounds[n+1]; ++i) {
+        ResInfo& ri = *chunks.items[i].second;
+        for (Link& link : ri.prev)
+          shift_rules(link.link_rules);
+        shift_rules(ri.monomer_rules);
       }
+      vector_move_extend(bonds, std::move(part.bonds));
+      vector_move_extend(angles, std::move(part.angles));
+      vector_move_extend(torsions, std::move(part.torsions));
+      vector_move_extend(chirs, std::move(part.chirs));
+      vector_move_extend(planes, std::move(part.planes));
+      vector_move_extend(rt_storage, std::move(part.rt_storage));
     }
+  }
   for (Link& link : extras)
     apply_restraints_from_link(link, monlib);
 }
@@ -897,13 +974,13 @@ void add_hydrogens_without_positions(Topo::ResInfo& ri, const NeighMap& neighbor
   }
 }
 
-NeighMap prepare_neighbor_altlocs(Topo& topo, const MonLib& monlib) {
+NeighMap prepare_neighbor_altlocs(Topo& topo, const MonLib& monlib, int n_threads) {
   // disable warnings here, so they are not printed twice
   topo.logger.suspend();
   // Prepare bonds. Fills topo.bonds, monomer_rules/link_rules and rt_storage,
   // but they are all reset when apply_all_restraints() is called again.
   topo.only_bonds = true;
-  topo.apply_all_restraints(monlib);
+  topo.apply_all_restraints(monlib, n_threads);
   topo.only_bonds = false;
   topo.logger.resume(); // re-enable warnings
   NeighMap neighbors;
@@ -923,7 +1000,8 @@ NeighMap prepare_neighbor_altlocs(Topo& topo, const MonLib& monlib) {
 std::unique_ptr<Topo>
 prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
                  HydrogenChange h_change, bool reorder,
-                 const Logger& logger, bool ignore_unknown_links, bool use_cispeps) {
+                 const Logger& logger, bool ignore_unknown_links, bool use_cispeps,
+                 int n_threads) {
   std::unique_ptr<Topo> topo(new Topo);
   topo->logger = logger;
   if (model_index >= st.models.size())
@@ -934,10 +1012,16 @@ prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
   if (use_cispeps)
     force_cispeps(*topo, st.models.size() == 1, model, st.cispeps);
 
+  // Loops over residues below can run in parallel. Residues are modified
+  // independently; messages are passed to the logger in the usual order.
+  ResidueChunks chunks(*topo, n_threads);
+
   // remove hydrogens, or change deuterium to fraction, or nothing
   // and then check atom names
-  for (Topo::ChainInfo& chain_info : topo->chain_infos)
-    for (Topo::ResInfo& ri : chain_info.res_infos) {
+  std::vector<char> has_d_fraction(chunks.size(), 0);
+  chunks.run(topo->logger, n_threads,
+             [&](size_t n, const Logger& chunk_logger, Topo::ChainInfo& chain_info,
+                 Topo::ResInfo& ri) {
       Residue& res = *ri.res;
       if (h_change != HydrogenChange::NoChange && h_change != HydrogenChange::Shift
           // don't re-add H's if we don't have chemical component description
@@ -955,7 +1039,7 @@ prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
               if (cc.find_atom(atom.name) == cc.atoms.end())
                 atom.name[0] = 'H';
             }
-          st.has_d_fraction = true;
+          has_d_fraction[n] = 1;
         }
       }
       // check atom names
@@ -971,18 +1055,20 @@ prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
             if (it != cc.atoms.end())
               cat_to(msg, " (replace ", atom.name, " with ", it->id, ')');
           }
-          topo->logger.err(msg);
+          chunk_logger.err(msg);
         }
       }
-    }
+  });
+  if (in_vector((char)1, has_d_fraction))
+    st.has_d_fraction = true;
 
   // add hydrogens
   if (h_change == HydrogenChange::ReAdd ||
       h_change == HydrogenChange::ReAddButWater ||
       h_change == HydrogenChange::ReAddKnown) {
-    NeighMap neighbor_altlocs = prepare_neighbor_altlocs(*topo, monlib);
-    for (Topo::ChainInfo& chain_info : topo->chain_infos)
-      for (Topo::ResInfo& ri : chain_info.res_infos) {
+    NeighMap neighbor_altlocs = prepare_neighbor_altlocs(*topo, monlib, n_threads);
+    chunks.run(topo->logger, n_threads,
+               [&](size_t, const Logger&, Topo::ChainInfo&, Topo::ResInfo& ri) {
         Residue& res = *ri.res;
         if (ri.orig_chemcomp != nullptr &&
             (h_change == HydrogenChange::ReAdd || !res.is_water())) {
@@ -995,13 +1081,15 @@ prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
                 atom.occ = 0;
           }
         }
-      }
+    });
   }
 
   // sort atoms in residues
-  for (Topo::ChainInfo& chain_info : topo->chain_infos)
-    for (Topo::ResInfo& ri : chain_info.res_infos)
-      if (reorder && ri.orig_chemcomp) {
+  if (reorder)
+    chunks.run(topo->logger, n_threads,
+               [&](size_t, const Logger& chunk_logger, Topo::ChainInfo& chain_info,
+                   Topo::ResInfo& ri) {
+      if (ri.orig_chemcomp) {
         Residue& res = *ri.res;
         const ChemComp& cc = *ri.orig_chemcomp;
         for (Atom& atom : res.atoms) {
@@ -1017,8 +1105,9 @@ prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
         // check for missing altloc
         for (auto atom = res.atoms.begin(); atom + 1 < res.atoms.end(); ++atom)
           if (atom->name == (atom + 1)->name && atom->altloc == '\0')
-            topo->logger.err("missing altloc in ", atom_str(chain_info.chain_ref, *ri.res, *atom));
+            chunk_logger.err("missing altloc in ", atom_str(chain_info.chain_ref, *ri.res, *atom));
       }
+    });
 
   // for atoms with ad-hoc links, for now we don't want hydrogens
   if (!ignore_unknown_links && h_change != HydrogenChange::NoChange) {
@@ -1039,13 +1128,13 @@ prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
   }
 
   // fill Topo::bonds, angles, ... and ResInfo::monomer_rules, Links::link_rules
-  topo->apply_all_restraints(monlib);
+  topo->apply_all_restraints(monlib, n_threads);
   // fill bond_index, angle_index, etc
   topo->create_indices();
 
   // the hydrogens added previously have positions not set
   if (h_change != HydrogenChange::NoChange)
-    place_hydrogens_on_all_atoms(*topo);
+    place_hydrogens_on_all_atoms(*topo, n_threads);
 
   if (h_change == HydrogenChange::ReAddKnown) {
     // To leave only known hydrogens, we remove Hs with zero occupancy.
@@ -1057,7 +1146,7 @@ prepare_topology(Structure& st, MonLib& monlib, size_t model_index,
     // disable warnings here, so they are not printed twice
     topo->logger.suspend();
     // re-set restraints and indices
-    topo->apply_all_restraints(monlib);
+    topo->apply_all_restraints(monlib, n_threads);
     topo->create_indices();
     topo->logger.resume();
   }
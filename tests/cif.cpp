@@ -2,7 +2,18 @@
 #include "doctest.h"
 
 #include <algorithm>
+#include <cstdio>     // for remove
+#include <fstream>    // for ifstream
+#include <iterator>   // for istreambuf_iterator
+#include <sstream>
 #include <gemmi/read_cif.hpp>
+#include <gemmi/binfile.hpp>   // for write_binary_structure, ...
+#include <gemmi/mmread_gz.hpp> // for read_structure_gz
+#include <gemmi/json.hpp>      // for read_mmjson_insitu
+#include <gemmi/mmcif.hpp>     // for make_structure_from_mmjson_insitu
+#include <gemmi/to_json.hpp>   // for write_structure_as_mmjson
+#include <gemmi/to_mmcif.hpp>  // for make_mmcif_document
+#include <gemmi/version.hpp>   // for GEMMI_VERSION
 
 namespace cif = gemmi::cif;
 
@@ -87,3 +98,146 @@ TEST_CASE("cif::Block::init_loop") {
   CHECK_EQ(block.find_values("_p.u").item(), nullptr);
   CHECK_EQ(block.find_values("_p.v").at(0), "30");
 }
+
+TEST_CASE("make_structure_from_mmjson_insitu") {
+  const char* json = R"({"data_TEST": {
+    "cell": {"length_a": [10.0], "length_b": [20], "length_c": [30],
+             "angle_alpha": [90], "angle_beta": [90], "angle_gamma": [90]},
+    "symmetry": {"space_group_name_H-M": ["P 1"]},
+    "atom_site": {
+      "group_PDB": ["ATOM", "ATOM", "HETATM"],
+      "id": [1, 2, 3],
+      "type_symbol": ["N", "C", "O"],
+      "label_atom_id": ["N", "CA", "O"],
+      "label_alt_id": [null, "A", null],
+      "label_comp_id": ["GLY", "GLY", "H\u004fH"],
+      "label_asym_id": ["A", "A", "B"],
+      "label_seq_id": [1, 1, null],
+      "Cartn_x": [1.5, -2, 3e1],
+      "Cartn_y": [0, 0, 0],
+      "Cartn_z": [0, 0, 0],
+      "occupancy": [1, 0.5, 1],
+      "B_iso_or_equiv": [10, 20, 30],
+      "auth_seq_id": [1, 1, 5],
+      "auth_asym_id": ["A", "A", "A"],
+      "pdbx_PDB_model_num": [1, 1, 1]}}})";
+  std::string buf1(json), buf2(json);
+  gemmi::Structure st = gemmi::make_structure_from_mmjson_insitu(&buf1[0], buf1.size());
+  gemmi::Structure ref = gemmi::make_structure(
+      cif::read_mmjson_insitu(&buf2[0], buf2.size()));
+  CHECK_EQ(st.input_format, gemmi::CoorFormat::Mmjson);
+  CHECK_EQ(st.cell.b, 20.);
+  CHECK_EQ(st.spacegroup_hm, "P 1");
+  REQUIRE_EQ(st.models.size(), 1);
+  const gemmi::Chain& chain = st.models[0].chains.at(0);
+  REQUIRE_EQ(chain.residues.size(), 2);
+  CHECK_EQ(chain.residues[1].name, "HOH");
+  CHECK_EQ(chain.residues[1].het_flag, 'H');
+  CHECK_EQ(chain.residues[1].subchain, "B");
+  const gemmi::Atom& ca = chain.residues[0].atoms.at(1);
+  CHECK_EQ(ca.altloc, 'A');
+  CHECK_EQ(ca.occ, 0.5f);
+  CHECK_EQ(ca.pos.x, -2.);
+  CHECK_EQ(chain.residues[1].atoms.at(0).pos.x, 30.);
+  // the same as via cif::Document
+  REQUIRE_EQ(ref.models[0].chains.size(), st.models[0].chains.size());
+  for (size_t i = 0; i != chain.residues.size(); ++i) {
+    const gemmi::Residue& r1 = chain.residues[i];
+    const gemmi::Residue& r2 = ref.models[0].chains[0].residues.at(i);
+    CHECK_EQ(r1.name, r2.name);
+    CHECK_EQ(r1.seqid, r2.seqid);
+    CHECK_EQ(r1.label_seq, r2.label_seq);
+    CHECK_EQ(r1.entity_type, r2.entity_type);
+    REQUIRE_EQ(r1.atoms.size(), r2.atoms.size());
+    for (size_t j = 0; j != r1.atoms.size(); ++j) {
+      CHECK_EQ(r1.atoms[j].name, r2.atoms[j].name);
+      CHECK_EQ(r1.atoms[j].altloc, r2.atoms[j].altloc);
+      CHECK_EQ(r1.atoms[j].serial, r2.atoms[j].serial);
+      CHECK_EQ(r1.atoms[j].pos.x, r2.atoms[j].pos.x);
+      CHECK_EQ(r1.atoms[j].b_iso, r2.atoms[j].b_iso);
+    }
+  }
+  std::string bad = R"({"data_X": {"atom_site": {"id": [1, 2], "Cartn_x": [1]}}})";
+  CHECK_THROWS(gemmi::make_structure_from_mmjson_insitu(&bad[0], bad.size()));
+}
+
+TEST_CASE("write_structure_as_mmjson") {
+  gemmi::Structure st;
+  st.name = "TEST";
+  st.cell.set(10., 20., 30., 90., 90., 90.);
+  gemmi::Model model(1);
+  model.chains.emplace_back("A");
+  gemmi::Residue res;
+  res.name = "GLY";
+  res.seqid = gemmi::SeqId(5, 'B');
+  res.subchain = "A1";
+  for (const char* name : {"N", "CA", "C'1", "O 2"}) {
+    gemmi::Atom atom;
+    atom.name = name;
+    atom.element = gemmi::El::C;
+    atom.pos = gemmi::Position(1.25, -0.5, 1e-7);
+    atom.b_iso = 12.345f;
+    res.atoms.push_back(atom);
+  }
+  res.atoms[1].altloc = 'A';
+  res.atoms[2].charge = -1;
+  res.atoms[3].calc_flag = gemmi::CalcFlag::Calculated;
+  model.chains[0].residues.push_back(res);
+  st.models.push_back(model);
+  // _atom_site values written directly from Structure
+  std::ostringstream direct, via_doc;
+  gemmi::write_structure_as_mmjson(direct, st);
+  cif::write_mmjson_to_stream(via_doc, gemmi::make_mmcif_document(st));
+  CHECK_EQ(direct.str(), via_doc.str());
+  CHECK_NE(direct.str().find(R"("label_atom_id": ["N","CA","C'1","O 2"])"),
+           std::string::npos);
+}
+
+TEST_CASE("binary_structure_and_document") {
+  cif::Document doc = cif::read_string("data_a _x 1 loop_ _p _q 1 2 3 ? "
+                                       "save_f _y 'z z' save_");
+  std::string buf1 = R"({"data_B": {"atom_site": {"id": [1, 2],
+      "type_symbol": ["C", "O"], "label_atom_id": ["C", "O"],
+      "label_alt_id": [null, null],
+      "label_comp_id": ["ACE", "ACE"], "label_asym_id": ["A", "A"],
+      "Cartn_x": [1.5, 2], "Cartn_y": [0, 0], "Cartn_z": [0, -1],
+      "auth_seq_id": [1, 1], "auth_asym_id": ["A", "A"]}}})";
+  gemmi::Structure st = gemmi::make_structure_from_mmjson_insitu(&buf1[0], buf1.size());
+  const char* st_path = "gemmi-test-tmp.bin";
+  const char* doc_path = "gemmi-test-tmp-doc.bin";
+  gemmi::write_binary_structure(st, st_path);
+  gemmi::write_binary_document(doc, doc_path);
+
+  gemmi::Structure st2 = gemmi::read_structure_gz(st_path);
+  CHECK_EQ(st2.name, "B");
+  CHECK_EQ(st2.input_format, gemmi::CoorFormat::Mmjson);
+  const gemmi::Residue& res = st2.models.at(0).chains.at(0).residues.at(0);
+  REQUIRE_EQ(res.atoms.size(), 2);
+  const gemmi::Atom& atom = res.atoms[1];
+  CHECK_EQ(atom.name, "O");
+  CHECK_EQ(atom.pos.z, -1.);
+  gemmi::Structure st3 = gemmi::read_structure_gz(st_path, gemmi::CoorFormat::Detect);
+  CHECK_EQ(st3.models.at(0).chains.at(0).residues.at(0).atoms.size(), 2);
+
+  cif::Document doc2 = gemmi::read_binary_document(doc_path);
+  REQUIRE_EQ(doc2.blocks.size(), 1);
+  CHECK_EQ(*doc2.blocks[0].find_value("_x"), "1");
+  CHECK_EQ(doc2.blocks[0].find_values("_q").str(1), "");
+  CHECK_EQ(*doc2.blocks[0].find_frame("f")->find_value("_y"), "'z z'");
+  CHECK_THROWS(gemmi::read_binary_structure(doc_path));
+  CHECK_THROWS(gemmi::read_binary_document(st_path));
+
+  // files from other gemmi versions are rejected
+  std::ifstream st_file(st_path, std::ios::binary);
+  std::string bin((std::istreambuf_iterator<char>(st_file)),
+                  std::istreambuf_iterator<char>());
+  CHECK_NOTHROW(gemmi::read_binary_structure_from_memory(bin.data(), bin.size(), "b"));
+  size_t pos = bin.find(GEMMI_VERSION);
+  REQUIRE(pos != std::string::npos);
+  bin[pos] = 'x';
+  CHECK_THROWS_WITH(gemmi::read_binary_structure_from_memory(bin.data(), bin.size(), "b"),
+                    doctest::Contains("written by gemmi x"));
+  st_file.close();
+  std::remove(st_path);
+  std::remove(doc_path);
+}
@@ -10,6 +10,20 @@
 #include <gemmi/it92.hpp>
 #include <gemmi/util.hpp>  // for is_in_list
 #include <gemmi/asudata.hpp>  // for ComplexCorrelation
+#include <gemmi/grid.hpp>
+#include <gemmi/solmask.hpp>  // for SolventMasker
+#include <gemmi/edt.hpp>
+#include <gemmi/floodfill.hpp>  // for GridComponents
+#include <gemmi/blob.hpp>  // for find_blobs_by_flood_fill
+#include <gemmi/reciproc.hpp>  // for ReflnProperties
+#include <gemmi/select.hpp>  // for SelectionMask
+#include <gemmi/profile.hpp>  // for Profiler
+#include <gemmi/atomarr.hpp>  // for copy_atoms_to_arrays
+#include <gemmi/binfile.hpp>  // for write_binary_structure
+#include <gemmi/mmread.hpp>  // for read_structure
+#include <gemmi/mmread_gz.hpp>  // for read_structure_gz
+#include <gemmi/gz.hpp>  // for MaybeGzipped
+#include <cstdio>  // for remove
 #include <linalg.h>
 
 static double draw() { return 10.0 * std::rand() / RAND_MAX - 5; }
@@ -183,3 +197,439 @@ TEST_CASE("vector_Vec3") {
   auto offset = x1 - x0;
   CHECK_EQ(offset, 3);
 }
+
+TEST_CASE("Grid::interpolate_position_array") {
+  std::srand(12345);
+  gemmi::Grid<double> grid;
+  grid.set_size(10, 12, 15);
+  grid.set_unit_cell(20, 25, 30, 80, 95, 100);
+  for (double& x : grid.data)
+    x = draw();
+  std::vector<gemmi::Vec3> points;
+  for (int i = 0; i < 20; ++i)
+    points.emplace_back(10 * draw(), 10 * draw(), 10 * draw());
+  std::vector<double> values(points.size());
+  std::vector<gemmi::Vec3> grad(points.size());
+  const double h = 1e-6;
+  for (int order : {1, 3}) {
+    grid.interpolate_position_array(points.data(), points.size(), values.data(),
+                                    order, nullptr, grad.data());
+    for (size_t i = 0; i < points.size(); ++i) {
+      gemmi::Position pos(points[i]);
+      CHECK_EQ(values[i], doctest::Approx(grid.interpolate_value(pos, order)));
+      for (int j = 0; j < 3; ++j) {
+        gemmi::Position pos1 = pos, pos2 = pos;
+        pos1.at(j) -= h;
+        pos2.at(j) += h;
+        double numeric = (grid.interpolate_value(pos2, order) -
+                          grid.interpolate_value(pos1, order)) / (2 * h);
+        CHECK_EQ(grad[i].at(j), doctest::Approx(numeric).epsilon(1e-4));
+      }
+    }
+  }
+  gemmi::Grid<double> dest1, dest2;
+  dest1.set_size(8, 9, 10);
+  dest1.set_unit_cell(grid.unit_cell);
+  dest2 = dest1;
+  gemmi::Transform tr = random_transform();
+  gemmi::interpolate_grid(dest1, grid, tr, 3, 1);
+  gemmi::interpolate_grid(dest2, grid, tr, 3, 3);
+  CHECK(dest1.data == dest2.data);
+}
+
+TEST_CASE("SolventMasker::n_threads") {
+  std::srand(12345);
+  gemmi::Model model(1);
+  model.chains.emplace_back("A");
+  model.chains[0].residues.emplace_back();
+  gemmi::Residue& res = model.chains[0].residues[0];
+  for (int i = 0; i < 60; ++i) {
+    gemmi::Atom atom;
+    atom.element = gemmi::El::C;
+    atom.occ = 1.f;
+    atom.pos = gemmi::Position(3 * draw(), 4 * draw(), 2 * draw());
+    res.atoms.push_back(atom);
+  }
+  gemmi::Grid<float> grid1, grid2;
+  grid1.spacegroup = gemmi::find_spacegroup_by_name("P 21 21 21");
+  grid1.set_unit_cell(30, 40, 20, 90, 90, 90);
+  grid1.set_size_from_spacing(0.7, gemmi::GridSizeRounding::Up);
+  grid2.copy_metadata_from(grid1);
+  gemmi::SolventMasker masker(gemmi::AtomicRadiiSet::Refmac);
+  masker.put_mask_on_grid(grid1, model);
+  masker.n_threads = 3;
+  masker.put_mask_on_grid(grid2, model);
+  CHECK(grid1.data == grid2.data);
+}
+
+TEST_CASE("mask_points_in_radius::far_atoms") {
+  gemmi::Model model(1);
+  model.chains.emplace_back("A");
+  model.chains[0].residues.emplace_back();
+  gemmi::Atom atom;
+  atom.element = gemmi::El::C;
+  atom.occ = 1.f;
+  // several unit cells away from the origin, in both directions
+  for (double z : {2.25, -3.4})
+    for (double x : {0.1, 4.5}) {
+      atom.pos = gemmi::Position(20 * x, 0, 20 * z);
+      model.chains[0].residues[0].atoms.push_back(atom);
+    }
+  gemmi::Grid<float> grid1, grid2;
+  grid1.set_unit_cell(20, 20, 20, 90, 90, 90);
+  grid1.set_size(40, 40, 40);
+  grid2 = grid1;
+  gemmi::mask_points_in_radius(grid1, model, gemmi::AtomicRadiiSet::Constant,
+                               2.0, 1.f, false, false, 1);
+  gemmi::mask_points_in_radius(grid2, model, gemmi::AtomicRadiiSet::Constant,
+                               2.0, 1.f, false, false, 4);
+  CHECK(grid1.sum() > 4 * 250);
+  CHECK(grid1.data == grid2.data);
+}
+
+TEST_CASE("Grid::symmetrize::incompatible") {
+  gemmi::Grid<float> grid;
+  grid.spacegroup = gemmi::find_spacegroup_by_name("P 21 21 21");
+  grid.set_unit_cell(30, 40, 20, 90, 90, 90);
+  grid.set_size_without_checking(10, 11, 12);
+  CHECK_THROWS(grid.symmetrize_max());
+  CHECK_THROWS(grid.symmetrize([](float a, float b) { return a + b; }, 2));
+  grid.set_size(10, 12, 12);
+  CHECK_NOTHROW(grid.symmetrize([](float a, float b) { return a + b; }, 2));
+}
+
+TEST_CASE("find_blobs_by_flood_fill") {
+  gemmi::Grid<float> grid;
+  grid.spacegroup = gemmi::find_spacegroup_by_name("P 1 21 1");
+  grid.set_unit_cell(20, 16, 24, 90, 100, 90);
+  grid.set_size(20, 16, 24);
+  grid.fill(0.f);
+  // a blob that crosses the cell boundary in u and w (and its image)
+  for (int w = -1; w <= 1; ++w)
+    for (int v = 3; v <= 5; ++v)
+      for (int u = -2; u <= 1; ++u)
+        grid.set_value(u, v, w, 2.f - 0.1f * (u * u + w * w));
+  // a layer connected to its own images along u and v (percolating)
+  for (int v = 0; v < grid.nv; ++v)
+    for (int u = 0; u < grid.nu; ++u)
+      grid.set_value(u, v, 10, 1.5f);
+  // a point equal to the cutoff is not a blob
+  grid.set_value(10, 10, 18, 1.f);
+  grid.symmetrize_max();
+  gemmi::BlobCriteria criteria;
+  criteria.cutoff = 1.0;
+  criteria.min_volume = 0;
+  criteria.min_score = 0;
+  std::vector<gemmi::Blob> blobs1 = gemmi::find_blobs_by_flood_fill(grid, criteria);
+  std::vector<gemmi::Blob> blobs3 = gemmi::find_blobs_by_flood_fill(grid, criteria,
+                                                                    false, 3);
+  REQUIRE(blobs1.size() == 2);
+  REQUIRE(blobs3.size() == 2);
+  double point_volume = grid.unit_cell.volume / grid.point_count();
+  CHECK(blobs1[0].volume == doctest::Approx(grid.nu * grid.nv * point_volume));
+  CHECK(blobs1[1].volume == doctest::Approx(36 * point_volume));
+  CHECK(blobs1[1].peak_value == doctest::Approx(2.f));
+  // centroid of the blob or of its symmetry image, unwrapped
+  double d = std::min(blobs1[1].centroid.dist(grid.get_position(0, 4, 0)),
+                      blobs1[1].centroid.dist(grid.get_position(0, 12, 0)));
+  CHECK(d < 1.0);
+  for (size_t i = 0; i != 2; ++i) {
+    CHECK(blobs1[i].score == doctest::Approx(blobs3[i].score));
+    CHECK(blobs1[i].centroid.dist(blobs3[i].centroid) < 1e-6);
+  }
+}
+
+TEST_CASE("squared_distance_transform") {
+  std::srand(12345);
+  gemmi::Grid<std::int8_t> grid;
+  grid.set_size(12, 10, 16);
+  for (std::int8_t& x : grid.data)
+    x = std::rand() % 50 == 0 ? 1 : 0;
+  auto is_site = [](std::int8_t x) { return x != 0; };
+  for (double gamma : {90., 100.}) {
+    grid.set_unit_cell(15, 12, 20, 90, 90, gamma);
+    for (double max_dist : {2.3, 100.}) {
+      gemmi::Grid<float> out;
+      gemmi::squared_distance_transform(grid, is_site, out, max_dist, 3);
+      for (int w = 0; w < grid.nw; ++w)
+        for (int v = 0; v < grid.nv; ++v)
+          for (int u = 0; u < grid.nu; ++u) {
+            double expected = INFINITY;
+            for (auto p : grid)
+              if (*p.value != 0) {
+                gemmi::Fractional d = grid.get_fractional(p.u - u, p.v - v, p.w - w);
+                d = d.wrap_to_zero();
+                for (int i = -1; i <= 1; ++i)
+                  for (int j = -1; j <= 1; ++j)
+                    for (int k = -1; k <= 1; ++k) {
+                      gemmi::Fractional image(d.x + i, d.y + j, d.z + k);
+                      double d2 = grid.unit_cell.orthogonalize_difference(image).length_sq();
+                      expected = std::min(expected, d2);
+                    }
+              }
+            float value = out.get_value_q(u, v, w);
+            if (expected > max_dist * max_dist)
+              CHECK(std::isinf(value));
+            else
+              CHECK_EQ(value, doctest::Approx(expected));
+          }
+    }
+  }
+}
+
+TEST_CASE("GridComponents") {
+  std::srand(2345);
+  gemmi::Grid<std::int8_t> grid;
+  grid.set_size(14, 9, 20);
+  for (std::int8_t& x : grid.data)
+    x = std::rand() % 3 == 0 ? 1 : 0;
+  // a line through the cell makes a percolating component
+  for (int w = 0; w < grid.nw; ++w)
+    grid.set_value(3, 4, w, 1);
+  gemmi::GridComponents c;
+  c.label(grid, [](std::int8_t x) { return x != 0; }, 3);
+  // reference labeling by breadth-first search
+  std::vector<int> label(grid.data.size(), -1);
+  int n_labels = 0;
+  for (size_t start = 0; start != grid.data.size(); ++start) {
+    if (grid.data[start] == 0 || label[start] != -1)
+      continue;
+    std::vector<size_t> queue(1, start);
+    label[start] = n_labels;
+    for (size_t j = 0; j < queue.size(); ++j) {
+      auto p = grid.index_to_point(queue[j]);
+      const int moves[6][3] = {{-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1}};
+      for (const auto& m : moves) {
+        size_t idx = grid.index_s(p.u + m[0], p.v + m[1], p.w + m[2]);
+        if (grid.data[idx] != 0 && label[idx] == -1) {
+          label[idx] = n_labels;
+          queue.push_back(idx);
+        }
+      }
+    }
+    ++n_labels;
+  }
+  std::vector<int> root_of_label(n_labels, -1);
+  std::vector<int> label_of_root(c.runs.size(), -1);
+  for (auto p : grid) {
+    int run = c.run_at(p.u, p.v, p.w);
+    if (*p.value == 0) {
+      CHECK(run == -1);
+      continue;
+    }
+    REQUIRE(run >= 0);
+    int root = c.parent[run];
+    int lab = label[grid.index_q(p.u, p.v, p.w)];
+    if (root_of_label[lab] == -1)
+      root_of_label[lab] = root;
+    if (label_of_root[root] == -1)
+      label_of_root[root] = lab;
+    CHECK(root_of_label[lab] == root);
+    CHECK(label_of_root[root] == lab);
+    // unwrapped coordinates (u + shift[0] * nu, ...) of neighbors differ by 1
+    if (c.percolating[root])
+      continue;
+    for (int axis = 0; axis < 3; ++axis) {
+      int q[3] = {p.u, p.v, p.w};
+      const int n[3] = {grid.nu, grid.nv, grid.nw};
+      int wrap = 0;
+      if (++q[axis] == n[axis]) {
+        q[axis] = 0;
+        wrap = 1;
+      }
+      int run2 = c.run_at(q[0], q[1], q[2]);
+      if (run2 >= 0)
+        CHECK(c.shift[run2][axis] == c.shift[run][axis] + wrap);
+    }
+  }
+  int root = c.parent[c.run_at(3, 4, 0)];
+  CHECK(c.percolating[root]);
+}
+
+TEST_CASE("ReflnProperties") {
+  std::vector<gemmi::Miller> hkls;
+  for (int h = -4; h <= 4; ++h)
+    for (int k = -4; k <= 4; ++k)
+      for (int l = -5; l <= 5; ++l)
+        hkls.push_back({{h, k, l}});
+  gemmi::UnitCell cell(30, 30, 40, 90, 90, 120);
+  for (const char* hm : {"P 1", "P -1", "C 1 2 1", "I 1 2 1", "P 21 21 21",
+                         "P 61 2 2", "R 3 :H", "P 4 3 2", "F d -3 c"}) {
+    const gemmi::SpaceGroup* sg = gemmi::find_spacegroup_by_name(hm);
+    REQUIRE(sg != nullptr);
+    gemmi::GroupOps gops = sg->operations();
+    gemmi::ReciprocalAsu asu(sg);
+    gemmi::ReflnProperties props;
+    props.calculate(hkls, cell, sg, 2);
+    REQUIRE(props.size() == hkls.size());
+    for (size_t i = 0; i != hkls.size(); ++i) {
+      auto expected = asu.to_asu(hkls[i], gops);
+      CHECK(props.asu_hkl[i] == expected.first);
+      CHECK(props.isym[i] == expected.second);
+      CHECK(props.epsilon[i] == gops.epsilon_factor(hkls[i]));
+      CHECK((props.centric[i] != 0) == gops.is_reflection_centric(hkls[i]));
+      CHECK(props.inv_d2[i] == cell.calculate_1_d2(hkls[i]));
+    }
+  }
+}
+
+TEST_CASE("SelectionMask") {
+  std::srand(4321);
+  gemmi::Model model(1);
+  const char* res_names[] = {"ALA", "GLY", "HOH", "SER"};
+  const char* atom_names[] = {"N", "CA", "C", "O", "CB"};
+  for (const char* chain_name : {"A", "B", "C"}) {
+    model.chains.emplace_back(chain_name);
+    for (int i = 0; i < 30; ++i) {
+      gemmi::Residue res;
+      res.name = res_names[std::rand() % 4];
+      res.seqid = gemmi::SeqId(i + 1, ' ');
+      for (int j = std::rand() % 6; j > 0; --j) {
+        gemmi::Atom atom;
+        atom.name = atom_names[std::rand() % 5];
+        atom.element = atom.name[0] == 'C' ? gemmi::El::C : gemmi::El::N;
+        atom.b_iso = float(std::rand() % 50);
+        res.atoms.push_back(atom);
+      }
+      model.chains.back().residues.push_back(res);
+    }
+  }
+  auto count_selected = [&](const gemmi::Selection& sel) {
+    size_t n = 0;
+    if (!sel.matches(model))
+      return n;
+    for (gemmi::Chain& chain : sel.chains(model))
+      for (gemmi::Residue& res : sel.residues(chain))
+        for (gemmi::Atom& atom : sel.atoms(res)) {
+          (void) atom;
+          ++n;
+        }
+    return n;
+  };
+  std::vector<gemmi::SelectionMask> masks;
+  for (const char* cid : {"*", "A", "/1/B/10-20", "(ALA,SER)", "[C]", "CA,CB",
+                          "/2", "!B/*/C", ";b<20", "(!HOH)/N"}) {
+    gemmi::Selection sel(cid);
+    gemmi::SelectionMask mask(sel, model);
+    CHECK(mask.count() == count_selected(sel));
+    size_t n = 0;
+    mask.for_each(model, [&](gemmi::Chain& chain, gemmi::Residue& res, gemmi::Atom& atom) {
+      CHECK(sel.matches(gemmi::CRA{&chain, &res, &atom}));
+      ++n;
+    });
+    CHECK(n == mask.count());
+    gemmi::Model copied = mask.copy_selection(model);
+    CHECK(gemmi::SelectionMask::count_atoms(copied) == n);
+    gemmi::Model removed = model;
+    mask.remove_not_selected(removed);
+    CHECK(gemmi::SelectionMask::count_atoms(removed) == n);
+    gemmi::Model removed2 = model;
+    mask.remove_selected(removed2);
+    CHECK(gemmi::SelectionMask::count_atoms(removed2) + n == mask.size());
+    masks.push_back(mask);
+  }
+  CHECK(masks[0].count() == masks[0].size());
+  CHECK(!masks[6].any());
+  CHECK((masks[3] & masks[4]).count() + (masks[3] & ~masks[4]).count() == masks[3].count());
+  CHECK((masks[3] | masks[4]).count() + (masks[3] & masks[4]).count()
+        == masks[3].count() + masks[4].count());
+  CHECK((~masks[1] | masks[1]) == masks[0]);
+  CHECK((masks[5] ^ masks[5]).count() == 0);
+}
+
+TEST_CASE("copy_atoms_to_arrays") {
+  gemmi::Model model(1);
+  for (const char* chain_name : {"A", "B"}) {
+    model.chains.emplace_back(chain_name);
+    for (int i = 0; i < 3; ++i) {
+      gemmi::Residue res;
+      for (int j = 0; j <= i; ++j) {
+        gemmi::Atom atom;
+        atom.pos = gemmi::Position(i, j, chain_name[0]);
+        atom.b_iso = float(10 * i + j);
+        atom.occ = 0.5f;
+        atom.element = j == 0 ? gemmi::El::N : gemmi::El::C;
+        res.atoms.push_back(atom);
+      }
+      model.chains.back().residues.push_back(res);
+    }
+  }
+  const size_t n = 12;
+  std::vector<double> pos(3 * n);
+  std::vector<float> b_iso(n), occ(n);
+  std::vector<uint8_t> element(n);
+  gemmi::AtomArrays arrays;
+  arrays.pos = pos.data();
+  arrays.b_iso = b_iso.data();
+  arrays.occ = occ.data();
+  arrays.element = element.data();
+  CHECK(gemmi::copy_atoms_to_arrays(model, arrays) == n);
+  CHECK(pos[3*4+0] == 2.);
+  CHECK(pos[3*4+1] == 1.);
+  CHECK(pos[3*4+2] == 'A');
+  CHECK(pos[3*11+2] == 'B');
+  CHECK(b_iso[5] == 22.f);
+  CHECK(occ[7] == 0.5f);
+  CHECK(element[0] == 7);
+  CHECK(element[5] == 6);
+  for (double& x : pos)
+    x += 1.;
+  gemmi::AtomArrays in;
+  in.pos = pos.data();
+  gemmi::copy_arrays_to_atoms(in, n, model);
+  CHECK(model.chains[1].residues[2].atoms[2].pos.x == 3.);
+  CHECK(model.chains[1].residues[2].atoms[2].b_iso == 22.f);
+  CHECK_THROWS(gemmi::copy_arrays_to_atoms(in, n - 1, model));
+}
+
+TEST_CASE("Profiler") {
+  gemmi::Profiler& profiler = gemmi::Profiler::instance();
+  profiler.clear();
+  { gemmi::ProfileScope scope("not.recorded"); }
+  profiler.enable();
+  for (int i = 0; i < 3; ++i) {
+    gemmi::ProfileScope scope("test.scope");
+    profiler.add_count("test.count", 5);
+  }
+  profiler.enable(false);
+  { gemmi::ProfileScope scope("not.recorded"); }
+  std::vector<gemmi::Profiler::Event> events = profiler.events();
+  CHECK(events.size() == 3);
+  for (const gemmi::Profiler::Event& event : events) {
+    CHECK(std::string(event.name) == "test.scope");
+    CHECK(event.duration_ns >= 0);
+  }
+  CHECK(profiler.counters().at("test.count") == 15);
+  std::string summary = profiler.summary_json();
+  CHECK(summary.find("\"test.scope\": {\"calls\": 3,") != std::string::npos);
+  CHECK(summary.find("\"test.count\": 15") != std::string::npos);
+  CHECK(summary.find("not.recorded") == std::string::npos);
+  std::string trace = profiler.chrome_trace_json();
+  CHECK(trace.find("\"ph\": \"X\"") != std::string::npos);
+  CHECK(trace.find("\"args\": {\"value\": 15}") != std::string::npos);
+  profiler.clear();
+  CHECK(profiler.events().empty());
+  CHECK(profiler.counters().empty());
+}
+
+TEST_CASE("read_structure::binary_clears_save_doc") {
+  gemmi::Structure st;
+  st.name = "bin";
+  st.models.emplace_back(1);
+  const char* path = "cpptest_save_doc.bin";
+  gemmi::write_binary_structure(st, path);
+  gemmi::cif::Document doc;
+  // memory-mapped path
+  doc.blocks.emplace_back("stale");
+  CHECK(gemmi::read_structure_gz(path, gemmi::CoorFormat::Unknown, &doc).name == "bin");
+  CHECK(doc.blocks.empty());
+  // buffered path
+  doc.blocks.emplace_back("stale");
+  gemmi::read_structure(gemmi::MaybeGzipped(path), gemmi::CoorFormat::Binary, &doc);
+  CHECK(doc.blocks.empty());
+  // format detected from content
+  doc.blocks.emplace_back("stale");
+  gemmi::read_structure(gemmi::MaybeGzipped(path), gemmi::CoorFormat::Detect, &doc);
+  CHECK(doc.blocks.empty());
+  std::remove(path);
+}
@@ -47,6 +47,14 @@ class TestAlignment(unittest.TestCase):
         # BioPython equivalent is:
         # pairwise2.align.globalds(seq1.seq, seq2.seq, blosum62, -10, -1)
         self.assertEqual(result.score, 290)
+        for band_width in [20, 200]:
+            banded = gemmi.align_string_sequences(hba_seq, hbb_seq, [],
+                                                  blosum62, band_width)
+            self.assertEqual(banded.score, 290)
+            self.assertEqual(banded.cigar_str(), result.cigar_str())
+        banded = gemmi.align_string_sequences(hba_seq, hbb_seq, [],
+                                              blosum62, band_width=0)
+        self.assertLess(banded.score, 290)
 
     def test_assign_best_sequences(self):
         st = gemmi.read_structure(full_path('1lzh.pdb.gz'))
@@ -79,5 +87,28 @@ class TestAlignment(unittest.TestCase):
         for s in [s1, s2, s3]:
             self.assertAlmostEqual(s.transform.vec.y, 17.0, places=1)
 
+    def test_qcp_ensemble(self):
+        model = gemmi.read_structure(full_path('4oz7.pdb'))[0]
+        atoms = ['N', 'CA', 'C', 'O']
+        confs = [[res.sole_atom(a).pos for a in atoms]
+                 for chain in model for res in chain.get_polymer()
+                 if all(res.find_atom(a, '*') for a in atoms)]
+        ens = gemmi.QcpEnsemble(len(atoms))
+        for pos in confs:
+            ens.add(pos)
+        self.assertEqual(len(ens), len(confs))
+        matrix = ens.rmsd_matrix(threads=2)
+        to_ref = ens.rmsd_to_reference(1)
+        n = len(confs)
+        self.assertEqual(len(matrix), n * (n - 1) // 2)
+        k = 0
+        for i in range(n):
+            rmsd = gemmi.superpose_positions(confs[1], confs[i]).rmsd
+            self.assertAlmostEqual(to_ref[i], rmsd, places=6)
+            for j in range(i + 1, n):
+                rmsd = gemmi.superpose_positions(confs[i], confs[j]).rmsd
+                self.assertAlmostEqual(matrix[k], rmsd, places=6)
+                k += 1
+
 if __name__ == '__main__':
     unittest.main()
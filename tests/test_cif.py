@@ -441,6 +441,11 @@ class TestDictionary(unittest.TestCase):
         ddl.validate_cif(doc)
         expected.insert(-1, 'string:15 [b2] value out of expected range: 10.5')
         self.assertEqual(msg_list, expected)
+        # columns checked in parallel give the same messages in the same order
+        msg_list = []
+        ddl.n_threads = 3
+        ddl.validate_cif(doc)
+        self.assertEqual(msg_list, expected)
 
 if __name__ == '__main__':
     unittest.main()
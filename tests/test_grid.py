@@ -127,6 +127,15 @@ class TestFloatGrid(unittest.TestCase):
         values = moving_grid.interpolate_position_array(positions)
         self.assertAlmostEqual(values[0], 1.0)
         self.assertAlmostEqual(values[1], 1.0)
+        # the batch version should agree with interpolate_value()
+        positions = numpy.array([[0.3, 1.7, 9.2], [-4.1, 5.5, 12.9]])
+        for order in (0, 1, 3):
+            values = moving_grid.interpolate_position_array(positions,
+                                                            order=order)
+            for xyz, value in zip(positions, values):
+                pos = gemmi.Position(*xyz)
+                expected = moving_grid.interpolate_value(pos, order=order)
+                self.assertAlmostEqual(value, expected, places=5)
 
         # Test map morphing
         # A simple single solid translation of the cell, limited to two points
@@ -253,5 +262,20 @@ class TestCcp4Map(unittest.TestCase):
         volume = span[0] * span[1] * span[2]
         self.assertAlmostEqual(orig_point_count / m.grid.point_count, volume)
 
+    def test_distance_transform(self):
+        grid = gemmi.Int8Grid(10, 12, 14)
+        grid.set_unit_cell(gemmi.UnitCell(20, 24, 28, 90, 90, 90))
+        grid.set_value(1, 2, 3, 1)
+        dist = grid.distance_transform(threshold=1, threads=2)
+        self.assertEqual(dist.get_value(1, 2, 3), 0)
+        self.assertAlmostEqual(dist.get_value(2, 2, 3), 2.0)
+        self.assertAlmostEqual(dist.get_value(-1, 1, 5),
+                               math.sqrt(4**2 + 2**2 + 4**2))
+        # the farthest point, on the other side of the periodic cell
+        self.assertAlmostEqual(dist.get_value(6, 8, 10),
+                               math.sqrt(10**2 + 12**2 + 14**2), places=5)
+        limited = grid.distance_transform(threshold=1, max_dist=3)
+        self.assertEqual(limited.get_value(6, 8, 10), float('inf'))
+
 if __name__ == '__main__':
     unittest.main()
@@ -7,7 +7,7 @@ import pickle
 import unittest
 
 import gemmi
-from common import full_path, get_path_for_tempfile
+from common import full_path, get_path_for_tempfile, numpy
 try:
     from Bio import PDB
 except ImportError:
@@ -348,9 +348,13 @@ class TestMol(unittest.TestCase):
         self.assertEqual(a1.count_atom_sites(), site_count)
         a2 = gemmi.make_assembly(st.assemblies[1], model, how)
         self.assertEqual(a2.count_atom_sites(), site_count * 3)
+        a3 = gemmi.make_assembly(st.assemblies[1], model, how)
         gemmi.merge_atoms_in_expanded_model(a2, gemmi.UnitCell())
         # 3 atoms are on a 3-fold rotation axis
         self.assertEqual(a2.count_atom_sites(), (site_count - 3) * 3 + 3 * 1)
+        gemmi.merge_atoms_in_expanded_model(a3, gemmi.UnitCell(), threads=3)
+        self.assertEqual([(c.atom.name, c.atom.pos.tolist(), c.atom.occ) for c in a3.all()],
+                         [(c.atom.name, c.atom.pos.tolist(), c.atom.occ) for c in a2.all()])
 
     def test_software_category(self):
         doc = gemmi.cif.read_file(full_path('3dg1_final.cif'))
@@ -443,6 +447,20 @@ class TestMol(unittest.TestCase):
         st = gemmi.read_structure(full_path('1pfe.json'))
         self.check_1pfe(st)
 
+    def test_read_structures(self):
+        paths = [full_path(name) for name in ['1orc.pdb', '1pfe.json',
+                                              '5i55.cif', '1orc.pdb']]
+        structures = gemmi.read_structures(paths, threads=3)
+        self.assertEqual(len(structures), len(paths))
+        for path, st in zip(paths, structures):
+            expected = gemmi.read_structure(path)
+            self.assertEqual(st.name, expected.name)
+            self.assertEqual(st.make_pdb_string(), expected.make_pdb_string())
+        docs = gemmi.cif.read_files([full_path('1pfe.cif.gz'), paths[2]])
+        self.assertEqual([d[0].name for d in docs], ['1PFE', '5I55'])
+        with self.assertRaises((RuntimeError, IOError)):
+            gemmi.read_structures([paths[0], full_path('nonexistent.pdb')])
+
     def test_read_1orc(self):
         st = gemmi.read_structure(full_path('1orc.pdb'))
         self.assertEqual(st.resolution, 1.54)
@@ -795,6 +813,30 @@ class TestMol(unittest.TestCase):
         st.remove_empty_chains()
         self.assertEqual([cra.atom.name for cra in model.all()], expected)
 
+    @unittest.skipIf(numpy is None, "NumPy not installed.")
+    def test_atom_arrays(self):
+        st = gemmi.read_structure(full_path('1orc.pdb'))
+        model = st[0]
+        atoms = [cra.atom for cra in model.all()]
+        pos = model.get_positions()
+        self.assertEqual(pos.shape, (len(atoms), 3))
+        self.assertEqual(pos[10].tolist(), atoms[10].pos.tolist())
+        arrays = model.get_atom_arrays()
+        self.assertTrue(numpy.array_equal(arrays['pos'], pos))
+        self.assertTrue(numpy.array_equal(arrays['b_iso'], model.get_b_isos()))
+        self.assertEqual(arrays['occ'].tolist(),
+                         [numpy.float32(a.occ) for a in atoms])
+        self.assertEqual(model.get_atomic_numbers().tolist(),
+                         [a.element.atomic_number for a in atoms])
+        model.set_positions(pos + [1.0, 0.0, -1.0])
+        x, y, z = atoms[10].pos.tolist()
+        self.assertAlmostEqual(x, pos[10][0] + 1.0)
+        self.assertAlmostEqual(z, pos[10][2] - 1.0)
+        model.set_b_isos(numpy.full(len(atoms), 30, dtype=numpy.float32))
+        self.assertEqual(model[0][0][0].b_iso, 30)
+        with self.assertRaises(RuntimeError):
+            model.set_occupancies(numpy.ones(3, dtype=numpy.float32))
+
     def test_different_altloc_order(self):
         st = gemmi.read_pdb_string(UNORDERED_ALTLOC_FRAGMENT)
         chain = st[0]['A']
@@ -843,6 +885,34 @@ class TestMol(unittest.TestCase):
         self.assertEqual([ch.name for ch in bio],
                          [x+'1' for x in ch_names] + [x+'2' for x in ch_names])
 
+    def test_instanced_assembly(self):
+        st = gemmi.read_structure(full_path('1pfe.cif.gz'),
+                                  merge_chain_parts=False)
+        model = st[0]
+        how = gemmi.HowToNameCopiedChain.Short
+        bio = gemmi.make_assembly(st.assemblies[0], model, how)
+        ia = gemmi.make_instanced_assembly(st.assemblies[0], model, how)
+        self.assertEqual(len(ia.instances), 2)
+        self.assertEqual([cc.name for cc in ia.chains], [ch.name for ch in bio])
+        self.assertEqual(ia.atom_count(), bio.count_atom_sites())
+        positions = [cra.atom.pos for cra in bio.all()]
+        for threads in [1, 3]:
+            for p1, p2 in zip(ia.get_positions(threads), positions):
+                self.assertTrue(p1.approx(p2, 1e-9))
+            model2 = ia.to_model(threads)
+            self.assertEqual([ch.name for ch in model2], [ch.name for ch in bio])
+            self.assertAlmostEqual(model2.calculate_mass(), bio.calculate_mass())
+        bio_st = gemmi.Structure()
+        bio_st.add_model(bio)
+        opt = gemmi.PdbWriteOptions(minimal=True)
+        self.assertEqual(gemmi.make_assembly_pdb_string(ia, opt),
+                         bio_st.make_pdb_string(opt))
+        ns = ia.make_neighbor_search(5)
+        pos = positions[100]
+        marks = ns.find_atoms(pos, '\0', radius=3)
+        bio_ns = gemmi.NeighborSearch(bio, gemmi.UnitCell(), 5).populate()
+        self.assertEqual(len(marks), len(bio_ns.find_atoms(pos, '\0', radius=3)))
+
     def test_assembly_naming(self):
         st = gemmi.read_structure(full_path('4oz7.pdb'))
         model = st[0]
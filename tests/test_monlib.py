@@ -1,6 +1,8 @@
 #!/usr/bin/env python
 
 import os
+import shutil
+import tempfile
 import unittest
 import gemmi
 
@@ -108,6 +110,26 @@ class TestChemComp(unittest.TestCase):
         self.assertEqual([aid.atom for aid in result],
                          ['FE', 'ND', 'C4D', 'C3D', 'C2D', 'CMD'])
 
+    def test_indexed_ccd(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            path = os.path.join(tmpdir, 'components.cif')
+            with open(path, 'w') as out:
+                for name in ['HEM.cif', 'HEN.cif']:
+                    with open(full_path(name)) as f:
+                        out.write(f.read())
+                    # data_ in a text field is not a block
+                    out.write('data_TXT\n_x.text\n;\ndata_FAKE\n;\n')
+            for _ in range(2):  # the index is created and then reused
+                ccd = gemmi.IndexedCcd(path)
+                self.assertEqual(ccd.names, ['HEM', 'TXT', 'HEN'])
+                self.assertTrue(os.path.exists(path + '.idx'))
+                self.assertEqual(len(ccd['HEM'].atoms), 75)
+                self.assertEqual(len(ccd.find('HEN').rt.bonds), 45)
+                self.assertIsNone(ccd.find('FAKE'))
+                self.assertEqual(ccd.cache_size(), 2)
+                block = ccd.read_block('TXT')
+                self.assertEqual(block.find_value('_x.text'), ';\ndata_FAKE\n;')
+
 class TestMonLib(unittest.TestCase):
     def test_path(self):
         path = full_path('')
@@ -115,6 +137,26 @@ class TestMonLib(unittest.TestCase):
         self.assertEqual(monlib.path('ALA'), path + "a/ALA.cif")
         self.assertEqual(monlib.path('CON'), path + "c/CON_CON.cif")
 
+    def test_monomer_lib_cache(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            # a minimal "monomer library"
+            shutil.copytree(full_path('list'), os.path.join(tmpdir, 'list'))
+            os.makedirs(os.path.join(tmpdir, 'h'))
+            shutil.copy(full_path('ener_lib.cif'), tmpdir)
+            shutil.copy(full_path('HEM.cif'), os.path.join(tmpdir, 'h'))
+            cache_path = os.path.join(tmpdir, 'monlib.cache')
+            def read(**kwargs):
+                monlib = gemmi.MonLib()
+                ok = monlib.read_monomer_lib(tmpdir, ['HEM'], **kwargs)
+                self.assertTrue(ok)
+                cc = monlib.monomers['HEM']
+                return (len(cc.atoms), len(cc.rt.bonds), cc.group,
+                        sorted(monlib.links), sorted(monlib.modifications))
+            expected = read()
+            self.assertEqual(read(cache_path=cache_path), expected)
+            self.assertTrue(os.path.exists(cache_path))
+            self.assertEqual(read(cache_path=cache_path), expected)
+
     @unittest.skipIf(os.getenv('CLIBD_MON') is None, "$CLIBD_MON not defined.")
     def test_read_monomer_lib(self):
         st = gemmi.read_structure(full_path('4oz7.pdb'))
@@ -132,6 +174,22 @@ class TestMonLib(unittest.TestCase):
         # RuntimeError: Placing of hydrogen bonded to A/22W 6/N failed:
         # Missing angle restraint HN-N-C.
 
+    @unittest.skipIf(os.getenv('CLIBD_MON') is None, "$CLIBD_MON not defined.")
+    def test_prepare_topology_threads(self):
+        def prepare(threads):
+            st = gemmi.read_structure(full_path('4oz7.pdb'))
+            monlib = gemmi.MonLib()
+            monlib.read_monomer_lib(os.environ['CLIBD_MON'],
+                                    st[0].get_all_residue_names())
+            monlib.update_old_atom_names(st)
+            topo = gemmi.prepare_topology(st, monlib, model_index=0,
+                                          h_change=gemmi.HydrogenChange.Shift,
+                                          threads=threads)
+            restr = [[(a.name, a.pos.tolist()) for a in r.atoms]
+                     for r in list(topo.bonds) + list(topo.angles)]
+            return restr, st.make_pdb_string()
+        self.assertEqual(prepare(1), prepare(3))
+
 
 if __name__ == '__main__':
     unittest.main()
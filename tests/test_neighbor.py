@@ -112,6 +112,23 @@ class TestContactSearch(unittest.TestCase):
                             or r.partner1.chain is not r.partner2.chain
                             for r in results))
 
+    def test_neighbor_search_cache(self):
+        st = gemmi.read_structure(full_path('4oz7.pdb'))
+        st.setup_entities()
+        cache = gemmi.NeighborSearchCache(5)
+        cs = gemmi.ContactSearch(4.0)
+        self.assertEqual(len(cs.find_contacts(cache.get(st))), 607)
+        self.assertEqual(len(cs.find_contacts(cache.get(st))), 607)
+        self.assertEqual(cache.build_count, 1)
+        cache.get(st, min_radius=6)  # larger radius requested
+        self.assertEqual(cache.build_count, 2)
+        st[0][0][0][0].pos.x += 10  # changes in the model are not tracked
+        cache.get(st)
+        self.assertEqual(cache.build_count, 2)
+        cache.invalidate()
+        cache.get(st)
+        self.assertEqual(cache.build_count, 3)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -21,13 +21,16 @@
 #include <gemmi/asudata.hpp>
 #include <gemmi/asumask.hpp>
 #include <gemmi/atof.hpp>
+#include <gemmi/atomarr.hpp>
 #include <gemmi/atox.hpp>
 #include <gemmi/bessel.hpp>
+#include <gemmi/binfile.hpp>
 #include <gemmi/binner.hpp>
 #include <gemmi/blob.hpp>
 #include <gemmi/bond_idx.hpp>
 #include <gemmi/c4322.hpp>
 #include <gemmi/calculate.hpp>
+#include <gemmi/ccd.hpp>
 #include <gemmi/ccp4.hpp>
 #include <gemmi/cellred.hpp>
 #include <gemmi/chemcomp.hpp>
@@ -41,6 +44,7 @@
 #include <gemmi/dirwalk.hpp>
 #include <gemmi/ecalc.hpp>
 #include <gemmi/eig3.hpp>
+#include <gemmi/edt.hpp>
 #include <gemmi/elem.hpp>
 #include <gemmi/enumstr.hpp>
 #include <gemmi/fail.hpp>
@@ -76,10 +80,12 @@
 #include <gemmi/neighbor.hpp>
 #include <gemmi/neutron92.hpp>
 #include <gemmi/numb.hpp>
+#include <gemmi/parallel.hpp>
 #include <gemmi/pdb.hpp>
 #include <gemmi/pdb_id.hpp>
 #include <gemmi/pirfasta.hpp>
 #include <gemmi/polyheur.hpp>
+#include <gemmi/profile.hpp>
 #include <gemmi/qcp.hpp>
 #include <gemmi/read_cif.hpp>
 #include <gemmi/recgrid.hpp>